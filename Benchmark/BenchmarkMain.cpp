@@ -0,0 +1,775 @@
+/**
+*
+* Benchmark of the CPU side of terrain generation, written as one JSON report.
+* Covers the noise functions, the specialized fBm kernels, the grid sampler, the vertex pass at several grid sizes and layouts, the cost of the
+* analytic normals, the index and adjacency passes, the staging work before the GL upload,
+* and how the parallel passes scale with the thread count. Ends with two checks: that a tile at a negative origin
+* samples the noise at its own coordinates, and that every layout gets the same triangle adjacency.
+* The exit code is 1 if either fails.
+*
+* Options:
+*   --out FILE               write the report to FILE instead of stdout
+*   --sizes 256,600,2048     grid sizes (vertices per side), default 256,600,2048,4096
+*   --threads 1,2,4          thread counts of the scaling curves, default doubling up to every hardware thread
+*   --scaling-size N         grid size of the scaling curves, default 2048
+*   --runs N                 timed runs per measurement, default 3
+*
+**/
+
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <thread>
+#include <cstdlib>
+#include "../CS5610 Project 2/Mesh/Mesh.h"
+#include "../CS5610 Project 2/Noise/PerlinNoise.h"
+#include "../CS5610 Project 2/Noise/SimplexNoise.h"
+#include "../CS5610 Project 2/Noise/NoiseEngine.h"
+#include "../CS5610 Project 2/Noise/FbmNoise.h"
+#include "../CS5610 Project 2/Terrain/HeightQuadtree.h"
+#include "../CS5610 Project 2/Terrain/TerrainCuller.h"
+#include "JsonWriter.h"
+#include "Measure.h"
+
+// reaches into Mesh for the private noise functions and the cached adjacency
+class MeshBenchmark
+{
+public:
+	static double perlin(Mesh& mesh, double x, double y, double z) { return mesh.perlin(x, y, z); }
+	static float noiseCallback(Mesh& mesh, float x, float y, float z) { return mesh.noise_callback(x, y, z, 6, 0.5); }
+	static void noiseRow(Mesh& mesh, const float* x, float z, unsigned int count, float* out, float* outDx, float* outDz)
+	{
+		mesh.noise_row(x, 1, z, count, 6, 0.5f, 4, out, outDx, outDz);
+	}
+	static void forgetTriangleAdjacency(Mesh& mesh)
+	{
+		mesh.triangle_adjacency.offsets.clear();
+		mesh.triangle_adjacency.triangles.clear();
+	}
+};
+
+struct Options
+{
+	std::string outPath;
+	std::vector<unsigned int> sizes = { 256, 600, 2048, 4096 };
+	std::vector<unsigned int> threads;
+	unsigned int scalingSize = 2048;
+	unsigned int runs = 3;
+};
+
+// keeps the compiler from dropping noise results nobody reads
+volatile float noiseSink;
+
+std::vector<unsigned int> parseList(const char* text);
+bool parseOptions(int argc, char* argv[], Options& options);
+void writeTimes(JsonWriter& json, const char* name, const RunTimes& times);
+void benchmarkNoise(JsonWriter& json, const Options& options);
+void benchmarkFbm(JsonWriter& json, const Options& options);
+void benchmarkGrid(JsonWriter& json, const Options& options);
+void benchmarkNormals(JsonWriter& json, const Options& options);
+void benchmarkGenerateVertices(JsonWriter& json, const Options& options);
+void benchmarkIndices(JsonWriter& json, const Options& options);
+void benchmarkStaging(JsonWriter& json, const Options& options);
+void benchmarkThreadScaling(JsonWriter& json, const Options& options);
+bool checkNegativeOrigin(JsonWriter& json);
+bool checkAdjacencyLayouts(JsonWriter& json);
+const char* layoutName(TerrainVertexLayout layout);
+
+
+int main(int argc, char* argv[])
+{
+	Options options;
+	if (!parseOptions(argc, argv, options)) { return 1; }
+
+	std::ofstream file;
+	if (!options.outPath.empty())
+	{
+		file.open(options.outPath);
+		if (!file)
+		{
+			std::cerr << "Could not write " << options.outPath << std::endl;
+			return 1;
+		}
+	}
+	JsonWriter json(options.outPath.empty() ? std::cout : file);
+
+	json.beginObject();
+	json.field("hardwareThreads", std::thread::hardware_concurrency());
+	json.field("simdLevel", PerlinNoise::simdLevelName(PerlinNoise::simdLevel()));
+	json.field("runs", options.runs);
+
+	json.key("noise");
+	benchmarkNoise(json, options);
+	json.key("fbm");
+	benchmarkFbm(json, options);
+	json.key("grid");
+	benchmarkGrid(json, options);
+	json.key("normals");
+	benchmarkNormals(json, options);
+	json.key("generateVertices");
+	benchmarkGenerateVertices(json, options);
+	json.key("indices");
+	benchmarkIndices(json, options);
+	json.key("staging");
+	benchmarkStaging(json, options);
+	json.key("threadScaling");
+	benchmarkThreadScaling(json, options);
+	json.key("negativeOrigin");
+	bool originMatches = checkNegativeOrigin(json);
+	json.key("adjacencyLayouts");
+	bool adjacencyMatches = checkAdjacencyLayouts(json);
+
+	json.field("peakRssBytes", peakResidentBytes());
+	json.endObject();
+	if (!originMatches)
+	{
+		std::cerr << "A tile at a negative origin does not match the noise at its coordinates" << std::endl;
+	}
+	if (!adjacencyMatches)
+	{
+		std::cerr << "The triangle adjacency differs between vertex layouts" << std::endl;
+	}
+	if (!originMatches || !adjacencyMatches) { return 1; }
+	return 0;
+}
+
+
+/**
+*
+* Comma separated positive integers, e.g. 256,600,2048
+*
+**/
+std::vector<unsigned int> parseList(const char* text)
+{
+	std::vector<unsigned int> list;
+	for (const char* c = text; *c != '\0';)
+	{
+		char* end;
+		long number = strtol(c, &end, 10);
+		if (end == c) { break; }
+		if (number > 0) { list.push_back((unsigned int)number); }
+		c = *end == ',' ? end + 1 : end;
+	}
+	return list;
+}
+
+/**
+*
+* Read the command line, see the top of this file
+*
+* returns false on an unknown option
+*
+**/
+bool parseOptions(int argc, char* argv[], Options& options)
+{
+	for (int i = 1; i + 1 < argc; i += 2)
+	{
+		std::string arg = argv[i];
+		const char* value = argv[i + 1];
+		if (arg == "--out") { options.outPath = value; }
+		else if (arg == "--sizes") { options.sizes = parseList(value); }
+		else if (arg == "--threads") { options.threads = parseList(value); }
+		else if (arg == "--scaling-size") { options.scalingSize = std::max(2, atoi(value)); }
+		else if (arg == "--runs") { options.runs = std::max(1, atoi(value)); }
+		else
+		{
+			std::cerr << "Unknown option " << arg << std::endl;
+			return false;
+		}
+	}
+	if (argc % 2 == 0)
+	{
+		std::cerr << "Missing value of " << argv[argc - 1] << std::endl;
+		return false;
+	}
+
+	if (options.threads.empty())
+	{
+		unsigned int hardware = std::max(1u, std::thread::hardware_concurrency());
+		for (unsigned int t = 1; t < hardware; t *= 2) { options.threads.push_back(t); }
+		options.threads.push_back(hardware);
+	}
+	return true;
+}
+
+/**
+*
+* Run times of one measurement as {"min", "median", "mean", "runs"}
+*
+**/
+void writeTimes(JsonWriter& json, const char* name, const RunTimes& times)
+{
+	json.key(name);
+	json.beginObject();
+	json.field("min", times.min);
+	json.field("median", times.median);
+	json.field("mean", times.mean);
+	json.field("runs", times.runs);
+	json.endObject();
+}
+
+/**
+*
+* Samples per second of the scalar noise in Mesh, and of PerlinNoise's batches on every instruction set the CPU has,
+* once with the permutation table and once with the integer hash, then of SimplexNoise's batches, and of the six
+* octave rows of Mesh::noise_row() with every noise engine
+*
+**/
+void benchmarkNoise(JsonWriter& json, const Options& options)
+{
+	std::cerr << "noise" << std::endl;
+	const unsigned int count = 1 << 20;
+	// spread over many lattice cells, like the rows of a large map
+	std::vector<float> xs(count), ys(count, 1.0f), zs(count), out(count), dx(count), dy(count), dz(count);
+	for (unsigned int i = 0; i < count; i++)
+	{
+		xs[i] = (i % 1024) * 0.0137f;
+		zs[i] = (i / 1024) * 0.0137f;
+	}
+	Mesh mesh;
+
+	json.beginArray();
+	const char* hashing = PerlinNoise::hashingName(PerlinNoise::Hashing::Permutation);
+	auto entry = [&](const char* function, const char* simd, unsigned int samples, const RunTimes& times) {
+		json.beginObject();
+		json.field("function", function);
+		json.field("simd", simd);
+		json.field("hashing", hashing);
+		json.field("samples", samples);
+		writeTimes(json, "ms", times);
+		json.field("samplesPerSecond", samples / (times.median / 1000.0));
+		json.endObject();
+	};
+
+	entry("Mesh::perlin", "scalar", count, timeRuns(options.runs, [&]() {
+		double sum = 0;
+		for (unsigned int i = 0; i < count; i++) { sum += MeshBenchmark::perlin(mesh, xs[i], ys[i], zs[i]); }
+		noiseSink = (float)sum;
+	}));
+	// six octaves per call, counted as one sample
+	entry("Mesh::noise_callback", "scalar", count, timeRuns(options.runs, [&]() {
+		float sum = 0;
+		for (unsigned int i = 0; i < count; i++) { sum += MeshBenchmark::noiseCallback(mesh, xs[i] / 64, ys[i], zs[i] / 64); }
+		noiseSink = sum;
+	}));
+
+	PerlinNoise::SimdLevel detected = PerlinNoise::detectSimdLevel();
+	PerlinNoise::SimdLevel active = PerlinNoise::simdLevel();
+	PerlinNoise::Hashing activeHashing = PerlinNoise::hashing();
+	for (PerlinNoise::Hashing mode : { PerlinNoise::Hashing::Permutation, PerlinNoise::Hashing::Integer })
+	{
+		PerlinNoise::setHashing(mode);
+		hashing = PerlinNoise::hashingName(mode);
+		entry("PerlinNoise::sample", "scalar", count, timeRuns(options.runs, [&]() {
+			float sum = 0;
+			for (unsigned int i = 0; i < count; i++) { sum += PerlinNoise::sample(xs[i], ys[i], zs[i]); }
+			noiseSink = sum;
+		}));
+
+		for (PerlinNoise::SimdLevel level : { PerlinNoise::SimdLevel::Scalar, PerlinNoise::SimdLevel::SSE41,
+			PerlinNoise::SimdLevel::AVX2, PerlinNoise::SimdLevel::AVX512 })
+		{
+			if (level > detected) { break; }
+			PerlinNoise::setSimdLevel(level);
+			const char* simd = PerlinNoise::simdLevelName(level);
+			entry("PerlinNoise::sampleBatch", simd, count, timeRuns(options.runs, [&]() {
+				PerlinNoise::sampleBatch(&xs[0], &ys[0], &zs[0], &out[0], count);
+				noiseSink = out[count / 2];
+			}));
+			entry("PerlinNoise::sampleBatchGradient", simd, count, timeRuns(options.runs, [&]() {
+				PerlinNoise::sampleBatchGradient(&xs[0], &ys[0], &zs[0], &out[0], &dx[0], &dy[0], &dz[0], count);
+				noiseSink = out[count / 2];
+			}));
+		}
+	}
+	PerlinNoise::setHashing(activeHashing);
+
+	// OpenSimplex2 always hashes its corners with integer arithmetic
+	hashing = PerlinNoise::hashingName(PerlinNoise::Hashing::Integer);
+	for (PerlinNoise::SimdLevel level : { PerlinNoise::SimdLevel::Scalar, PerlinNoise::SimdLevel::SSE41,
+		PerlinNoise::SimdLevel::AVX2, PerlinNoise::SimdLevel::AVX512 })
+	{
+		if (level > detected) { break; }
+		PerlinNoise::setSimdLevel(level);
+		const char* simd = PerlinNoise::simdLevelName(level);
+		entry("SimplexNoise::sampleBatch2D", simd, count, timeRuns(options.runs, [&]() {
+			SimplexNoise::sampleBatch2D(&xs[0], &zs[0], &out[0], count);
+			noiseSink = out[count / 2];
+		}));
+		entry("SimplexNoise::sampleBatchGradient2D", simd, count, timeRuns(options.runs, [&]() {
+			SimplexNoise::sampleBatchGradient2D(&xs[0], &zs[0], &out[0], &dx[0], &dz[0], count);
+			noiseSink = out[count / 2];
+		}));
+		entry("SimplexNoise::sampleBatch3D", simd, count, timeRuns(options.runs, [&]() {
+			SimplexNoise::sampleBatch3D(&xs[0], &ys[0], &zs[0], &out[0], count);
+			noiseSink = out[count / 2];
+		}));
+		entry("SimplexNoise::sampleBatchGradient3D", simd, count, timeRuns(options.runs, [&]() {
+			SimplexNoise::sampleBatchGradient3D(&xs[0], &ys[0], &zs[0], &out[0], &dx[0], &dy[0], &dz[0], count);
+			noiseSink = out[count / 2];
+		}));
+	}
+	PerlinNoise::setSimdLevel(active);
+
+	// whole rows of six octaves, as the vertex pass sums them, counted as one sample per vertex
+	hashing = PerlinNoise::hashingName(activeHashing);
+	const char* simd = PerlinNoise::simdLevelName(active);
+	const unsigned int rowWidth = 1024;
+	for (const NoiseEngine* engine : { &NoiseEngine::perlin(), &NoiseEngine::simplex2D(), &NoiseEngine::simplex3D() })
+	{
+		mesh.setNoiseEngine(engine);
+		std::string function = std::string("Mesh::noise_row ") + engine->name();
+		entry(function.c_str(), simd, count, timeRuns(options.runs, [&]() {
+			for (unsigned int r = 0; r < count / rowWidth; r++)
+			{
+				MeshBenchmark::noiseRow(mesh, &xs[r * rowWidth], zs[r * rowWidth], rowWidth, &out[r * rowWidth], &dx[0], &dz[0]);
+			}
+			noiseSink = out[count / 2];
+		}));
+	}
+	json.endArray();
+}
+
+/**
+*
+* Rows of fBm with the octave count we ship, summed octave by octave with runtime parameters
+* (NoiseEngine::fbmBatchGradientLoop()) against the FbmNoise kernel specialized for six octaves,
+* for every engine and instruction set. The persistence of 0.5 has its weights folded at compile time,
+* 0.45 shows the kernel with a runtime schedule.
+*
+**/
+void benchmarkFbm(JsonWriter& json, const Options& options)
+{
+	std::cerr << "fbm" << std::endl;
+	const unsigned int width = 1024;
+	const unsigned int rows = 256;
+	std::vector<float> xs(width), ys(width, 1.0f), zs(width), out(width), dx(width), dy(width), dz(width);
+	for (unsigned int c = 0; c < width; c++) { xs[c] = (float)c / width; }
+	double samples = (double)width * rows;
+
+	json.beginArray();
+	PerlinNoise::SimdLevel detected = PerlinNoise::detectSimdLevel();
+	PerlinNoise::SimdLevel active = PerlinNoise::simdLevel();
+	for (PerlinNoise::SimdLevel level : { PerlinNoise::SimdLevel::Scalar, PerlinNoise::SimdLevel::SSE41,
+		PerlinNoise::SimdLevel::AVX2, PerlinNoise::SimdLevel::AVX512 })
+	{
+		if (level > detected) { break; }
+		PerlinNoise::setSimdLevel(level);
+		for (const NoiseEngine* engine : { &NoiseEngine::perlin(), &NoiseEngine::simplex2D(), &NoiseEngine::simplex3D() })
+		{
+			for (float persistence : { 0.5f, 0.45f })
+			{
+				FbmParams fbm;
+				fbm.persistence = persistence;
+				auto rowsOf = [&](bool specialized) {
+					return timeRuns(options.runs, [&]() {
+						for (unsigned int r = 0; r < rows; r++)
+						{
+							for (unsigned int c = 0; c < width; c++) { zs[c] = (float)r / width; }
+							if (specialized) { engine->fbmBatchGradient(&xs[0], &ys[0], &zs[0], &out[0], &dx[0], &dy[0], &dz[0], width, fbm); }
+							else { engine->fbmBatchGradientLoop(&xs[0], &ys[0], &zs[0], &out[0], &dx[0], &dy[0], &dz[0], width, fbm); }
+						}
+						noiseSink = out[width / 2];
+					});
+				};
+				RunTimes loop = rowsOf(false);
+				RunTimes specialized = rowsOf(true);
+
+				json.beginObject();
+				json.field("engine", engine->name());
+				json.field("simd", PerlinNoise::simdLevelName(level));
+				json.field("octaves", fbm.octaves);
+				json.field("persistence", persistence);
+				json.field("schedule", persistence == 0.5f ? "constant" : "runtime");
+				json.field("samples", (unsigned long long)samples);
+				writeTimes(json, "loopMs", loop);
+				writeTimes(json, "specializedMs", specialized);
+				json.field("speedup", loop.median / specialized.median);
+				json.endObject();
+			}
+		}
+	}
+	PerlinNoise::setSimdLevel(active);
+	json.endArray();
+}
+
+/**
+*
+* Rows of one grid sampled one by one with the fBm kernels, against the grid sampler of the Perlin engine
+* (NoiseEngine::gridSampler()), which hashes each lattice point once per row and walks the samples of a cell
+* with its coefficients. The single octave shows a low frequency, where a cell holds hundreds of samples.
+* The grid time includes setting up the sampler.
+*
+**/
+void benchmarkGrid(JsonWriter& json, const Options& options)
+{
+	std::cerr << "grid" << std::endl;
+	const unsigned int width = 1024;
+	const unsigned int rows = 256;
+	std::vector<float> xs(width), ys(width, 1.0f), zs(width), out(width), dx(width), dy(width), dz(width);
+	for (unsigned int c = 0; c < width; c++) { xs[c] = (float)c / width; }
+	double samples = (double)width * rows;
+	const NoiseEngine& engine = NoiseEngine::perlin();
+
+	json.beginArray();
+	PerlinNoise::SimdLevel detected = PerlinNoise::detectSimdLevel();
+	PerlinNoise::SimdLevel active = PerlinNoise::simdLevel();
+	PerlinNoise::Hashing activeHashing = PerlinNoise::hashing();
+	for (PerlinNoise::SimdLevel level : { PerlinNoise::SimdLevel::Scalar, PerlinNoise::SimdLevel::SSE41,
+		PerlinNoise::SimdLevel::AVX2, PerlinNoise::SimdLevel::AVX512 })
+	{
+		if (level > detected) { break; }
+		PerlinNoise::setSimdLevel(level);
+		for (PerlinNoise::Hashing hashing : { PerlinNoise::Hashing::Permutation, PerlinNoise::Hashing::Integer })
+		{
+			PerlinNoise::setHashing(hashing);
+			for (int octaves : { 6, 1 })
+			{
+				FbmParams fbm;
+				fbm.octaves = octaves;
+				RunTimes byRow = timeRuns(options.runs, [&]() {
+					for (unsigned int r = 0; r < rows; r++)
+					{
+						for (unsigned int c = 0; c < width; c++) { zs[c] = (float)r / width; }
+						engine.fbmBatchGradient(&xs[0], &ys[0], &zs[0], &out[0], &dx[0], &dy[0], &dz[0], width, fbm);
+					}
+					noiseSink = out[width / 2];
+				});
+				RunTimes grid = timeRuns(options.runs, [&]() {
+					std::unique_ptr<NoiseGridSampler> sampler = engine.gridSampler(&xs[0], width, 1.0f, fbm);
+					for (unsigned int r = 0; r < rows; r++)
+					{
+						sampler->sampleRow((float)r / width, &out[0], &dx[0], &dz[0]);
+					}
+					noiseSink = out[width / 2];
+				});
+
+				json.beginObject();
+				json.field("engine", engine.name());
+				json.field("simd", PerlinNoise::simdLevelName(level));
+				json.field("hashing", PerlinNoise::hashingName(hashing));
+				json.field("octaves", octaves);
+				json.field("samples", (unsigned long long)samples);
+				writeTimes(json, "rowMs", byRow);
+				writeTimes(json, "gridMs", grid);
+				json.field("speedup", byRow.median / grid.median);
+				json.endObject();
+			}
+		}
+	}
+	PerlinNoise::setSimdLevel(active);
+	PerlinNoise::setHashing(activeHashing);
+	json.endArray();
+}
+
+/**
+*
+* What the analytic normals add to the vertex pass: the six octave rows of Mesh::noise_row(), which sum the
+* noise derivatives along with the values, against the same octaves summed without derivatives
+*
+**/
+void benchmarkNormals(JsonWriter& json, const Options& options)
+{
+	std::cerr << "normals" << std::endl;
+	const unsigned int width = 2048;
+	const unsigned int rows = 256;
+	std::vector<float> rowX(width), out(width), outDx(width), outDz(width);
+	std::vector<float> ys(width), zs(width);
+	for (unsigned int c = 0; c < width; c++) { rowX[c] = (float)c / width; }
+	Mesh mesh;
+
+	RunTimes withNormals = timeRuns(options.runs, [&]() {
+		for (unsigned int r = 0; r < rows; r++)
+		{
+			MeshBenchmark::noiseRow(mesh, &rowX[0], (float)r / width, width, &out[0], &outDx[0], &outDz[0]);
+		}
+		noiseSink = out[width / 2];
+	});
+	RunTimes heightsOnly = timeRuns(options.runs, [&]() {
+		FbmParams fbm;
+		for (unsigned int c = 0; c < width; c++) { ys[c] = 1; }
+		for (unsigned int r = 0; r < rows; r++)
+		{
+			for (unsigned int c = 0; c < width; c++) { zs[c] = (float)r / width; }
+			FbmNoise::sampleBatch(FbmNoise::Basis::PerlinPermutation, fbm, &rowX[0], &ys[0], &zs[0], &out[0], width);
+		}
+		noiseSink = out[width / 2];
+	});
+
+	double samples = (double)width * rows;
+	json.beginObject();
+	json.field("samples", (unsigned long long)samples);
+	json.field("octaves", 6);
+	writeTimes(json, "heightsOnlyMs", heightsOnly);
+	writeTimes(json, "withNormalsMs", withNormals);
+	json.field("normalNsPerVertex", (withNormals.median - heightsOnly.median) * 1e6 / samples);
+	json.endObject();
+}
+
+/**
+*
+* Mesh::generateVertices() on every hardware thread for every size and vertex layout
+*
+**/
+void benchmarkGenerateVertices(JsonWriter& json, const Options& options)
+{
+	json.beginArray();
+	for (unsigned int size : options.sizes)
+	{
+		for (TerrainVertexLayout layout : { TerrainVertexLayout::Float, TerrainVertexLayout::Packed, TerrainVertexLayout::Heightmap })
+		{
+			std::cerr << "generateVertices " << size << " " << layoutName(layout) << std::endl;
+			RunTimes times;
+			{
+				Mesh mesh;
+				mesh.setVertexLayout(layout);
+				times = timeRuns(options.runs, [&]() { mesh.generateVertices(size, size); });
+			}
+			double vertices = (double)size * size;
+			json.beginObject();
+			json.field("size", size);
+			json.field("layout", layoutName(layout));
+			writeTimes(json, "ms", times);
+			json.field("verticesPerSecond", vertices / (times.median / 1000.0));
+			json.field("peakRssBytes", peakResidentBytes());
+			json.endObject();
+		}
+	}
+	json.endArray();
+}
+
+/**
+*
+* The passes that replaced de-indexing the grid: writing the shared grid's index buffer,
+* and building the vertex to triangle adjacency from it
+*
+**/
+void benchmarkIndices(JsonWriter& json, const Options& options)
+{
+	json.beginArray();
+	for (unsigned int size : options.sizes)
+	{
+		std::cerr << "indices " << size << std::endl;
+		std::vector<unsigned int> indices((size_t)(size - 1) * (size - 1) * 6);
+		RunTimes writeTimesMs = timeRuns(options.runs, [&]() { Mesh::writeGridIndices(size, 0, size - 1, &indices[0]); });
+		indices = std::vector<unsigned int>();
+
+		RunTimes adjacencyTimes;
+		{
+			Mesh mesh;
+			mesh.generateVertices(size, size);
+			adjacencyTimes = timeRuns(options.runs, [&]() { mesh.getTriangleAdjacency(); },
+				[&]() { MeshBenchmark::forgetTriangleAdjacency(mesh); });
+		}
+
+		json.beginObject();
+		json.field("size", size);
+		writeTimes(json, "writeGridIndicesMs", writeTimesMs);
+		writeTimes(json, "triangleAdjacencyMs", adjacencyTimes);
+		json.field("peakRssBytes", peakResidentBytes());
+		json.endObject();
+	}
+	json.endArray();
+}
+
+/**
+*
+* The CPU work of createSceneTerrain() and createTerrainBounds() before anything reaches GL:
+* the height quadtree, the culler's patch order, the patch ordered index buffer,
+* and for comparison the deep copies of the float arrays the upload used to make
+*
+**/
+void benchmarkStaging(JsonWriter& json, const Options& options)
+{
+	json.beginArray();
+	for (unsigned int size : options.sizes)
+	{
+		std::cerr << "staging " << size << std::endl;
+		Mesh mesh;
+		mesh.generateVertices(size, size);
+
+		HeightQuadtree bounds;
+		TerrainCuller culler;
+		RunTimes quadtreeTimes = timeRuns(options.runs, [&]() {
+			bounds.build(size, size, 16, [&](unsigned int x, unsigned int z) { return mesh.getHeight(x, z); });
+		});
+		RunTimes cullerTimes = timeRuns(options.runs, [&]() { culler.build(bounds, mesh.getSpacing()); });
+		std::vector<unsigned int> patchIndices(culler.indexCount());
+		RunTimes patchIndexTimes = timeRuns(options.runs, [&]() { culler.writePatchIndices(&patchIndices[0]); });
+		patchIndices = std::vector<unsigned int>();
+		RunTimes copyTimes = timeRuns(options.runs, [&]() {
+			std::vector<cy::Vec3f> vertices = mesh.getVertices();
+			std::vector<cy::Vec3f> normals = mesh.getNorms();
+			std::vector<cy::Vec4f> colors = mesh.getColors();
+			std::vector<unsigned int> indices = mesh.getIndices();
+			noiseSink = vertices.back().y + normals.back().y + colors.back().x + (float)indices.back();
+		});
+
+		json.beginObject();
+		json.field("size", size);
+		writeTimes(json, "heightQuadtreeMs", quadtreeTimes);
+		writeTimes(json, "terrainCullerMs", cullerTimes);
+		writeTimes(json, "patchIndicesMs", patchIndexTimes);
+		writeTimes(json, "floatArrayCopiesMs", copyTimes);
+		json.field("peakRssBytes", peakResidentBytes());
+		json.endObject();
+	}
+	json.endArray();
+}
+
+/**
+*
+* Median time and speedup over one thread of the parallel passes for every thread count
+*
+**/
+void benchmarkThreadScaling(JsonWriter& json, const Options& options)
+{
+	unsigned int size = options.scalingSize;
+	json.beginArray();
+
+	auto curve = [&](const char* stage, const std::function<RunTimes(unsigned int)>& run) {
+		json.beginObject();
+		json.field("stage", stage);
+		json.field("size", size);
+		json.key("points");
+		json.beginArray();
+		double single = 0;
+		for (unsigned int threads : options.threads)
+		{
+			std::cerr << stage << " " << size << " on " << threads << " threads" << std::endl;
+			RunTimes times = run(threads);
+			if (single == 0) { single = times.median * threads; }
+			json.beginObject();
+			json.field("threads", threads);
+			writeTimes(json, "ms", times);
+			// against the first count scaled to one thread, which is exact when the list starts at 1
+			json.field("speedup", single / times.median);
+			json.endObject();
+		}
+		json.endArray();
+		json.endObject();
+	};
+
+	curve("generateVertices", [&](unsigned int threads) {
+		Mesh mesh;
+		mesh.setVertexLayout(TerrainVertexLayout::Packed);
+		return timeRuns(options.runs, [&]() { mesh.generateVertices(size, size, threads); });
+	});
+	{
+		Mesh mesh;
+		mesh.generateVertices(size, size);
+		curve("triangleAdjacency", [&](unsigned int threads) {
+			return timeRuns(options.runs, [&]() { mesh.getTriangleAdjacency(threads); },
+				[&]() { MeshBenchmark::forgetTriangleAdjacency(mesh); });
+		});
+	}
+	json.endArray();
+}
+
+/**
+*
+* Name of a vertex layout in the report
+*
+**/
+const char* layoutName(TerrainVertexLayout layout)
+{
+	switch (layout)
+	{
+	case TerrainVertexLayout::Packed: return "Packed";
+	case TerrainVertexLayout::Heightmap: return "Heightmap";
+	default: return "Float";
+	}
+}
+
+/**
+*
+* Check that a streamed tile left of and behind the world origin samples the noise at its own coordinates:
+* the heights of Mesh::generateRegion() against NoiseEngine::fbmBatchGradient() at the same points, with the
+* lakes flattened the same way. Returns false if any vertex is off by more than float rounding.
+*
+**/
+bool checkNegativeOrigin(JsonWriter& json)
+{
+	std::cerr << "negative origin" << std::endl;
+	// same noise parameters as the tiles of ChunkManager
+	const unsigned int size = 129;
+	TerrainParams params = { .noiseScale = 600, .referenceHeight = 500 };
+	params.originX = -(int)(size - 1);
+	params.originZ = -(int)(size - 1);
+	Mesh mesh;
+	mesh.generateRegion(size, size, params, 1);
+
+	FbmParams fbm;
+	fbm.octaves = params.octaves;
+	fbm.persistence = params.persistence;
+	fbm.frequency = params.frequency;
+	std::vector<float> xs(size), ys(size, 1.0f), zs(size), out(size), dx(size), dy(size), dz(size);
+	for (unsigned int c = 0; c < size; c++) { xs[c] = (float)(params.originX + (int)c) / params.noiseScale; }
+	float lakeLevel = .3f * params.referenceHeight;
+	float maxError = 0;
+	for (unsigned int r = 0; r < size; r++)
+	{
+		for (unsigned int c = 0; c < size; c++) { zs[c] = (float)(params.originZ + (int)r) / params.noiseScale; }
+		NoiseEngine::active().fbmBatchGradient(&xs[0], &ys[0], &zs[0], &out[0], &dx[0], &dy[0], &dz[0], size, fbm);
+		for (unsigned int c = 0; c < size; c++)
+		{
+			float expected = out[c] * out[c] * 200 * params.spacing;
+			if (expected < lakeLevel) { expected = lakeLevel; }
+			float error = fabsf(mesh.getHeight(c, r) - expected);
+			if (error > maxError) { maxError = error; }
+		}
+	}
+
+	// the grid sampler rounds differently from the fBm kernels, far below a height unit
+	bool matches = maxError < 0.01f;
+	json.beginObject();
+	json.field("originX", params.originX);
+	json.field("originZ", params.originZ);
+	json.field("size", size);
+	json.field("maxError", maxError);
+	json.field("matches", matches);
+	json.endObject();
+	return matches;
+}
+
+/**
+*
+* Check that the triangle adjacency only depends on the grid size: the packed and heightmap layouts, which have
+* no float positions, and a float mesh whose positions were released have to give the adjacency of a float mesh.
+*
+**/
+bool checkAdjacencyLayouts(JsonWriter& json)
+{
+	std::cerr << "adjacency layouts" << std::endl;
+	const unsigned int size = 10;
+	Mesh reference;
+	reference.generateVertices(size, size);
+	const VertexTriangleAdjacency& expected = reference.getTriangleAdjacency();
+
+	auto matches = [&](Mesh& mesh) {
+		const VertexTriangleAdjacency& adjacency = mesh.getTriangleAdjacency();
+		return adjacency.offsets == expected.offsets && adjacency.triangles == expected.triangles;
+	};
+	Mesh packed;
+	packed.setVertexLayout(TerrainVertexLayout::Packed);
+	packed.generateVertices(size, size);
+	Mesh heightmap;
+	heightmap.setVertexLayout(TerrainVertexLayout::Heightmap);
+	heightmap.generateVertices(size, size);
+	Mesh released;
+	released.generateVertices(size, size);
+	released.releaseVertices();
+
+	bool packedMatches = matches(packed);
+	bool heightmapMatches = matches(heightmap);
+	bool releasedMatches = matches(released);
+	json.beginObject();
+	json.field("size", size);
+	json.field("offsets", (unsigned long long)expected.offsets.size());
+	json.field("packed", packedMatches);
+	json.field("heightmap", heightmapMatches);
+	json.field("released", releasedMatches);
+	json.endObject();
+	return packedMatches && heightmapMatches && releasedMatches;
+}
@@ -0,0 +1,179 @@
+/**
+*
+* Minimal streaming JSON writer for the benchmark report.
+*
+**/
+
+#include "JsonWriter.h"
+
+#include <cmath>
+#include <iomanip>
+
+/// <summary>
+/// Write to out, which has to outlive the writer
+/// </summary>
+JsonWriter::JsonWriter(std::ostream& out) : out(out)
+{
+    afterKey = false;
+}
+
+/// <summary>
+/// Open an object, as a value or at the top level
+/// </summary>
+void JsonWriter::beginObject()
+{
+    beforeValue();
+    out << '{';
+    empty.push_back(true);
+}
+
+/// <summary>
+/// Close the innermost object
+/// </summary>
+void JsonWriter::endObject()
+{
+    bool wasEmpty = empty.back();
+    empty.pop_back();
+    if (!wasEmpty) { newLine(); }
+    out << '}';
+    if (empty.empty()) { out << '\n'; }
+}
+
+/// <summary>
+/// Open an array, as a value or at the top level
+/// </summary>
+void JsonWriter::beginArray()
+{
+    beforeValue();
+    out << '[';
+    empty.push_back(true);
+}
+
+/// <summary>
+/// Close the innermost array
+/// </summary>
+void JsonWriter::endArray()
+{
+    bool wasEmpty = empty.back();
+    empty.pop_back();
+    if (!wasEmpty) { newLine(); }
+    out << ']';
+    if (empty.empty()) { out << '\n'; }
+}
+
+/// <summary>
+/// Name of the next value of the innermost object
+/// </summary>
+void JsonWriter::key(const char* name)
+{
+    beforeValue();
+    writeString(name);
+    out << ": ";
+    afterKey = true;
+}
+
+/// <summary>
+/// Number with up to 6 significant digits after the point, infinities and NaN are written as null
+/// </summary>
+void JsonWriter::value(double number)
+{
+    beforeValue();
+    if (!std::isfinite(number)) {
+        out << "null";
+        return;
+    }
+    std::ios flags(nullptr);
+    flags.copyfmt(out);
+    out << std::setprecision(6) << number;
+    out.copyfmt(flags);
+}
+
+/// <summary>
+/// Integer, e.g. a byte or sample count
+/// </summary>
+void JsonWriter::value(unsigned long long number)
+{
+    beforeValue();
+    out << number;
+}
+
+/// <summary>
+/// Integer
+/// </summary>
+void JsonWriter::value(unsigned int number)
+{
+    value((unsigned long long)number);
+}
+
+/// <summary>
+/// Integer
+/// </summary>
+void JsonWriter::value(int number)
+{
+    beforeValue();
+    out << number;
+}
+
+/// <summary>
+/// true or false
+/// </summary>
+void JsonWriter::value(bool flag)
+{
+    beforeValue();
+    out << (flag ? "true" : "false");
+}
+
+/// <summary>
+/// String
+/// </summary>
+void JsonWriter::value(const char* text)
+{
+    beforeValue();
+    writeString(text);
+}
+
+/// <summary>
+/// String
+/// </summary>
+void JsonWriter::value(const std::string& text)
+{
+    value(text.c_str());
+}
+
+/// <summary>
+/// Quoted string, quotes, backslashes and control characters are escaped
+/// </summary>
+void JsonWriter::writeString(const char* text)
+{
+    out << '"';
+    for (const char* c = text; *c != '\0'; c++) {
+        if (*c == '"' || *c == '\\') { out << '\\' << *c; }
+        else if ((unsigned char)*c < 0x20) { out << "\\u00" << "0123456789abcdef"[*c >> 4] << "0123456789abcdef"[*c & 0xF]; }
+        else { out << *c; }
+    }
+    out << '"';
+}
+
+/// <summary>
+/// Comma and line break before a value, unless it is the value of a key or the first in its parent
+/// </summary>
+void JsonWriter::beforeValue()
+{
+    if (afterKey) {
+        afterKey = false;
+        return;
+    }
+    if (empty.empty()) { return; }
+    if (!empty.back()) { out << ','; }
+    empty.back() = false;
+    newLine();
+}
+
+/// <summary>
+/// Line break and two spaces per open object or array
+/// </summary>
+void JsonWriter::newLine()
+{
+    out << '\n';
+    for (size_t i = 0; i < empty.size(); i++) { out << "  "; }
+}
@@ -0,0 +1,49 @@
+/**
+*
+* Minimal streaming JSON writer for the benchmark report.
+* Commas and nesting are tracked, so callers only say what comes next.
+*
+**/
+
+#pragma once
+
+#include <ostream>
+#include <string>
+#include <vector>
+
+class JsonWriter
+{
+public:
+	explicit JsonWriter(std::ostream& out);
+
+	void beginObject();
+	void endObject();
+	void beginArray();
+	void endArray();
+	void key(const char* name);
+
+	void value(double number);
+	void value(unsigned long long number);
+	void value(unsigned int number);
+	void value(int number);
+	void value(bool flag);
+	void value(const char* text);
+	void value(const std::string& text);
+
+	// key and value in one call, inside an object
+	template <class T>
+	void field(const char* name, const T& v)
+	{
+		key(name);
+		value(v);
+	}
+
+private:
+	void beforeValue();
+	void writeString(const char* text);
+	void newLine();
+
+	std::ostream& out;
+	std::vector<bool> empty;	// per open object or array, whether nothing was written into it yet
+	bool afterKey;
+};
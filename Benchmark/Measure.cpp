@@ -0,0 +1,75 @@
+/**
+*
+* Timing and memory measurements for the benchmark.
+*
+**/
+
+#include "Measure.h"
+
+#include <algorithm>
+#include <chrono>
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+/// <summary>
+/// Run body several times and time every run on its own
+/// </summary>
+/// <param name="runs">number of timed runs, at least 1</param>
+/// <param name="body">the work to time</param>
+/// <param name="setup">untimed work before every run, e.g. throwing away a cached result, may be empty</param>
+RunTimes timeRuns(unsigned int runs, const std::function<void()>& body, const std::function<void()>& setup)
+{
+    std::vector<double> milliseconds;
+    for (unsigned int i = 0; i < std::max(runs, 1u); i++) {
+        if (setup) { setup(); }
+        auto start = std::chrono::steady_clock::now();
+        body();
+        milliseconds.push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+    }
+    return summarizeRuns(milliseconds);
+}
+
+/// <summary>
+/// Minimum, median and mean of a set of run times
+/// </summary>
+RunTimes summarizeRuns(std::vector<double> milliseconds)
+{
+    RunTimes times;
+    times.runs = (unsigned int)milliseconds.size();
+    if (milliseconds.empty()) { return times; }
+
+    std::sort(milliseconds.begin(), milliseconds.end());
+    double sum = 0;
+    for (double ms : milliseconds) { sum += ms; }
+    size_t middle = milliseconds.size() / 2;
+    times.min = milliseconds.front();
+    times.median = milliseconds.size() % 2 ? milliseconds[middle] : (milliseconds[middle - 1] + milliseconds[middle]) / 2;
+    times.mean = sum / milliseconds.size();
+    return times;
+}
+
+/// <summary>
+/// Highest resident set size of the process so far, in bytes, 0 where the platform cannot tell
+/// </summary>
+unsigned long long peakResidentBytes()
+{
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS counters;
+    if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) { return 0; }
+    return counters.PeakWorkingSetSize;
+#else
+    rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0) { return 0; }
+#ifdef __APPLE__
+    return (unsigned long long)usage.ru_maxrss;
+#else
+    return (unsigned long long)usage.ru_maxrss * 1024;    // kilobytes on Linux
+#endif
+#endif
+}
@@ -0,0 +1,23 @@
+/**
+*
+* Timing and memory measurements for the benchmark.
+*
+**/
+
+#pragma once
+
+#include <vector>
+#include <functional>
+
+// times of the repeated runs of one measurement, in milliseconds
+struct RunTimes
+{
+	double min = 0;
+	double median = 0;
+	double mean = 0;
+	unsigned int runs = 0;
+};
+
+RunTimes timeRuns(unsigned int runs, const std::function<void()>& body, const std::function<void()>& setup = nullptr);
+RunTimes summarizeRuns(std::vector<double> milliseconds);
+unsigned long long peakResidentBytes();
@@ -78,6 +78,7 @@
 #include <vector>
 #include <string>
 #include <iostream>
+#include <cstdint>
 #include <fstream>
 #include <sstream>
 #include <cassert>
@@ -744,23 +745,44 @@ public:
 //! using vertex and fragment shaders, along with optionally geometry and tessellation shaders.
 //! The shader sources can be provides as GLSLShader class objects, source strings, or file names.
 //! This class also stores a vector of registered uniform parameter IDs.
+//! Uniform parameters set by name are looked up in a hash table of uniform locations,
+//! which is filled with the active uniforms of the program when it is linked.
 
 class GLSLProgram
 {
+public:
+	//! Name of a uniform parameter along with its hash.
+	//! String literals convert to it implicitly. Hot code can declare it constexpr, so that the hash is computed at compile time:
+	//! static constexpr GLSLProgram::UniformName viewName("view");
+	class UniformName
+	{
+	public:
+		constexpr UniformName( char const *n ) : name(n), hash(Hash(n)) {}
+		char const *name;
+		uint64_t    hash;
+		//! 64-bit FNV-1a hash of the name, never 0, which marks an empty slot of the location table
+		static constexpr uint64_t Hash( char const *n ) { uint64_t h = 14695981039346656037ull; for ( ; *n; n++ ) { h ^= (unsigned char)*n; h *= 1099511628211ull; } return h ? h : 1; }
+	};
+
 private:
 	GLuint programID;			//!< The program ID
 	std::vector<GLint> params;	//!< A list of registered uniform parameter IDs
+	struct UniformSlot { uint64_t hash; GLint location; };
+	std::vector<UniformSlot> uniformTable;	//!< Open addressing hash table of uniform locations by name hash, the size is a power of two
+	size_t uniformCount;					//!< Number of used slots in uniformTable
+
+	static GLuint& BoundProgram() { static GLuint boundProgram = CY_GL_INVALID_ID; return boundProgram; }	//!< The program last bound by any GLSLProgram
 
 public:
-	GLSLProgram() : programID(CY_GL_INVALID_ID) {}					//!< Constructor
+	GLSLProgram() : programID(CY_GL_INVALID_ID), uniformCount(0) {}	//!< Constructor
 	virtual ~GLSLProgram() { if ( GL::CheckContext() ) Delete(); }	//!< Destructor that deletes the program
 
 	//!@name General Methods
 
-	void   Delete() { if (programID!=CY_GL_INVALID_ID) { glDeleteProgram(programID); programID=CY_GL_INVALID_ID; } }	//!< Deletes the program.
+	void   Delete() { if (programID!=CY_GL_INVALID_ID) { glDeleteProgram(programID); if ( BoundProgram() == programID ) BoundProgram() = CY_GL_INVALID_ID; programID=CY_GL_INVALID_ID; } uniformTable.clear(); uniformCount=0; }	//!< Deletes the program.
 	GLuint GetID () const { return programID; }						//!< Returns the program ID
 	bool   IsNull() const { return programID == CY_GL_INVALID_ID; }	//!< Returns true if the OpenGL program object is not generated, i.e. the program id is invalid.
-	void   Bind  () const { glUseProgram(programID); }				//!< Binds the program for rendering
+	void   Bind  () const { glUseProgram(programID); BoundProgram() = programID; }	//!< Binds the program for rendering
 
 	//! Attaches the given shader to the program.
 	//! This function must be called before calling Link.
@@ -1014,138 +1036,138 @@ public:
 	//!@}
 
 
-	//!@{ glUseProgram(programID); int id = glGetUniformLocation( programID, name ); if ( id >= 0 )
+	//!@{
 	//! Sets the value of the uniform parameter with the given name, if the uniform parameter is found. 
-	//! Since it searches for the uniform parameter first, it is not as efficient as setting the uniform parameter using
-	//! a previously registered id. There is no need to bind the program before calling this method.
-	void SetUniform (char const *name, float x)                                { glUseProgram(programID); int id = glGetUniformLocation( programID, name ); if ( id >= 0 ) glUniform1f  (id,x); }
-	void SetUniform (char const *name, float x, float y)                       { glUseProgram(programID); int id = glGetUniformLocation( programID, name ); if ( id >= 0 ) glUniform2f  (id,x,y); }
-	void SetUniform (char const *name, float x, float y, float z)              { glUseProgram(programID); int id = glGetUniformLocation( programID, name ); if ( id >= 0 ) glUniform3f  (id,x,y,z); }
-	void SetUniform (char const *name, float x, float y, float z, float w)     { glUseProgram(programID); int id = glGetUniformLocation( programID, name ); if ( id >= 0 ) glUniform4f  (id,x,y,z,w); }
-	void SetUniform1(char const *name, float  const *data, int count=1)        { glUseProgram(programID); int id = glGetUniformLocation( programID, name ); if ( id >= 0 ) glUniform1fv (id,count,data); }
-	void SetUniform2(char const *name, float  const *data, int count=1)        { glUseProgram(programID); int id = glGetUniformLocation( programID, name ); if ( id >= 0 ) glUniform2fv (id,count,data); }
-	void SetUniform3(char const *name, float  const *data, int count=1)        { glUseProgram(programID); int id = glGetUniformLocation( programID, name ); if ( id >= 0 ) glUniform3fv (id,count,data); }
-	void SetUniform4(char const *name, float  const *data, int count=1)        { glUseProgram(programID); int id = glGetUniformLocation( programID, name ); if ( id >= 0 ) glUniform4fv (id,count,data); }
-	void SetUniform (char const *name, int x)                                  { glUseProgram(programID); int id = glGetUniformLocation( programID, name ); if ( id >= 0 ) glUniform1i  (id,x); }
-	void SetUniform (char const *name, int x, int y)                           { glUseProgram(programID); int id = glGetUniformLocation( programID, name ); if ( id >= 0 ) glUniform2i  (id,x,y); }
-	void SetUniform (char const *name, int x, int y, int z)                    { glUseProgram(programID); int id = glGetUniformLocation( programID, name ); if ( id >= 0 ) glUniform3i  (id,x,y,z); }
-	void SetUniform (char const *name, int x, int y, int z, int w)             { glUseProgram(programID); int id = glGetUniformLocation( programID, name ); if ( id >= 0 ) glUniform4i  (id,x,y,z,w); }
-	void SetUniform1(char const *name, int    const *data, int count=1)        { glUseProgram(programID); int id = glGetUniformLocation( programID, name ); if ( id >= 0 ) glUniform1iv (id,count,data); }
-	void SetUniform2(char const *name, int    const *data, int count=1)        { glUseProgram(programID); int id = glGetUniformLocation( programID, name ); if ( id >= 0 ) glUniform2iv (id,count,data); }
-	void SetUniform3(char const *name, int    const *data, int count=1)        { glUseProgram(programID); int id = glGetUniformLocation( programID, name ); if ( id >= 0 ) glUniform3iv (id,count,data); }
-	void SetUniform4(char const *name, int    const *data, int count=1)        { glUseProgram(programID); int id = glGetUniformLocation( programID, name ); if ( id >= 0 ) glUniform4iv (id,count,data); }
+	//! The location is found in the hash table filled by Link, so no OpenGL query is made after the first use of a name.
+	//! There is no need to bind the program before calling this method. The program is bound, unless it is already bound.
+	void SetUniform (UniformName const &name, float x)                                { int id = PrepareUniform(name); if ( id >= 0 ) glUniform1f  (id,x); }
+	void SetUniform (UniformName const &name, float x, float y)                       { int id = PrepareUniform(name); if ( id >= 0 ) glUniform2f  (id,x,y); }
+	void SetUniform (UniformName const &name, float x, float y, float z)              { int id = PrepareUniform(name); if ( id >= 0 ) glUniform3f  (id,x,y,z); }
+	void SetUniform (UniformName const &name, float x, float y, float z, float w)     { int id = PrepareUniform(name); if ( id >= 0 ) glUniform4f  (id,x,y,z,w); }
+	void SetUniform1(UniformName const &name, float  const *data, int count=1)        { int id = PrepareUniform(name); if ( id >= 0 ) glUniform1fv (id,count,data); }
+	void SetUniform2(UniformName const &name, float  const *data, int count=1)        { int id = PrepareUniform(name); if ( id >= 0 ) glUniform2fv (id,count,data); }
+	void SetUniform3(UniformName const &name, float  const *data, int count=1)        { int id = PrepareUniform(name); if ( id >= 0 ) glUniform3fv (id,count,data); }
+	void SetUniform4(UniformName const &name, float  const *data, int count=1)        { int id = PrepareUniform(name); if ( id >= 0 ) glUniform4fv (id,count,data); }
+	void SetUniform (UniformName const &name, int x)                                  { int id = PrepareUniform(name); if ( id >= 0 ) glUniform1i  (id,x); }
+	void SetUniform (UniformName const &name, int x, int y)                           { int id = PrepareUniform(name); if ( id >= 0 ) glUniform2i  (id,x,y); }
+	void SetUniform (UniformName const &name, int x, int y, int z)                    { int id = PrepareUniform(name); if ( id >= 0 ) glUniform3i  (id,x,y,z); }
+	void SetUniform (UniformName const &name, int x, int y, int z, int w)             { int id = PrepareUniform(name); if ( id >= 0 ) glUniform4i  (id,x,y,z,w); }
+	void SetUniform1(UniformName const &name, int    const *data, int count=1)        { int id = PrepareUniform(name); if ( id >= 0 ) glUniform1iv (id,count,data); }
+	void SetUniform2(UniformName const &name, int    const *data, int count=1)        { int id = PrepareUniform(name); if ( id >= 0 ) glUniform2iv (id,count,data); }
+	void SetUniform3(UniformName const &name, int    const *data, int count=1)        { int id = PrepareUniform(name); if ( id >= 0 ) glUniform3iv (id,count,data); }
+	void SetUniform4(UniformName const &name, int    const *data, int count=1)        { int id = PrepareUniform(name); if ( id >= 0 ) glUniform4iv (id,count,data); }
 #ifdef GL_VERSION_3_0
-	void SetUniform (char const *name, GLuint x)                               { glUseProgram(programID); int id = glGetUniformLocation( programID, name ); if ( id >= 0 ) glUniform1ui (id,x); }
-	void SetUniform (char const *name, GLuint x, GLuint y)                     { glUseProgram(programID); int id = glGetUniformLocation( programID, name ); if ( id >= 0 ) glUniform2ui (id,x,y); }
-	void SetUniform (char const *name, GLuint x, GLuint y, GLuint z)           { glUseProgram(programID); int id = glGetUniformLocation( programID, name ); if ( id >= 0 ) glUniform3ui (id,x,y,z); }
-	void SetUniform (char const *name, GLuint x, GLuint y, GLuint z, GLuint w) { glUseProgram(programID); int id = glGetUniformLocation( programID, name ); if ( id >= 0 ) glUniform4ui (id,x,y,z,w); }
-	void SetUniform1(char const *name, GLuint const *data, int count=1)        { glUseProgram(programID); int id = glGetUniformLocation( programID, name ); if ( id >= 0 ) glUniform1uiv(id,count,data); }
-	void SetUniform2(char const *name, GLuint const *data, int count=1)        { glUseProgram(programID); int id = glGetUniformLocation( programID, name ); if ( id >= 0 ) glUniform2uiv(id,count,data); }
-	void SetUniform3(char const *name, GLuint const *data, int count=1)        { glUseProgram(programID); int id = glGetUniformLocation( programID, name ); if ( id >= 0 ) glUniform3uiv(id,count,data); }
-	void SetUniform4(char const *name, GLuint const *data, int count=1)        { glUseProgram(programID); int id = glGetUniformLocation( programID, name ); if ( id >= 0 ) glUniform4uiv(id,count,data); }
+	void SetUniform (UniformName const &name, GLuint x)                               { int id = PrepareUniform(name); if ( id >= 0 ) glUniform1ui (id,x); }
+	void SetUniform (UniformName const &name, GLuint x, GLuint y)                     { int id = PrepareUniform(name); if ( id >= 0 ) glUniform2ui (id,x,y); }
+	void SetUniform (UniformName const &name, GLuint x, GLuint y, GLuint z)           { int id = PrepareUniform(name); if ( id >= 0 ) glUniform3ui (id,x,y,z); }
+	void SetUniform (UniformName const &name, GLuint x, GLuint y, GLuint z, GLuint w) { int id = PrepareUniform(name); if ( id >= 0 ) glUniform4ui (id,x,y,z,w); }
+	void SetUniform1(UniformName const &name, GLuint const *data, int count=1)        { int id = PrepareUniform(name); if ( id >= 0 ) glUniform1uiv(id,count,data); }
+	void SetUniform2(UniformName const &name, GLuint const *data, int count=1)        { int id = PrepareUniform(name); if ( id >= 0 ) glUniform2uiv(id,count,data); }
+	void SetUniform3(UniformName const &name, GLuint const *data, int count=1)        { int id = PrepareUniform(name); if ( id >= 0 ) glUniform3uiv(id,count,data); }
+	void SetUniform4(UniformName const &name, GLuint const *data, int count=1)        { int id = PrepareUniform(name); if ( id >= 0 ) glUniform4uiv(id,count,data); }
 #endif
 #ifdef GL_VERSION_4_0
-	void SetUniform (char const *name, double x)                               { glUseProgram(programID); int id = glGetUniformLocation( programID, name ); if ( id >= 0 ) glUniform1d  (id,x); }
-	void SetUniform (char const *name, double x, double y)                     { glUseProgram(programID); int id = glGetUniformLocation( programID, name ); if ( id >= 0 ) glUniform2d  (id,x,y); }
-	void SetUniform (char const *name, double x, double y, double z)           { glUseProgram(programID); int id = glGetUniformLocation( programID, name ); if ( id >= 0 ) glUniform3d  (id,x,y,z); }
-	void SetUniform (char const *name, double x, double y, double z, double w) { glUseProgram(programID); int id = glGetUniformLocation( programID, name ); if ( id >= 0 ) glUniform4d  (id,x,y,z,w); }
-	void SetUniform1(char const *name, double const *data, int count=1)        { glUseProgram(programID); int id = glGetUniformLocation( programID, name ); if ( id >= 0 ) glUniform1dv (id,count,data); }
-	void SetUniform2(char const *name, double const *data, int count=1)        { glUseProgram(programID); int id = glGetUniformLocation( programID, name ); if ( id >= 0 ) glUniform2dv (id,count,data); }
-	void SetUniform3(char const *name, double const *data, int count=1)        { glUseProgram(programID); int id = glGetUniformLocation( programID, name ); if ( id >= 0 ) glUniform3dv (id,count,data); }
-	void SetUniform4(char const *name, double const *data, int count=1)        { glUseProgram(programID); int id = glGetUniformLocation( programID, name ); if ( id >= 0 ) glUniform4dv (id,count,data); }
+	void SetUniform (UniformName const &name, double x)                               { int id = PrepareUniform(name); if ( id >= 0 ) glUniform1d  (id,x); }
+	void SetUniform (UniformName const &name, double x, double y)                     { int id = PrepareUniform(name); if ( id >= 0 ) glUniform2d  (id,x,y); }
+	void SetUniform (UniformName const &name, double x, double y, double z)           { int id = PrepareUniform(name); if ( id >= 0 ) glUniform3d  (id,x,y,z); }
+	void SetUniform (UniformName const &name, double x, double y, double z, double w) { int id = PrepareUniform(name); if ( id >= 0 ) glUniform4d  (id,x,y,z,w); }
+	void SetUniform1(UniformName const &name, double const *data, int count=1)        { int id = PrepareUniform(name); if ( id >= 0 ) glUniform1dv (id,count,data); }
+	void SetUniform2(UniformName const &name, double const *data, int count=1)        { int id = PrepareUniform(name); if ( id >= 0 ) glUniform2dv (id,count,data); }
+	void SetUniform3(UniformName const &name, double const *data, int count=1)        { int id = PrepareUniform(name); if ( id >= 0 ) glUniform3dv (id,count,data); }
+	void SetUniform4(UniformName const &name, double const *data, int count=1)        { int id = PrepareUniform(name); if ( id >= 0 ) glUniform4dv (id,count,data); }
 #endif
 
-	void SetUniformMatrix2  (char const *name, float  const *m, int count=1, bool transpose=false) { glUseProgram(programID); int id = glGetUniformLocation( programID, name ); if ( id >= 0 ) glUniformMatrix2fv  (id,count,transpose,m); }
-	void SetUniformMatrix3  (char const *name, float  const *m, int count=1, bool transpose=false) { glUseProgram(programID); int id = glGetUniformLocation( programID, name ); if ( id >= 0 ) glUniformMatrix3fv  (id,count,transpose,m); }
-	void SetUniformMatrix4  (char const *name, float  const *m, int count=1, bool transpose=false) { glUseProgram(programID); int id = glGetUniformLocation( programID, name ); if ( id >= 0 ) glUniformMatrix4fv  (id,count,transpose,m); }
+	void SetUniformMatrix2  (UniformName const &name, float  const *m, int count=1, bool transpose=false) { int id = PrepareUniform(name); if ( id >= 0 ) glUniformMatrix2fv  (id,count,transpose,m); }
+	void SetUniformMatrix3  (UniformName const &name, float  const *m, int count=1, bool transpose=false) { int id = PrepareUniform(name); if ( id >= 0 ) glUniformMatrix3fv  (id,count,transpose,m); }
+	void SetUniformMatrix4  (UniformName const &name, float  const *m, int count=1, bool transpose=false) { int id = PrepareUniform(name); if ( id >= 0 ) glUniformMatrix4fv  (id,count,transpose,m); }
 #ifdef GL_VERSION_2_1
-	void SetUniformMatrix2x3(char const *name, float  const *m, int count=1, bool transpose=false) { glUseProgram(programID); int id = glGetUniformLocation( programID, name ); if ( id >= 0 ) glUniformMatrix2x3fv(id,count,transpose,m); }
-	void SetUniformMatrix2x4(char const *name, float  const *m, int count=1, bool transpose=false) { glUseProgram(programID); int id = glGetUniformLocation( programID, name ); if ( id >= 0 ) glUniformMatrix2x4fv(id,count,transpose,m); }
-	void SetUniformMatrix3x2(char const *name, float  const *m, int count=1, bool transpose=false) { glUseProgram(programID); int id = glGetUniformLocation( programID, name ); if ( id >= 0 ) glUniformMatrix3x2fv(id,count,transpose,m); }
-	void SetUniformMatrix3x4(char const *name, float  const *m, int count=1, bool transpose=false) { glUseProgram(programID); int id = glGetUniformLocation( programID, name ); if ( id >= 0 ) glUniformMatrix3x4fv(id,count,transpose,m); }
-	void SetUniformMatrix4x2(char const *name, float  const *m, int count=1, bool transpose=false) { glUseProgram(programID); int id = glGetUniformLocation( programID, name ); if ( id >= 0 ) glUniformMatrix4x2fv(id,count,transpose,m); }
-	void SetUniformMatrix4x3(char const *name, float  const *m, int count=1, bool transpose=false) { glUseProgram(programID); int id = glGetUniformLocation( programID, name ); if ( id >= 0 ) glUniformMatrix4x3fv(id,count,transpose,m); }
+	void SetUniformMatrix2x3(UniformName const &name, float  const *m, int count=1, bool transpose=false) { int id = PrepareUniform(name); if ( id >= 0 ) glUniformMatrix2x3fv(id,count,transpose,m); }
+	void SetUniformMatrix2x4(UniformName const &name, float  const *m, int count=1, bool transpose=false) { int id = PrepareUniform(name); if ( id >= 0 ) glUniformMatrix2x4fv(id,count,transpose,m); }
+	void SetUniformMatrix3x2(UniformName const &name, float  const *m, int count=1, bool transpose=false) { int id = PrepareUniform(name); if ( id >= 0 ) glUniformMatrix3x2fv(id,count,transpose,m); }
+	void SetUniformMatrix3x4(UniformName const &name, float  const *m, int count=1, bool transpose=false) { int id = PrepareUniform(name); if ( id >= 0 ) glUniformMatrix3x4fv(id,count,transpose,m); }
+	void SetUniformMatrix4x2(UniformName const &name, float  const *m, int count=1, bool transpose=false) { int id = PrepareUniform(name); if ( id >= 0 ) glUniformMatrix4x2fv(id,count,transpose,m); }
+	void SetUniformMatrix4x3(UniformName const &name, float  const *m, int count=1, bool transpose=false) { int id = PrepareUniform(name); if ( id >= 0 ) glUniformMatrix4x3fv(id,count,transpose,m); }
 #endif
 #ifdef GL_VERSION_4_0
-	void SetUniformMatrix2  (char const *name, double const *m, int count=1, bool transpose=false) { glUseProgram(programID); int id = glGetUniformLocation( programID, name ); if ( id >= 0 ) glUniformMatrix2dv  (id,count,transpose,m); }
-	void SetUniformMatrix3  (char const *name, double const *m, int count=1, bool transpose=false) { glUseProgram(programID); int id = glGetUniformLocation( programID, name ); if ( id >= 0 ) glUniformMatrix3dv  (id,count,transpose,m); }
-	void SetUniformMatrix4  (char const *name, double const *m, int count=1, bool transpose=false) { glUseProgram(programID); int id = glGetUniformLocation( programID, name ); if ( id >= 0 ) glUniformMatrix4dv  (id,count,transpose,m); }
-	void SetUniformMatrix2x3(char const *name, double const *m, int count=1, bool transpose=false) { glUseProgram(programID); int id = glGetUniformLocation( programID, name ); if ( id >= 0 ) glUniformMatrix2x3dv(id,count,transpose,m); }
-	void SetUniformMatrix2x4(char const *name, double const *m, int count=1, bool transpose=false) { glUseProgram(programID); int id = glGetUniformLocation( programID, name ); if ( id >= 0 ) glUniformMatrix2x4dv(id,count,transpose,m); }
-	void SetUniformMatrix3x2(char const *name, double const *m, int count=1, bool transpose=false) { glUseProgram(programID); int id = glGetUniformLocation( programID, name ); if ( id >= 0 ) glUniformMatrix3x2dv(id,count,transpose,m); }	
-	void SetUniformMatrix3x4(char const *name, double const *m, int count=1, bool transpose=false) { glUseProgram(programID); int id = glGetUniformLocation( programID, name ); if ( id >= 0 ) glUniformMatrix3x4dv(id,count,transpose,m); }	
-	void SetUniformMatrix4x2(char const *name, double const *m, int count=1, bool transpose=false) { glUseProgram(programID); int id = glGetUniformLocation( programID, name ); if ( id >= 0 ) glUniformMatrix4x2dv(id,count,transpose,m); }	
-	void SetUniformMatrix4x3(char const *name, double const *m, int count=1, bool transpose=false) { glUseProgram(programID); int id = glGetUniformLocation( programID, name ); if ( id >= 0 ) glUniformMatrix4x3dv(id,count,transpose,m); }	
+	void SetUniformMatrix2  (UniformName const &name, double const *m, int count=1, bool transpose=false) { int id = PrepareUniform(name); if ( id >= 0 ) glUniformMatrix2dv  (id,count,transpose,m); }
+	void SetUniformMatrix3  (UniformName const &name, double const *m, int count=1, bool transpose=false) { int id = PrepareUniform(name); if ( id >= 0 ) glUniformMatrix3dv  (id,count,transpose,m); }
+	void SetUniformMatrix4  (UniformName const &name, double const *m, int count=1, bool transpose=false) { int id = PrepareUniform(name); if ( id >= 0 ) glUniformMatrix4dv  (id,count,transpose,m); }
+	void SetUniformMatrix2x3(UniformName const &name, double const *m, int count=1, bool transpose=false) { int id = PrepareUniform(name); if ( id >= 0 ) glUniformMatrix2x3dv(id,count,transpose,m); }
+	void SetUniformMatrix2x4(UniformName const &name, double const *m, int count=1, bool transpose=false) { int id = PrepareUniform(name); if ( id >= 0 ) glUniformMatrix2x4dv(id,count,transpose,m); }
+	void SetUniformMatrix3x2(UniformName const &name, double const *m, int count=1, bool transpose=false) { int id = PrepareUniform(name); if ( id >= 0 ) glUniformMatrix3x2dv(id,count,transpose,m); }	
+	void SetUniformMatrix3x4(UniformName const &name, double const *m, int count=1, bool transpose=false) { int id = PrepareUniform(name); if ( id >= 0 ) glUniformMatrix3x4dv(id,count,transpose,m); }	
+	void SetUniformMatrix4x2(UniformName const &name, double const *m, int count=1, bool transpose=false) { int id = PrepareUniform(name); if ( id >= 0 ) glUniformMatrix4x2dv(id,count,transpose,m); }	
+	void SetUniformMatrix4x3(UniformName const &name, double const *m, int count=1, bool transpose=false) { int id = PrepareUniform(name); if ( id >= 0 ) glUniformMatrix4x3dv(id,count,transpose,m); }	
 #endif
 
 #ifdef _CY_VECTOR_H_INCLUDED_
-	void SetUniform(char const *name, Vec2<float>  const &p)              { glUseProgram(programID); int id = glGetUniformLocation( programID, name ); if ( id >= 0 ) glUniform2fv (id,1,    &p.x ); }
-	void SetUniform(char const *name, Vec3<float>  const &p)              { glUseProgram(programID); int id = glGetUniformLocation( programID, name ); if ( id >= 0 ) glUniform3fv (id,1,    &p.x ); }
-	void SetUniform(char const *name, Vec4<float>  const &p)              { glUseProgram(programID); int id = glGetUniformLocation( programID, name ); if ( id >= 0 ) glUniform4fv (id,1,    &p.x ); }
-	void SetUniform(char const *name, Vec2<int>    const &p)              { glUseProgram(programID); int id = glGetUniformLocation( programID, name ); if ( id >= 0 ) glUniform2iv (id,1,    &p.x ); }
-	void SetUniform(char const *name, Vec3<int>    const &p)              { glUseProgram(programID); int id = glGetUniformLocation( programID, name ); if ( id >= 0 ) glUniform3iv (id,1,    &p.x ); }
-	void SetUniform(char const *name, Vec4<int>    const &p)              { glUseProgram(programID); int id = glGetUniformLocation( programID, name ); if ( id >= 0 ) glUniform4iv (id,1,    &p.x ); }
-	void SetUniform(char const *name, Vec2<float>  const *p, int count=1) { glUseProgram(programID); int id = glGetUniformLocation( programID, name ); if ( id >= 0 ) glUniform2fv (id,count,&p->x); }
-	void SetUniform(char const *name, Vec3<float>  const *p, int count=1) { glUseProgram(programID); int id = glGetUniformLocation( programID, name ); if ( id >= 0 ) glUniform3fv (id,count,&p->x); }
-	void SetUniform(char const *name, Vec4<float>  const *p, int count=1) { glUseProgram(programID); int id = glGetUniformLocation( programID, name ); if ( id >= 0 ) glUniform4fv (id,count,&p->x); }
-	void SetUniform(char const *name, Vec2<int>    const *p, int count=1) { glUseProgram(programID); int id = glGetUniformLocation( programID, name ); if ( id >= 0 ) glUniform2iv (id,count,&p->x); }
-	void SetUniform(char const *name, Vec3<int>    const *p, int count=1) { glUseProgram(programID); int id = glGetUniformLocation( programID, name ); if ( id >= 0 ) glUniform3iv (id,count,&p->x); }
-	void SetUniform(char const *name, Vec4<int>    const *p, int count=1) { glUseProgram(programID); int id = glGetUniformLocation( programID, name ); if ( id >= 0 ) glUniform4iv (id,count,&p->x); }
+	void SetUniform(UniformName const &name, Vec2<float>  const &p)              { int id = PrepareUniform(name); if ( id >= 0 ) glUniform2fv (id,1,    &p.x ); }
+	void SetUniform(UniformName const &name, Vec3<float>  const &p)              { int id = PrepareUniform(name); if ( id >= 0 ) glUniform3fv (id,1,    &p.x ); }
+	void SetUniform(UniformName const &name, Vec4<float>  const &p)              { int id = PrepareUniform(name); if ( id >= 0 ) glUniform4fv (id,1,    &p.x ); }
+	void SetUniform(UniformName const &name, Vec2<int>    const &p)              { int id = PrepareUniform(name); if ( id >= 0 ) glUniform2iv (id,1,    &p.x ); }
+	void SetUniform(UniformName const &name, Vec3<int>    const &p)              { int id = PrepareUniform(name); if ( id >= 0 ) glUniform3iv (id,1,    &p.x ); }
+	void SetUniform(UniformName const &name, Vec4<int>    const &p)              { int id = PrepareUniform(name); if ( id >= 0 ) glUniform4iv (id,1,    &p.x ); }
+	void SetUniform(UniformName const &name, Vec2<float>  const *p, int count=1) { int id = PrepareUniform(name); if ( id >= 0 ) glUniform2fv (id,count,&p->x); }
+	void SetUniform(UniformName const &name, Vec3<float>  const *p, int count=1) { int id = PrepareUniform(name); if ( id >= 0 ) glUniform3fv (id,count,&p->x); }
+	void SetUniform(UniformName const &name, Vec4<float>  const *p, int count=1) { int id = PrepareUniform(name); if ( id >= 0 ) glUniform4fv (id,count,&p->x); }
+	void SetUniform(UniformName const &name, Vec2<int>    const *p, int count=1) { int id = PrepareUniform(name); if ( id >= 0 ) glUniform2iv (id,count,&p->x); }
+	void SetUniform(UniformName const &name, Vec3<int>    const *p, int count=1) { int id = PrepareUniform(name); if ( id >= 0 ) glUniform3iv (id,count,&p->x); }
+	void SetUniform(UniformName const &name, Vec4<int>    const *p, int count=1) { int id = PrepareUniform(name); if ( id >= 0 ) glUniform4iv (id,count,&p->x); }
 # ifdef GL_VERSION_3_0
-	void SetUniform(char const *name, Vec2<GLuint> const &p)              { glUseProgram(programID); int id = glGetUniformLocation( programID, name ); if ( id >= 0 ) glUniform2uiv(id,1,    &p.x ); }
-	void SetUniform(char const *name, Vec3<GLuint> const &p)              { glUseProgram(programID); int id = glGetUniformLocation( programID, name ); if ( id >= 0 ) glUniform3uiv(id,1,    &p.x ); }
-	void SetUniform(char const *name, Vec4<GLuint> const &p)              { glUseProgram(programID); int id = glGetUniformLocation( programID, name ); if ( id >= 0 ) glUniform4uiv(id,1,    &p.x ); }
-	void SetUniform(char const *name, Vec2<GLuint> const *p, int count=1) { glUseProgram(programID); int id = glGetUniformLocation( programID, name ); if ( id >= 0 ) glUniform2uiv(id,count,&p->x); }
-	void SetUniform(char const *name, Vec3<GLuint> const *p, int count=1) { glUseProgram(programID); int id = glGetUniformLocation( programID, name ); if ( id >= 0 ) glUniform3uiv(id,count,&p->x); }
-	void SetUniform(char const *name, Vec4<GLuint> const *p, int count=1) { glUseProgram(programID); int id = glGetUniformLocation( programID, name ); if ( id >= 0 ) glUniform4uiv(id,count,&p->x); }
+	void SetUniform(UniformName const &name, Vec2<GLuint> const &p)              { int id = PrepareUniform(name); if ( id >= 0 ) glUniform2uiv(id,1,    &p.x ); }
+	void SetUniform(UniformName const &name, Vec3<GLuint> const &p)              { int id = PrepareUniform(name); if ( id >= 0 ) glUniform3uiv(id,1,    &p.x ); }
+	void SetUniform(UniformName const &name, Vec4<GLuint> const &p)              { int id = PrepareUniform(name); if ( id >= 0 ) glUniform4uiv(id,1,    &p.x ); }
+	void SetUniform(UniformName const &name, Vec2<GLuint> const *p, int count=1) { int id = PrepareUniform(name); if ( id >= 0 ) glUniform2uiv(id,count,&p->x); }
+	void SetUniform(UniformName const &name, Vec3<GLuint> const *p, int count=1) { int id = PrepareUniform(name); if ( id >= 0 ) glUniform3uiv(id,count,&p->x); }
+	void SetUniform(UniformName const &name, Vec4<GLuint> const *p, int count=1) { int id = PrepareUniform(name); if ( id >= 0 ) glUniform4uiv(id,count,&p->x); }
 # endif
 # ifdef GL_VERSION_4_0
-	void SetUniform(char const *name, Vec2<double> const &p)              { glUseProgram(programID); int id = glGetUniformLocation( programID, name ); if ( id >= 0 ) glUniform2dv (id,1,    &p.x ); }
-	void SetUniform(char const *name, Vec3<double> const &p)              { glUseProgram(programID); int id = glGetUniformLocation( programID, name ); if ( id >= 0 ) glUniform3dv (id,1,    &p.x ); }
-	void SetUniform(char const *name, Vec4<double> const &p)              { glUseProgram(programID); int id = glGetUniformLocation( programID, name ); if ( id >= 0 ) glUniform4dv (id,1,    &p.x ); }
-	void SetUniform(char const *name, Vec2<double> const *p, int count=1) { glUseProgram(programID); int id = glGetUniformLocation( programID, name ); if ( id >= 0 ) glUniform2dv (id,count,&p->x); }
-	void SetUniform(char const *name, Vec3<double> const *p, int count=1) { glUseProgram(programID); int id = glGetUniformLocation( programID, name ); if ( id >= 0 ) glUniform3dv (id,count,&p->x); }
-	void SetUniform(char const *name, Vec4<double> const *p, int count=1) { glUseProgram(programID); int id = glGetUniformLocation( programID, name ); if ( id >= 0 ) glUniform4dv (id,count,&p->x); }
+	void SetUniform(UniformName const &name, Vec2<double> const &p)              { int id = PrepareUniform(name); if ( id >= 0 ) glUniform2dv (id,1,    &p.x ); }
+	void SetUniform(UniformName const &name, Vec3<double> const &p)              { int id = PrepareUniform(name); if ( id >= 0 ) glUniform3dv (id,1,    &p.x ); }
+	void SetUniform(UniformName const &name, Vec4<double> const &p)              { int id = PrepareUniform(name); if ( id >= 0 ) glUniform4dv (id,1,    &p.x ); }
+	void SetUniform(UniformName const &name, Vec2<double> const *p, int count=1) { int id = PrepareUniform(name); if ( id >= 0 ) glUniform2dv (id,count,&p->x); }
+	void SetUniform(UniformName const &name, Vec3<double> const *p, int count=1) { int id = PrepareUniform(name); if ( id >= 0 ) glUniform3dv (id,count,&p->x); }
+	void SetUniform(UniformName const &name, Vec4<double> const *p, int count=1) { int id = PrepareUniform(name); if ( id >= 0 ) glUniform4dv (id,count,&p->x); }
 # endif
 #endif
 
 #ifdef _CY_IVECTOR_H_INCLUDED_
-	void SetUniform(char const *name, IVec2<int>    const &p)              { glUseProgram(programID); int id = glGetUniformLocation( programID, name ); if ( id >= 0 ) glUniform2iv (id,1,    &p.x ); }
-	void SetUniform(char const *name, IVec3<int>    const &p)              { glUseProgram(programID); int id = glGetUniformLocation( programID, name ); if ( id >= 0 ) glUniform3iv (id,1,    &p.x ); }
-	void SetUniform(char const *name, IVec4<int>    const &p)              { glUseProgram(programID); int id = glGetUniformLocation( programID, name ); if ( id >= 0 ) glUniform4iv (id,1,    &p.x ); }
-	void SetUniform(char const *name, IVec2<int>    const *p, int count=1) { glUseProgram(programID); int id = glGetUniformLocation( programID, name ); if ( id >= 0 ) glUniform2iv (id,count,&p->x); }
-	void SetUniform(char const *name, IVec3<int>    const *p, int count=1) { glUseProgram(programID); int id = glGetUniformLocation( programID, name ); if ( id >= 0 ) glUniform3iv (id,count,&p->x); }
-	void SetUniform(char const *name, IVec4<int>    const *p, int count=1) { glUseProgram(programID); int id = glGetUniformLocation( programID, name ); if ( id >= 0 ) glUniform4iv (id,count,&p->x); }
+	void SetUniform(UniformName const &name, IVec2<int>    const &p)              { int id = PrepareUniform(name); if ( id >= 0 ) glUniform2iv (id,1,    &p.x ); }
+	void SetUniform(UniformName const &name, IVec3<int>    const &p)              { int id = PrepareUniform(name); if ( id >= 0 ) glUniform3iv (id,1,    &p.x ); }
+	void SetUniform(UniformName const &name, IVec4<int>    const &p)              { int id = PrepareUniform(name); if ( id >= 0 ) glUniform4iv (id,1,    &p.x ); }
+	void SetUniform(UniformName const &name, IVec2<int>    const *p, int count=1) { int id = PrepareUniform(name); if ( id >= 0 ) glUniform2iv (id,count,&p->x); }
+	void SetUniform(UniformName const &name, IVec3<int>    const *p, int count=1) { int id = PrepareUniform(name); if ( id >= 0 ) glUniform3iv (id,count,&p->x); }
+	void SetUniform(UniformName const &name, IVec4<int>    const *p, int count=1) { int id = PrepareUniform(name); if ( id >= 0 ) glUniform4iv (id,count,&p->x); }
 # ifdef GL_VERSION_3_0
-	void SetUniform(char const *name, IVec2<GLuint> const &p)              { glUseProgram(programID); int id = glGetUniformLocation( programID, name ); if ( id >= 0 ) glUniform2uiv(id,1,    &p.x ); }
-	void SetUniform(char const *name, IVec3<GLuint> const &p)              { glUseProgram(programID); int id = glGetUniformLocation( programID, name ); if ( id >= 0 ) glUniform3uiv(id,1,    &p.x ); }
-	void SetUniform(char const *name, IVec4<GLuint> const &p)              { glUseProgram(programID); int id = glGetUniformLocation( programID, name ); if ( id >= 0 ) glUniform4uiv(id,1,    &p.x ); }
-	void SetUniform(char const *name, IVec2<GLuint> const *p, int count=1) { glUseProgram(programID); int id = glGetUniformLocation( programID, name ); if ( id >= 0 ) glUniform2uiv(id,count,&p->x); }
-	void SetUniform(char const *name, IVec3<GLuint> const *p, int count=1) { glUseProgram(programID); int id = glGetUniformLocation( programID, name ); if ( id >= 0 ) glUniform3uiv(id,count,&p->x); }
-	void SetUniform(char const *name, IVec4<GLuint> const *p, int count=1) { glUseProgram(programID); int id = glGetUniformLocation( programID, name ); if ( id >= 0 ) glUniform4uiv(id,count,&p->x); }
+	void SetUniform(UniformName const &name, IVec2<GLuint> const &p)              { int id = PrepareUniform(name); if ( id >= 0 ) glUniform2uiv(id,1,    &p.x ); }
+	void SetUniform(UniformName const &name, IVec3<GLuint> const &p)              { int id = PrepareUniform(name); if ( id >= 0 ) glUniform3uiv(id,1,    &p.x ); }
+	void SetUniform(UniformName const &name, IVec4<GLuint> const &p)              { int id = PrepareUniform(name); if ( id >= 0 ) glUniform4uiv(id,1,    &p.x ); }
+	void SetUniform(UniformName const &name, IVec2<GLuint> const *p, int count=1) { int id = PrepareUniform(name); if ( id >= 0 ) glUniform2uiv(id,count,&p->x); }
+	void SetUniform(UniformName const &name, IVec3<GLuint> const *p, int count=1) { int id = PrepareUniform(name); if ( id >= 0 ) glUniform3uiv(id,count,&p->x); }
+	void SetUniform(UniformName const &name, IVec4<GLuint> const *p, int count=1) { int id = PrepareUniform(name); if ( id >= 0 ) glUniform4uiv(id,count,&p->x); }
 # endif
 #endif
 
 #ifdef _CY_MATRIX_H_INCLUDED_
-	void SetUniform(char const *name, Matrix2 <float>  const &m)              { glUseProgram(programID); int id = glGetUniformLocation( programID, name ); if ( id >= 0 ) glUniformMatrix2fv  (id,1,    GL_FALSE,m.cell ); }
-	void SetUniform(char const *name, Matrix3 <float>  const &m)              { glUseProgram(programID); int id = glGetUniformLocation( programID, name ); if ( id >= 0 ) glUniformMatrix3fv  (id,1,    GL_FALSE,m.cell ); }
-	void SetUniform(char const *name, Matrix4 <float>  const &m)              { glUseProgram(programID); int id = glGetUniformLocation( programID, name ); if ( id >= 0 ) glUniformMatrix4fv  (id,1,    GL_FALSE,m.cell ); }
-	void SetUniform(char const *name, Matrix2 <float>  const *m, int count=1) { glUseProgram(programID); int id = glGetUniformLocation( programID, name ); if ( id >= 0 ) glUniformMatrix2fv  (id,count,GL_FALSE,m->cell); }
-	void SetUniform(char const *name, Matrix3 <float>  const *m, int count=1) { glUseProgram(programID); int id = glGetUniformLocation( programID, name ); if ( id >= 0 ) glUniformMatrix3fv  (id,count,GL_FALSE,m->cell); }
-	void SetUniform(char const *name, Matrix4 <float>  const *m, int count=1) { glUseProgram(programID); int id = glGetUniformLocation( programID, name ); if ( id >= 0 ) glUniformMatrix4fv  (id,count,GL_FALSE,m->cell); }
+	void SetUniform(UniformName const &name, Matrix2 <float>  const &m)              { int id = PrepareUniform(name); if ( id >= 0 ) glUniformMatrix2fv  (id,1,    GL_FALSE,m.cell ); }
+	void SetUniform(UniformName const &name, Matrix3 <float>  const &m)              { int id = PrepareUniform(name); if ( id >= 0 ) glUniformMatrix3fv  (id,1,    GL_FALSE,m.cell ); }
+	void SetUniform(UniformName const &name, Matrix4 <float>  const &m)              { int id = PrepareUniform(name); if ( id >= 0 ) glUniformMatrix4fv  (id,1,    GL_FALSE,m.cell ); }
+	void SetUniform(UniformName const &name, Matrix2 <float>  const *m, int count=1) { int id = PrepareUniform(name); if ( id >= 0 ) glUniformMatrix2fv  (id,count,GL_FALSE,m->cell); }
+	void SetUniform(UniformName const &name, Matrix3 <float>  const *m, int count=1) { int id = PrepareUniform(name); if ( id >= 0 ) glUniformMatrix3fv  (id,count,GL_FALSE,m->cell); }
+	void SetUniform(UniformName const &name, Matrix4 <float>  const *m, int count=1) { int id = PrepareUniform(name); if ( id >= 0 ) glUniformMatrix4fv  (id,count,GL_FALSE,m->cell); }
 # ifdef GL_VERSION_2_1
-	void SetUniform(char const *name, Matrix34<float>  const &m)              { glUseProgram(programID); int id = glGetUniformLocation( programID, name ); if ( id >= 0 ) glUniformMatrix3x4fv(id,1,    GL_FALSE,m.cell ); }
-	void SetUniform(char const *name, Matrix34<float>  const *m, int count=1) { glUseProgram(programID); int id = glGetUniformLocation( programID, name ); if ( id >= 0 ) glUniformMatrix3x4fv(id,count,GL_FALSE,m->cell); }
+	void SetUniform(UniformName const &name, Matrix34<float>  const &m)              { int id = PrepareUniform(name); if ( id >= 0 ) glUniformMatrix3x4fv(id,1,    GL_FALSE,m.cell ); }
+	void SetUniform(UniformName const &name, Matrix34<float>  const *m, int count=1) { int id = PrepareUniform(name); if ( id >= 0 ) glUniformMatrix3x4fv(id,count,GL_FALSE,m->cell); }
 # endif
 # ifdef GL_VERSION_4_0
-	void SetUniform(char const *name, Matrix2 <double> const &m)              { glUseProgram(programID); int id = glGetUniformLocation( programID, name ); if ( id >= 0 ) glUniformMatrix2dv  (id,1,    GL_FALSE,m.cell ); }
-	void SetUniform(char const *name, Matrix3 <double> const &m)              { glUseProgram(programID); int id = glGetUniformLocation( programID, name ); if ( id >= 0 ) glUniformMatrix3dv  (id,1,    GL_FALSE,m.cell ); }
-	void SetUniform(char const *name, Matrix4 <double> const &m)              { glUseProgram(programID); int id = glGetUniformLocation( programID, name ); if ( id >= 0 ) glUniformMatrix4dv  (id,1,    GL_FALSE,m.cell ); }
-	void SetUniform(char const *name, Matrix34<double> const &m)              { glUseProgram(programID); int id = glGetUniformLocation( programID, name ); if ( id >= 0 ) glUniformMatrix3x4dv(id,1,    GL_FALSE,m.cell ); }
-	void SetUniform(char const *name, Matrix2 <double> const *m, int count=1) { glUseProgram(programID); int id = glGetUniformLocation( programID, name ); if ( id >= 0 ) glUniformMatrix2dv  (id,count,GL_FALSE,m->cell); }
-	void SetUniform(char const *name, Matrix3 <double> const *m, int count=1) { glUseProgram(programID); int id = glGetUniformLocation( programID, name ); if ( id >= 0 ) glUniformMatrix3dv  (id,count,GL_FALSE,m->cell); }
-	void SetUniform(char const *name, Matrix4 <double> const *m, int count=1) { glUseProgram(programID); int id = glGetUniformLocation( programID, name ); if ( id >= 0 ) glUniformMatrix4dv  (id,count,GL_FALSE,m->cell); }
-	void SetUniform(char const *name, Matrix34<double> const *m, int count=1) { glUseProgram(programID); int id = glGetUniformLocation( programID, name ); if ( id >= 0 ) glUniformMatrix3x4dv(id,count,GL_FALSE,m->cell); }
+	void SetUniform(UniformName const &name, Matrix2 <double> const &m)              { int id = PrepareUniform(name); if ( id >= 0 ) glUniformMatrix2dv  (id,1,    GL_FALSE,m.cell ); }
+	void SetUniform(UniformName const &name, Matrix3 <double> const &m)              { int id = PrepareUniform(name); if ( id >= 0 ) glUniformMatrix3dv  (id,1,    GL_FALSE,m.cell ); }
+	void SetUniform(UniformName const &name, Matrix4 <double> const &m)              { int id = PrepareUniform(name); if ( id >= 0 ) glUniformMatrix4dv  (id,1,    GL_FALSE,m.cell ); }
+	void SetUniform(UniformName const &name, Matrix34<double> const &m)              { int id = PrepareUniform(name); if ( id >= 0 ) glUniformMatrix3x4dv(id,1,    GL_FALSE,m.cell ); }
+	void SetUniform(UniformName const &name, Matrix2 <double> const *m, int count=1) { int id = PrepareUniform(name); if ( id >= 0 ) glUniformMatrix2dv  (id,count,GL_FALSE,m->cell); }
+	void SetUniform(UniformName const &name, Matrix3 <double> const *m, int count=1) { int id = PrepareUniform(name); if ( id >= 0 ) glUniformMatrix3dv  (id,count,GL_FALSE,m->cell); }
+	void SetUniform(UniformName const &name, Matrix4 <double> const *m, int count=1) { int id = PrepareUniform(name); if ( id >= 0 ) glUniformMatrix4dv  (id,count,GL_FALSE,m->cell); }
+	void SetUniform(UniformName const &name, Matrix34<double> const *m, int count=1) { int id = PrepareUniform(name); if ( id >= 0 ) glUniformMatrix3x4dv(id,count,GL_FALSE,m->cell); }
 # endif
 #endif
 	//!@}
@@ -1154,8 +1176,8 @@ public:
 	{
 		friend GLSLProgram;
 		GLSLProgram &prog;
-		char const *name;
-		Param(GLSLProgram &p, char const *n) : prog(p), name(n) {}
+		UniformName name;
+		Param(GLSLProgram &p, UniformName const &n) : prog(p), name(n) {}
 	public:
 		template <typename T> void operator = ( T const &v ) { prog.SetUniform( name, v ); }
 		template <typename T> void Set ( T const &x ) { prog.SetUniform( name, x ); }
@@ -1168,7 +1190,18 @@ public:
 		template <typename T> void Set4( T const *v, int count=1 ) { prog.SetUniform4( name, v, count ); }
 	};
 
-	Param operator [] ( char const *name ) { return Param(*this,name); }
+	Param operator [] ( UniformName const &name ) { return Param(*this,name); }
+
+	//! Binds the program if it is not the program bound last, and returns the location of the uniform parameter with the given name.
+	//! Returns -1 if the program has no such uniform parameter.
+	GLint PrepareUniform( UniformName const &name );
+
+private:
+	void  CacheUniforms();
+	void  InsertUniform( uint64_t hash, GLint location );
+	GLint FindUniform  ( uint64_t hash ) const;
+
+public:
 
 
 	GLint AttribLocation( char const *name ) const { return glGetAttribLocation( programID, name ); }
@@ -1181,8 +1214,71 @@ public:
 	}
 	void EnableAttrib ( char const *name ) { glEnableVertexAttribArray ( AttribLocation(name) ); }
 	void DisableAttrib( char const *name ) { glDisableVertexAttribArray( AttribLocation(name) ); }
+
+#ifdef GL_VERSION_3_1
+	//! Connects the uniform block with the given name to a uniform buffer binding point, such as the one a GLUniformBuffer is bound to.
+	//! Returns false if the program has no active uniform block with that name.
+	bool SetUniformBlockBinding( char const *blockName, GLuint bindingPoint )
+	{
+		GLuint blockIndex = glGetUniformBlockIndex( programID, blockName );
+		if ( blockIndex == GL_INVALID_INDEX ) return false;
+		glUniformBlockBinding( programID, blockIndex, bindingPoint );
+		return true;
+	}
+#endif
 };
 
+//-------------------------------------------------------------------------------
+
+#ifdef GL_VERSION_3_1
+
+//! OpenGL uniform buffer holding one object of type T.
+//!
+//! T must have the std140 layout of the uniform block it is used for. In std140, vec3 and vec4 members
+//! start at multiples of 16 bytes, so a float can follow a vec3 but a vec3 cannot follow a vec3 without padding,
+//! matrices are column-major with 16 bytes per column, and the size of the block is a multiple of 16 bytes.
+//! The buffer is bound to a binding point once, and every program connects its block to that binding point
+//! using GLSLProgram::SetUniformBlockBinding, so a single Set call updates the block for all programs.
+
+template <typename T>
+class GLUniformBuffer
+{
+	static_assert( sizeof(T) % 16 == 0, "the size of a std140 uniform block is a multiple of 16 bytes" );
+private:
+	GLuint bufferID;	//!< The buffer ID
+
+public:
+	GLUniformBuffer() : bufferID(CY_GL_INVALID_ID) {}					//!< Constructor
+	~GLUniformBuffer() { if ( GL::CheckContext() ) Delete(); }			//!< Destructor that deletes the buffer
+
+	void   Delete() { if ( bufferID != CY_GL_INVALID_ID ) { glDeleteBuffers(1,&bufferID); bufferID = CY_GL_INVALID_ID; } }	//!< Deletes the buffer.
+	GLuint GetID () const { return bufferID; }							//!< Returns the buffer ID
+	bool   IsNull() const { return bufferID == CY_GL_INVALID_ID; }		//!< Returns true if the buffer is not generated, i.e. the buffer id is invalid.
+
+	//! Generates the buffer with storage for one T and binds it to the given uniform buffer binding point.
+	void Initialize( GLuint bindingPoint )
+	{
+		Delete();
+		glGenBuffers( 1, &bufferID );
+		glBindBuffer( GL_UNIFORM_BUFFER, bufferID );
+		glBufferData( GL_UNIFORM_BUFFER, sizeof(T), nullptr, GL_DYNAMIC_DRAW );
+		Bind( bindingPoint );
+	}
+
+	void Bind( GLuint bindingPoint ) const { glBindBufferBase( GL_UNIFORM_BUFFER, bindingPoint, bufferID ); }	//!< Binds the buffer to the given uniform buffer binding point.
+
+	//! Replaces the contents of the buffer with a single update.
+	void Set( T const &data )
+	{
+		glBindBuffer( GL_UNIFORM_BUFFER, bufferID );
+		glBufferSubData( GL_UNIFORM_BUFFER, 0, sizeof(T), &data );
+	}
+};
+
+//-------------------------------------------------------------------------------
+
+#endif // GL_VERSION_3_1
+
 //-------------------------------------------------------------------------------
 // Implementation of GL
 //-------------------------------------------------------------------------------
@@ -1580,9 +1676,76 @@ inline bool GLSLProgram::Link( std::ostream *outStream )
 		if ( outStream ) *outStream << "ERROR: " << compilerMessage.data() << std::endl;
 	}
 
+	// relinking may change every location
+	uniformTable.clear();
+	uniformCount = 0;
+	if ( result == GL_TRUE ) CacheUniforms();
+
 	return result == GL_TRUE;
 }
 
+inline void GLSLProgram::CacheUniforms()
+{
+	GLint count = 0, maxLength = 0;
+	glGetProgramiv(programID, GL_ACTIVE_UNIFORMS, &count);
+	glGetProgramiv(programID, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxLength);
+	std::vector<char> name(maxLength+1);
+	for ( GLint i=0; i<count; i++ ) {
+		GLint size;
+		GLenum type;
+		glGetActiveUniform( programID, i, (GLsizei)name.size(), nullptr, &size, &type, name.data() );
+		GLint location = glGetUniformLocation( programID, name.data() );
+		if ( location < 0 ) continue;	// members of uniform blocks have no location
+		InsertUniform( UniformName::Hash(name.data()), location );
+		// arrays are reported as "name[0]", but can be set by their name alone as well
+		std::string arrayName(name.data());
+		if ( arrayName.size() > 3 && arrayName.compare( arrayName.size()-3, 3, "[0]" ) == 0 ) {
+			arrayName.resize( arrayName.size()-3 );
+			InsertUniform( UniformName::Hash(arrayName.c_str()), location );
+		}
+	}
+}
+
+inline void GLSLProgram::InsertUniform( uint64_t hash, GLint location )
+{
+	// keep the table at most half full
+	if ( (uniformCount+1)*2 > uniformTable.size() ) {
+		std::vector<UniformSlot> old;
+		old.swap(uniformTable);
+		uniformTable.assign( old.empty() ? 64 : old.size()*2, UniformSlot{0,-1} );
+		uniformCount = 0;
+		for ( UniformSlot const &slot : old ) if ( slot.hash ) InsertUniform( slot.hash, slot.location );
+	}
+	size_t mask = uniformTable.size()-1;
+	size_t i = (size_t)hash & mask;
+	while ( uniformTable[i].hash && uniformTable[i].hash != hash ) i = (i+1) & mask;
+	if ( ! uniformTable[i].hash ) uniformCount++;
+	uniformTable[i] = UniformSlot{ hash, location };
+}
+
+inline GLint GLSLProgram::FindUniform( uint64_t hash ) const
+{
+	if ( uniformTable.empty() ) return -2;
+	size_t mask = uniformTable.size()-1;
+	for ( size_t i = (size_t)hash & mask; uniformTable[i].hash; i = (i+1) & mask ) {
+		if ( uniformTable[i].hash == hash ) return uniformTable[i].location;
+	}
+	return -2;
+}
+
+inline GLint GLSLProgram::PrepareUniform( UniformName const &name )
+{
+	if ( BoundProgram() != programID ) Bind();
+	GLint id = FindUniform( name.hash );
+	if ( id == -2 ) {
+		// not in the table under this name, e.g. an array element past the first one
+		// the result is kept, -1 included, so that the name is not queried again
+		id = glGetUniformLocation( programID, name.name );
+		InsertUniform( name.hash, id );
+	}
+	return id;
+}
+
 inline bool GLSLProgram::Build( GLSLShader const *vertexShader, 
                                 GLSLShader const *fragmentShader,
 	                            GLSLShader const *geometryShader,
@@ -14,9 +14,19 @@
 #include <vector>
 #include <map>
 #include <string>
+#include <span>
+#include <stddef.h>
 #include <GL/glew.h>
+#ifdef _WIN32
+#include <GL/wglew.h>
+#endif
 #include <GL/freeglut.h>
 #include <numbers>
+#include <chrono>
+#include <thread>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
 #include "GLInitializations.h"
 #include "CyCodeBase/cyTriMesh.h"
 #include "CyCodeBase/cyCore.h"
@@ -30,6 +40,18 @@
 #include "glm/vec3.hpp"
 #include "glm/mat4x4.hpp"
 #include "Mesh/Mesh.h"
+#include "Noise/PerlinNoise.h"
+#include "Noise/NoiseEngine.h"
+#include "Terrain/ChunkManager.h"
+#include "Terrain/CdlodTerrain.h"
+#include "Terrain/HeightQuadtree.h"
+#include "Terrain/TerrainCuller.h"
+#include "Terrain/Frustum.h"
+#include "Terrain/TerrainRefiner.h"
+#include "Rendering/RenderScheduler.h"
+#include "Rendering/FrameProfiler.h"
+#include "Rendering/CameraPath.h"
+#include "Rendering/HeadlessContext.h"
 
 void createOpenGLWindow(int width, int height);
 void drawNewFrame();
@@ -39,28 +61,104 @@ void mouseClickDrag(int x, int y);
 void specialInput(int key, int x, int y);
 void idleCallback();
 Mesh** createSceneTerrain(GLuint& terrainVao, int mapSize);
+void createTerrainBounds(int mapSize);
+void deleteSceneTerrain();
+void setTerrainUniforms();
+bool swapInRefinedTerrain();
+void reportFirstFrame();
 void setRotationAndDistance(float& xRot, float& yRot, float& zRot);
 float DEG2RAD(float degrees);
 float RAD2DEG(float radians);
 void drawPoint(float x, float y, float z);
+void drawTerrainPatches();
+void requestRedraw(unsigned int changes);
+void presentFrame();
+void applySwapInterval();
+void updateFrame();
+void renderTerrain();
+void parseSceneOptions(int argc, char* argv[]);
+struct BenchmarkOptions;
+bool parseBenchmarkOptions(int argc, char* argv[], BenchmarkOptions& options);
+int runHeadlessBenchmark(const BenchmarkOptions& options);
+bool saveFrame(const cy::GLRenderTexture2D& target, int width, int height, const std::string& path);
+
+// how the terrain is kept and drawn
+enum class TerrainMode
+{
+	SingleMap,    // one mapSize map, every triangle at full resolution
+	Streamed,     // endless tiles around the camera, see ChunkManager
+	Cdlod,        // one heightmap map drawn with distance based LOD, see CdlodTerrain
+};
+
+// std140 layout of the FrameUniforms block in Shaders/shader.tessc, shader.tesse and shader.frag
+struct FrameUniforms
+{
+	cy::Matrix4f view;
+	cy::Matrix4f projection;
+	cy::Vec3f viewPos;
+	float viewportHeight;
+	cy::Vec3f lightPos;
+	float padding;
+};
+static_assert(sizeof(FrameUniforms) == 160, "FrameUniforms has to match the std140 block");
+const GLuint FRAME_UNIFORMS_BINDING = 0;
+
+// command line of the headless benchmark, see parseBenchmarkOptions()
+struct BenchmarkOptions
+{
+	unsigned int frames = 600;    // per tessellation level, once around the camera path
+	std::vector<unsigned short> tessLevels = { 8, 16, 32 };
+	int width = 1280;
+	int height = 720;
+	std::string saveDirectory;    // empty saves no frames
+	unsigned int saveEvery = 30;    // frames between two saved images
+};
+
+// sections of frameProfiler, added in this order by main()
+enum ProfileSection
+{
+	ProfileUpdate,     // matrices and uniforms in idleCallback(), CPU only
+	ProfileTerrain,    // tile streaming, CDLOD selection or culling, and their uploads
+	ProfileWirePass,
+	ProfilePlanePass,
+};
 
 bool leftMouse, GeoMeshToggle;
 float movementSpeed;
 int mouseX, mouseY;
 int windowWidth, windowHeight;
 unsigned short int tessLevel;
+bool adaptiveTess;
 float tColor;
 float shading;
 GLuint terrainVao;
 cy::GLSLProgram planeShaders;
 cy::GLSLProgram wireMeshShaders;
 Mesh terrain;
+TerrainVertexLayout terrainLayout;
+TerrainMode terrainMode;
+ChunkManager* terrainChunks;
+HeightQuadtree terrainBounds;
+TerrainCuller terrainCuller;
+IndirectDrawBuffer terrainDraws;    // visible ranges of the last cull, drawn by both passes
+Frustum terrainFrustum;    // in terrain space, rebuilt by idleCallback()
+cy::GLUniformBuffer<FrameUniforms> frameUniforms;    // uploaded once per frame by idleCallback()
+RenderScheduler frameScheduler;    // frames are only drawn after input or while tiles stream in
+FrameProfiler frameProfiler;    // off until 'f' is pressed
+CdlodTerrain* cdlodTerrain;
+TerrainRefiner* terrainRefiner;    // finer levels of the single map or CDLOD map, null once the full map is in
+unsigned int terrainGridSize;    // vertices along one side of the level in terrain
+float terrainWidth;    // world width of the full resolution map, the map is centered on it whatever level is in
+std::vector<GLuint> sceneTerrainBuffers;    // GL objects of createSceneTerrain() and createTerrainBounds()
+std::vector<GLuint> sceneTerrainTextures;
+std::chrono::steady_clock::time_point startupTime;    // for the time to the first frame
 cy::Vec3f camPos;
 cy::Vec3f cameraFront;
 
 
 int main(int argc, char* argv[])
 {
+	startupTime = std::chrono::steady_clock::now();
 
 	/**
 	*
@@ -74,21 +172,37 @@ int main(int argc, char* argv[])
 	mouseX = 0; mouseY = 0;
 	int mapSize = 600;    // this sets the side length of the terrain to be generated
 	movementSpeed = 3.0f;
-	tessLevel = 1.0;
+	tessLevel = 32;    // with adaptiveTess only the closest and roughest edges reach it
+	adaptiveTess = true;
 	camPos = cy::Vec3f(0.0f, 300.0f, 0.0f);
-
-	// Initialize FreeGLUT
-	glutInit(&argc, argv);
-	glutInitContextVersion(4, 5);
-	glutInitContextFlags(GLUT_DEBUG);
-
-	// initalize a new window
-	windowWidth = 1920;
-	windowHeight = 1080;
-	createOpenGLWindow(windowWidth, windowHeight);
+	terrainLayout = TerrainVertexLayout::Packed;    // Float keeps the old 40 B per vertex arrays, Heightmap only 2 B
+	terrainMode = TerrainMode::SingleMap;    // --terrain picks another, Streamed always uses the packed layout, Cdlod the heightmap layout
+	terrainRefiner = nullptr;
+
+	// --headless renders a fixed camera path offscreen instead of opening the interactive window
+	parseSceneOptions(argc, argv);
+	BenchmarkOptions benchmark;
+	bool headless = parseBenchmarkOptions(argc, argv, benchmark);
+	HeadlessContext headlessContext;
+	bool windowless = headless && headlessContext.create(4, 5);
+
+	windowWidth = headless ? benchmark.width : 1920;
+	windowHeight = headless ? benchmark.height : 1080;
+	if (!windowless)
+	{
+		// Initialize FreeGLUT
+		glutInit(&argc, argv);
+		glutInitContextVersion(4, 5);
+		glutInitContextFlags(GLUT_DEBUG);
+
+		// initalize a new window, without EGL the headless benchmark draws offscreen from a hidden one
+		createOpenGLWindow(windowWidth, windowHeight);
+		if (headless) { glutHideWindow(); }
+	}
 
 	//initialize glew
-	GLenum res = glewInit();
+	// glewInit() also wants the window system's context (WGL, GLX), which an EGL context does not have
+	GLenum res = windowless ? glewContextInit() : glewInit();
 	// Error code sourced from: https://youtu.be/6dtqg0r28Yc
 	if (res != GLEW_OK) {
 		fprintf(stderr, "Error: '%s'\n", glewGetErrorString(res));
@@ -96,18 +210,36 @@ int main(int argc, char* argv[])
 	}
 
 	CY_GL_REGISTER_DEBUG_CALLBACK;
+	if (windowless)
+	{
+		glEnable(GL_DEPTH_TEST);
+		std::cout << "Current OpenGL version: " << (const char*)glGetString(GL_VERSION) << "\n";
+	}
+
+	// 'v' cycles through the pacing modes
+	frameScheduler.setPacing(FramePacing::VSync, 60.0);
+	applySwapInterval();
+
+	// 'f' switches timing on and off
+	frameProfiler.addSection("update", false);
+	frameProfiler.addSection("terrain", true);
+	frameProfiler.addSection("wire pass", true);
+	frameProfiler.addSection("plane pass", true);
 
 	/**
 	*
 	* Register functiuons for GLUT
 	*
 	**/
-	glutDisplayFunc(drawNewFrame);
-	glutKeyboardFunc(keyboardInterrupt);
-	glutIdleFunc(idleCallback);
-	glutMouseFunc(mouseButtonTracker);
-	glutMotionFunc(mouseClickDrag);
-	glutSpecialFunc(specialInput);
+	if (!headless)
+	{
+		glutDisplayFunc(drawNewFrame);
+		glutKeyboardFunc(keyboardInterrupt);
+		glutIdleFunc(idleCallback);
+		glutMouseFunc(mouseButtonTracker);
+		glutMotionFunc(mouseClickDrag);
+		glutSpecialFunc(specialInput);
+	}
 
 	// OpenGL initializations
 	GLclampf Red = 0.3f, Green = 0.4f, Blue = 1.0f, Alpha = 0.0f; // sourced from: https://youtu.be/6dtqg0r28Yc
@@ -120,11 +252,54 @@ int main(int argc, char* argv[])
 	*
 	**/
 	// createScenePlane(terrainVao, mapSize);   - deprecated for now
-	std::cout << "Generating Terrain..." << std::endl;
-
-	terrain = Mesh();
-	terrain.generateVertices(mapSize, mapSize);
-	createSceneTerrain(terrainVao, mapSize);
+	if (terrainMode == TerrainMode::Streamed)
+	{
+		// tiles are generated in the background from the first frame on
+		terrainLayout = TerrainVertexLayout::Packed;
+		terrainChunks = new ChunkManager();
+	}
+	else if (terrainMode == TerrainMode::Cdlod)
+	{
+		// far away nodes are drawn coarser, so a much larger map costs about the same per frame
+		// a coarse preview is drawn until swapInRefinedTerrain() swaps the finer levels in
+		std::cout << "Generating Terrain..." << std::endl;
+		mapSize = 2049;
+		terrainLayout = TerrainVertexLayout::Heightmap;
+		// the preview hands its reference height to the finer levels, on a warm start it comes from the cache
+		ThreadPool previewPool;
+		TileCache levelCache(ChunkSettings().cacheDirectory);
+		float referenceHeight = 0;
+		terrainWidth = TerrainRefiner::mapWidth(mapSize);
+		terrain = Mesh();
+		if (TerrainRefiner::generateLevel(terrain, mapSize, terrainLayout, 16, referenceHeight, previewPool, levelCache))
+		{
+			std::cout << "Preview loaded from cache" << std::endl;
+		}
+		terrainGridSize = TerrainRefiner::levelSize(mapSize, 16);
+		cdlodTerrain = new CdlodTerrain();
+		cdlodTerrain->create(terrain, terrainGridSize, terrainGridSize);
+		terrainRefiner = new TerrainRefiner(mapSize, terrainLayout, { 4, 1 }, referenceHeight, ChunkSettings().cacheDirectory);
+	}
+	else
+	{
+		// a coarse preview is drawn until swapInRefinedTerrain() swaps the finer levels in
+		std::cout << "Generating Terrain..." << std::endl;
+
+		// the preview hands its reference height to the finer levels, on a warm start it comes from the cache
+		ThreadPool previewPool;
+		TileCache levelCache(ChunkSettings().cacheDirectory);
+		float referenceHeight = 0;
+		terrainWidth = TerrainRefiner::mapWidth(mapSize);
+		terrain = Mesh();
+		if (TerrainRefiner::generateLevel(terrain, mapSize, terrainLayout, 8, referenceHeight, previewPool, levelCache))
+		{
+			std::cout << "Preview loaded from cache" << std::endl;
+		}
+		terrainGridSize = TerrainRefiner::levelSize(mapSize, 8);
+		createTerrainBounds(terrainGridSize);
+		createSceneTerrain(terrainVao, terrainGridSize);
+		terrainRefiner = new TerrainRefiner(mapSize, terrainLayout, { 2, 1 }, referenceHeight, ChunkSettings().cacheDirectory);
+	}
 	// createScenePlane(terrainVao, mapSize);
 	std::cout << "Done" << std::endl;
 
@@ -135,25 +310,38 @@ int main(int argc, char* argv[])
 	*
 	**/
 	// initialize CyGL
-	planeShaders.BuildFiles("Shaders\\passthrough.vert",
-		"Shaders\\shader.frag",
+	const char* terrainVertShader = "Shaders/passthrough.vert";
+	if (terrainLayout == TerrainVertexLayout::Packed) { terrainVertShader = "Shaders/PackedTerrain.vert"; }
+	if (terrainLayout == TerrainVertexLayout::Heightmap) { terrainVertShader = "Shaders/HeightmapTerrain.vert"; }
+	if (terrainMode == TerrainMode::Cdlod) { terrainVertShader = "Shaders/CdlodTerrain.vert"; }
+	planeShaders.BuildFiles(terrainVertShader,
+		"Shaders/shader.frag",
 		(const char*)nullptr,
-		"Shaders\\shader.tessc",
-		"Shaders\\shader.tesse"
+		"Shaders/shader.tessc",
+		"Shaders/shader.tesse"
 	);
-	wireMeshShaders.BuildFiles("Shaders\\passthrough.vert",
-		"Shaders\\SimpleTexture.frag",
-		"Shaders\\wire.geom",
-		"Shaders\\shader.tessc",
-		"Shaders\\shader.tesse"
+	wireMeshShaders.BuildFiles(terrainVertShader,
+		"Shaders/SimpleTexture.frag",
+		"Shaders/wire.geom",
+		"Shaders/shader.tessc",
+		"Shaders/shader.tesse"
 	);
 
+	// camera and light are shared by both programs
+	frameUniforms.Initialize(FRAME_UNIFORMS_BINDING);
+	planeShaders.SetUniformBlockBinding("FrameUniforms", FRAME_UNIFORMS_BINDING);
+	wireMeshShaders.SetUniformBlockBinding("FrameUniforms", FRAME_UNIFORMS_BINDING);
+
+	setTerrainUniforms();
+
 	// specify patches for tesselations
 	glPatchParameteri(GL_PATCH_VERTICES, 3);
 
-	// clear scene
-	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+	// clear scene, an EGL context has no default frame buffer to clear
+	if (!windowless) { glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT); }
+
 
+	if (headless) { return runHeadlessBenchmark(benchmark); }
 
 	std::cout << "Finished drawing first frame. Entering main loop\n";
 	char t;
@@ -182,28 +370,95 @@ int main(int argc, char* argv[])
 *
 **/
 void drawNewFrame()
+{
+	renderTerrain();
+	presentFrame();
+}
+
+
+/**
+*
+* Draw the terrain of the current terrainMode with the uniforms of the last updateFrame(), without swapping buffers
+*
+**/
+void renderTerrain()
 {
 	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 	// render plane under argument object (also used for testing as a plane to render depth map to)
 
+	if (terrainMode == TerrainMode::Streamed)
+	{
+		{
+			// uploads finished tiles and requests new ones, never waits for generation
+			ProfileScope scope(frameProfiler, ProfileTerrain);
+			terrainChunks->update(camPos, terrainFrustum);
+		}
+		if (GeoMeshToggle)
+		{
+			ProfileScope scope(frameProfiler, ProfileWirePass);
+			wireMeshShaders.Bind();
+			terrainChunks->draw(wireMeshShaders);
+		}
+		{
+			ProfileScope scope(frameProfiler, ProfilePlanePass);
+			planeShaders.Bind();
+			terrainChunks->draw(planeShaders);
+		}
+		return;
+	}
+
+	if (terrainMode == TerrainMode::Cdlod)
+	{
+		// nodes are picked once per frame in terrain space, the model matrix only centers the map
+		{
+			ProfileScope scope(frameProfiler, ProfileTerrain);
+			float halfWidth = terrainWidth / 2;
+			cdlodTerrain->select(camPos + cy::Vec3f(halfWidth, 0.0f, halfWidth), terrainFrustum);
+		}
+		if (GeoMeshToggle)
+		{
+			ProfileScope scope(frameProfiler, ProfileWirePass);
+			wireMeshShaders.Bind();
+			cdlodTerrain->draw(wireMeshShaders);
+		}
+		{
+			ProfileScope scope(frameProfiler, ProfilePlanePass);
+			planeShaders.Bind();
+			cdlodTerrain->draw(planeShaders);
+		}
+		return;
+	}
+
 	glBindVertexArray(terrainVao);
-	int numVerts = terrain.getVertices().size();
+	// once for both passes, the heightmap layout has no index buffer to draw the visible patches from
+	if (terrain.getVertexLayout() != TerrainVertexLayout::Heightmap)
+	{
+		ProfileScope scope(frameProfiler, ProfileTerrain);
+		terrainCuller.cull(terrainFrustum);
+		terrainDraws.clear();
+		for (const IndexRange& range : terrainCuller.visibleRanges())
+		{
+			terrainDraws.add(range.count, range.first, 0, 0);
+		}
+		terrainDraws.upload();
+	}
 
 	if (GeoMeshToggle)
 	{
 		// draw triangulation plane
+		ProfileScope scope(frameProfiler, ProfileWirePass);
 		wireMeshShaders.Bind();
-		glDrawArrays(GL_PATCHES, 0, numVerts);
+		drawTerrainPatches();
 	}
 
-	// draw plane normally
-	planeShaders.Bind();
-	glDrawArrays(GL_PATCHES, 0, numVerts);
+	{
+		// draw plane normally
+		ProfileScope scope(frameProfiler, ProfilePlanePass);
+		planeShaders.Bind();
+		drawTerrainPatches();
+	}
 
 	// drawPoint(2, 0, 2);
-
-	glutSwapBuffers();
-	return;
 }
 
 
@@ -221,6 +476,8 @@ void keyboardInterrupt(unsigned char key, int x, int y)
 {
 	// used for calculating right and left
 	cy::Vec3f up(0.0f, 1.0f, 0.0f);
+	// keys without a binding change nothing and draw no frame
+	unsigned int changes = 0;
 
 	switch (tolower(key)) {
 	case 27:    // escape key
@@ -229,38 +486,69 @@ void keyboardInterrupt(unsigned char key, int x, int y)
 		break;
 	case 32:    // spacebar
 		camPos.y += movementSpeed;
+		changes = RenderScheduler::Camera;
 		break;
 	case 'w':
 		camPos += (cameraFront * movementSpeed);
+		changes = RenderScheduler::Camera;
 		break;
 	case 'a':
 		camPos += cy::Normalize(up.Cross(cameraFront)) * movementSpeed;
+		changes = RenderScheduler::Camera;
 		break;
 	case 's':
 		camPos -= (cameraFront * movementSpeed);
+		changes = RenderScheduler::Camera;
 		break;
 	case 'd':
 		// use negative up to get vector pointing right of camera
 		camPos += cy::Normalize((-up).Cross(cameraFront)) * movementSpeed;
+		changes = RenderScheduler::Camera;
 		break;
 	case 'g':
 		std::cout << "User Toggled Wire Mesh\n";
 		GeoMeshToggle = !GeoMeshToggle;
+		changes = RenderScheduler::Settings;
 		break;
 	case 'o':
 		// turn off color
 		tColor = !tColor;
+		changes = RenderScheduler::Settings;
 		break;
 	case 'p':
 		// turn off blinn-phong shading
 		shading = !shading;
+		changes = RenderScheduler::Settings;
+		break;
+	case 't':
+		// screen space tessellation up to tessLevel, or tessLevel everywhere
+		adaptiveTess = !adaptiveTess;
+		std::cout << "Adaptive tesselation " << (adaptiveTess ? "on" : "off") << std::endl;
+		changes = RenderScheduler::Settings;
+		break;
+	case 'v':
+		// uncapped -> vsync -> fixed 60 fps
+		if (frameScheduler.pacing() == FramePacing::Uncapped) { frameScheduler.setPacing(FramePacing::VSync, 60.0); }
+		else if (frameScheduler.pacing() == FramePacing::VSync) { frameScheduler.setPacing(FramePacing::FixedRate, 60.0); }
+		else { frameScheduler.setPacing(FramePacing::Uncapped, 60.0); }
+		applySwapInterval();
+		std::cout << "Frame pacing " << framePacingName(frameScheduler.pacing()) << std::endl;
+		changes = RenderScheduler::Settings;
+		break;
+	case 'f':
+		// per pass timings, printed every few seconds and written to frame_profile.csv
+		frameProfiler.setEnabled(!frameProfiler.enabled(), "frame_profile.csv");
+		std::cout << "Frame profiler " << (frameProfiler.enabled() ? "on" : "off") << std::endl;
+		changes = RenderScheduler::Settings;
 		break;
 	}
 	// check shift button which moves player down
 	if (glutGetModifiers() == GLUT_ACTIVE_SHIFT)
 	{
 		camPos.y -= movementSpeed;
+		changes |= RenderScheduler::Camera;
 	}
+	if (changes != 0) { requestRedraw(changes); }
 	return;
 }
 
@@ -304,6 +592,8 @@ void mouseClickDrag(int x, int y)
 {
 	mouseX = x;
 	mouseY = y;
+	// dragging with the left button turns the camera
+	if (leftMouse) { requestRedraw(RenderScheduler::Camera); }
 	return;
 }
 
@@ -326,6 +616,7 @@ void specialInput(int key, int x, int y)
 		std::cout << "Increased tesselation level to: " << tessLevel << std::endl;
 		break;
 	}
+	requestRedraw(RenderScheduler::Settings);
 }
 
 
@@ -340,14 +631,19 @@ void idleCallback()
 	static float xRot = 0.0f;
 	static float zRot = 0.0f;
 
-	setRotationAndDistance(xRot, yRot, zRot);
+	if (swapInRefinedTerrain()) { frameScheduler.markDirty(RenderScheduler::Streaming); }
 
-	//cy::Matrix3f rotMatrix = cy::Matrix3f::RotationXYZ(yRot, xRot, zRot);
-	float halfWidth = terrain.getMeshWidth() / 2;
-	cy::Matrix4f centerMeshOnWorld = cy::Matrix4f::Translation(cy::Vec3f(-halfWidth, 0.0f, -halfWidth));
-	// define the scale of the plane to fit the size of the current scene objects
-	cy::Matrix4f planeScale = cy::Matrix4f::Scale(cy::Vec3f(1.0f, 1.0f, 1.0f));
-	cy::Matrix4f planeModel = planeScale * centerMeshOnWorld;
+	// nothing changed, stop polling until the next input callback calls requestRedraw()
+	// a finer terrain level that is still on its way keeps the polling going, without spinning a core
+	if (!frameScheduler.isDirty())
+	{
+		if (terrainRefiner != nullptr) { std::this_thread::sleep_for(std::chrono::milliseconds(1)); }
+		else { glutIdleFunc(nullptr); }
+		return;
+	}
+	frameScheduler.beginFrame();
+
+	setRotationAndDistance(xRot, yRot, zRot);
 
 	// define where to look at
 	// source: https://learnopengl.com/Getting-started/Camera
@@ -357,34 +653,67 @@ void idleCallback()
 	direction.z = sin(xRot) * cos(yRot);
 	cameraFront = Normalize(direction);
 
+	updateFrame();
+
+	// Tell GLUT to redraw
+	glutPostRedisplay();
+}
+
+
+/**
+*
+* Matrices, frustum and uniforms of the next frame, from camPos and cameraFront
+*
+**/
+void updateFrame()
+{
+	frameProfiler.begin(ProfileUpdate);
+
+	//cy::Matrix3f rotMatrix = cy::Matrix3f::RotationXYZ(yRot, xRot, zRot);
+	// streamed tiles are already placed at their world position
+	float halfWidth = terrainMode == TerrainMode::Streamed ? 0.0f : terrainWidth / 2;
+	cy::Matrix4f centerMeshOnWorld = cy::Matrix4f::Translation(cy::Vec3f(-halfWidth, 0.0f, -halfWidth));
+	// define the scale of the plane to fit the size of the current scene objects
+	cy::Matrix4f planeScale = cy::Matrix4f::Scale(cy::Vec3f(1.0f, 1.0f, 1.0f));
+	cy::Matrix4f planeModel = planeScale * centerMeshOnWorld;
+
 	cy::Matrix4f view = cy::Matrix4f::View(camPos, camPos + cameraFront, cy::Vec3f(0.0f, 1.0f, 0.0f));
 	cy::Matrix4f projMatrix = cy::Matrix4f::Perspective(DEG2RAD(90), float(windowWidth) / float(windowHeight), 0.1f, 3000.0f);
+	terrainFrustum = Frustum::fromMatrix(projMatrix * view * planeModel);
 
 	// translation matrix inteded to be used to prevent z-fighting between the actual plane and it's wire mesh
 	cy::Matrix4f VerticalTrans = cy::Matrix4f::Translation(cy::Vec3f(0.0f, 0.1f, 0.0f));
 
 	cy::Vec3f lightPos = cy::Vec3f(0.0f, 1000.0f, 100.0f);
 
-	planeShaders["viewPos"] = camPos;
-	planeShaders["model"] = planeModel;
-	planeShaders["view"] = view;
-	planeShaders["projection"] = projMatrix;
-	planeShaders["lightPos"] = lightPos;
-
-	wireMeshShaders["viewPos"] = camPos;
-	wireMeshShaders["model"] = VerticalTrans * planeModel;
-	wireMeshShaders["view"] = view;
-	wireMeshShaders["projection"] = projMatrix;
-	wireMeshShaders["lightPos"] = lightPos;
-
-	planeShaders["tessLevel"] = (float)tessLevel;
-	wireMeshShaders["tessLevel"] = (float)tessLevel;
-
-	planeShaders["tColor"] = tColor;
-	planeShaders["shading"] = shading;
-
-	// Tell GLUT to redraw
-	glutPostRedisplay();
+	// camera and light for every program with one buffer update
+	FrameUniforms frame;
+	frame.view = view;
+	frame.projection = projMatrix;
+	frame.viewPos = camPos;
+	frame.viewportHeight = (float)windowHeight;
+	frame.lightPos = lightPos;
+	frame.padding = 0.0f;
+	frameUniforms.Set(frame);
+
+	// set every frame, so the names are hashed at compile time
+	// grouped by program, a program is only bound again when the uniforms switch to the other one
+	static constexpr cy::GLSLProgram::UniformName modelName("model");
+	static constexpr cy::GLSLProgram::UniformName tessLevelName("tessLevel");
+	static constexpr cy::GLSLProgram::UniformName adaptiveTessName("adaptiveTess");
+	static constexpr cy::GLSLProgram::UniformName tColorName("tColor");
+	static constexpr cy::GLSLProgram::UniformName shadingName("shading");
+
+	planeShaders[modelName] = planeModel;
+	planeShaders[tessLevelName] = (float)tessLevel;
+	planeShaders[adaptiveTessName] = adaptiveTess;
+	planeShaders[tColorName] = tColor;
+	planeShaders[shadingName] = shading;
+
+	wireMeshShaders[modelName] = VerticalTrans * planeModel;
+	wireMeshShaders[tessLevelName] = (float)tessLevel;
+	wireMeshShaders[adaptiveTessName] = adaptiveTess;
+	frameProfiler.end(ProfileUpdate);
 }
 
 
@@ -434,6 +763,7 @@ Mesh** createSceneTerrain(GLuint& terrainVao, int mapSize)
 	GLuint colorBuffer;
 	GLuint planeEBuffer;
 	GLuint planeTxc;
+	GLuint heightTexture;
 
 	// define texture coordinates
 	float planeTxcArray[] = {
@@ -445,51 +775,219 @@ Mesh** createSceneTerrain(GLuint& terrainVao, int mapSize)
 		1.0, 0.0
 	};
 
-	// INJECTED CODE
-	std::vector<cy::Vec3f> terrainVert = terrain.getVertices();
-	std::vector<cy::Vec3f> terrainFaces = terrain.getFaces();
-	std::vector<cy::Vec3f> terrainNorms = terrain.getNorms();
-	std::vector<cy::Vec4f> terrainColors = terrain.getColors();
-
 	// create plane plane VAO and vbo
 	glGenVertexArrays(1, &terrainVao);
 	glBindVertexArray(terrainVao);
-	glGenBuffers(1, &planeVbo);
-	glBindBuffer(GL_ARRAY_BUFFER, planeVbo);
-	glBufferData(GL_ARRAY_BUFFER, sizeof(cy::Vec3f) * terrainVert.size(), &terrainVert[0], GL_STATIC_DRAW);
-	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 0, (GLvoid*)0);
-	glEnableVertexAttribArray(0);
-
-	// create plane normal buffer
-	glGenBuffers(1, &planeNBuffer);
-	glBindBuffer(GL_ARRAY_BUFFER, planeNBuffer);
-	glBufferData(GL_ARRAY_BUFFER, sizeof(cy::Vec3f) * terrainNorms.size(), &terrainNorms[0], GL_STATIC_DRAW);
-	glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 0, (GLvoid*)0);
-	glEnableVertexAttribArray(1);
-
-	// create plane color buffer
-	glGenBuffers(1, &colorBuffer);
-	glBindBuffer(GL_ARRAY_BUFFER, colorBuffer);
-	glBufferData(GL_ARRAY_BUFFER, sizeof(cy::Vec4f) * terrainColors.size(), &terrainColors[0], GL_STATIC_DRAW);
-	glVertexAttribPointer(2, 4, GL_FLOAT, GL_FALSE, 0, (GLvoid*)0);
-	glEnableVertexAttribArray(2);
-
-	// create plane element buffer
+
+	if (terrain.getVertexLayout() == TerrainVertexLayout::Heightmap)
+	{
+		// no vertex buffers at all, the empty VAO is drawn with glDrawArrays (see drawTerrainPatches)
+		// regenerating the terrain only needs this one texture to be uploaded again
+		std::span<const unsigned short> terrainHeights = terrain.viewHeightmap();
+		glGenTextures(1, &heightTexture);
+		sceneTerrainTextures.push_back(heightTexture);
+		glActiveTexture(GL_TEXTURE0);
+		glBindTexture(GL_TEXTURE_2D, heightTexture);
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 2);
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_R16, mapSize, mapSize, 0, GL_RED, GL_UNSIGNED_SHORT, terrainHeights.data());
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+		// texelFetch in the vertex shader, linear filtered heights for the tessellated vertices of shader.tesse
+		// the texture still has to be complete without mipmaps
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+		return NULL;
+	}
+	else if (terrain.getVertexLayout() == TerrainVertexLayout::Packed)
+	{
+		// one interleaved buffer, see PackedTerrainVertex and Shaders/PackedTerrain.vert
+		std::span<const PackedTerrainVertex> terrainPacked = terrain.viewPackedVertices();
+		GLsizei stride = sizeof(PackedTerrainVertex);
+		glGenBuffers(1, &planeVbo);
+		sceneTerrainBuffers.push_back(planeVbo);
+		glBindBuffer(GL_ARRAY_BUFFER, planeVbo);
+		glBufferData(GL_ARRAY_BUFFER, terrainPacked.size_bytes(), terrainPacked.data(), GL_STATIC_DRAW);
+		glVertexAttribPointer(0, 3, GL_UNSIGNED_SHORT, GL_FALSE, stride, (GLvoid*)offsetof(PackedTerrainVertex, x));
+		glEnableVertexAttribArray(0);
+		glVertexAttribPointer(1, 2, GL_BYTE, GL_TRUE, stride, (GLvoid*)offsetof(PackedTerrainVertex, normal));
+		glEnableVertexAttribArray(1);
+		glVertexAttribIPointer(2, 1, GL_UNSIGNED_BYTE, stride, (GLvoid*)offsetof(PackedTerrainVertex, material));
+		glEnableVertexAttribArray(2);
+	}
+	else
+	{
+		std::span<const cy::Vec3f> terrainVert = terrain.viewVertices();
+		std::span<const cy::Vec3f> terrainNorms = terrain.viewNorms();
+		std::span<const cy::Vec4f> terrainColors = terrain.viewColors();
+
+		glGenBuffers(1, &planeVbo);
+		sceneTerrainBuffers.push_back(planeVbo);
+		glBindBuffer(GL_ARRAY_BUFFER, planeVbo);
+		glBufferData(GL_ARRAY_BUFFER, terrainVert.size_bytes(), terrainVert.data(), GL_STATIC_DRAW);
+		glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 0, (GLvoid*)0);
+		glEnableVertexAttribArray(0);
+
+		// create plane normal buffer
+		glGenBuffers(1, &planeNBuffer);
+		sceneTerrainBuffers.push_back(planeNBuffer);
+		glBindBuffer(GL_ARRAY_BUFFER, planeNBuffer);
+		glBufferData(GL_ARRAY_BUFFER, terrainNorms.size_bytes(), terrainNorms.data(), GL_STATIC_DRAW);
+		glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 0, (GLvoid*)0);
+		glEnableVertexAttribArray(1);
+
+		// create plane color buffer
+		glGenBuffers(1, &colorBuffer);
+		sceneTerrainBuffers.push_back(colorBuffer);
+		glBindBuffer(GL_ARRAY_BUFFER, colorBuffer);
+		glBufferData(GL_ARRAY_BUFFER, terrainColors.size_bytes(), terrainColors.data(), GL_STATIC_DRAW);
+		glVertexAttribPointer(2, 4, GL_FLOAT, GL_FALSE, 0, (GLvoid*)0);
+		glEnableVertexAttribArray(2);
+
+		// create texture coordinates buffer
+		glGenBuffers(1, &planeTxc);
+		sceneTerrainBuffers.push_back(planeTxc);
+		glBindBuffer(GL_ARRAY_BUFFER, planeTxc);
+		glBufferData(GL_ARRAY_BUFFER, sizeof(planeTxcArray), planeTxcArray, GL_STATIC_DRAW);
+		glVertexAttribPointer(3, 2, GL_FLOAT, GL_FALSE, 0, (GLvoid*)0);
+		glEnableVertexAttribArray(3);
+	}
+
+	// create plane element buffer, bound to the VAO so drawNewFrame() can use glDrawElements
+	// patch by patch instead of the mesh's row order, so the visible patches are a few ranges (see TerrainCuller)
+	std::vector<unsigned int> terrainIndices(terrainCuller.indexCount());
+	terrainCuller.writePatchIndices(terrainIndices.data());
 	glGenBuffers(1, &planeEBuffer);
+	sceneTerrainBuffers.push_back(planeEBuffer);
 	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, planeEBuffer);
-	glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(&terrainFaces[0]) * terrainFaces.size(), &terrainFaces[0], GL_STATIC_DRAW);
-
-	// create texture coordinates buffer
-	glGenBuffers(1, &planeTxc);
-	glBindBuffer(GL_ARRAY_BUFFER, planeTxc);
-	glBufferData(GL_ARRAY_BUFFER, sizeof(planeTxcArray), planeTxcArray, GL_STATIC_DRAW);
-	glVertexAttribPointer(3, 2, GL_FLOAT, GL_FALSE, 0, (GLvoid*)0);
-	glEnableVertexAttribArray(3);
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(unsigned int) * terrainIndices.size(), terrainIndices.data(), GL_STATIC_DRAW);
 
 	return NULL;
 }
 
 
+/// <summary>
+/// Build the min/max height quadtree of the terrain, the patch order of its culler, and upload the roughness
+/// of its patches to texture unit 1, where Shaders/shader.tessc reads it to pick tessellation levels
+/// </summary>
+/// <param name="mapSize">the width of the terrain in vertices</param>
+void createTerrainBounds(int mapSize)
+{
+	GLuint roughnessTexture;
+
+	terrainBounds.build(mapSize, mapSize, 16, [](unsigned int x, unsigned int z) { return terrain.getHeight(x, z); });
+	terrainCuller.build(terrainBounds, terrain.getSpacing());
+
+	glGenTextures(1, &roughnessTexture);
+	sceneTerrainTextures.push_back(roughnessTexture);
+	glActiveTexture(GL_TEXTURE1);
+	glBindTexture(GL_TEXTURE_2D, roughnessTexture);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_R32F, terrainBounds.nodesX(0), terrainBounds.nodesZ(0), 0, GL_RED, GL_FLOAT, terrainBounds.roughnesses());
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glActiveTexture(GL_TEXTURE0);
+}
+
+
+/// <summary>
+/// Free the GL objects of createSceneTerrain() and createTerrainBounds(), before they are created for a new terrain
+/// </summary>
+void deleteSceneTerrain()
+{
+	if (terrainVao != 0) { glDeleteVertexArrays(1, &terrainVao); }
+	terrainVao = 0;
+	if (!sceneTerrainBuffers.empty()) { glDeleteBuffers((GLsizei)sceneTerrainBuffers.size(), sceneTerrainBuffers.data()); }
+	if (!sceneTerrainTextures.empty()) { glDeleteTextures((GLsizei)sceneTerrainTextures.size(), sceneTerrainTextures.data()); }
+	sceneTerrainBuffers.clear();
+	sceneTerrainTextures.clear();
+}
+
+
+/// <summary>
+/// Uniforms that depend on the terrain, set again whenever a finer level is swapped in
+/// </summary>
+void setTerrainUniforms()
+{
+	// scale of the packed grid coordinates and heights, unused by the float layout
+	planeShaders["gridSpacing"] = terrain.getSpacing();
+	planeShaders["heightOffset"] = terrain.getPackedHeightOffset();
+	planeShaders["heightScale"] = terrain.getPackedHeightScale();
+	planeShaders["maxHeight"] = terrain.getMaxHeight();
+	planeShaders["heightMap"] = 0;
+	wireMeshShaders["gridSpacing"] = terrain.getSpacing();
+	wireMeshShaders["heightOffset"] = terrain.getPackedHeightOffset();
+	wireMeshShaders["heightScale"] = terrain.getPackedHeightScale();
+	wireMeshShaders["maxHeight"] = terrain.getMaxHeight();
+	wireMeshShaders["heightMap"] = 0;
+
+	// adaptive tessellation, see Shaders/shader.tessc
+	// only the single map and CdlodTerrain have per patch roughness, only heightmaps can be re-sampled when tessellated
+	bool singleMap = terrainMode == TerrainMode::SingleMap;
+	bool displaceHeights = singleMap && terrainLayout == TerrainVertexLayout::Heightmap;
+	for (cy::GLSLProgram* program : { &planeShaders, &wireMeshShaders })
+	{
+		(*program)["targetEdgePixels"] = 8.0f;
+		(*program)["roughnessScale"] = 32.0f;
+		(*program)["roughnessMap"] = 1;
+		(*program)["hasRoughnessMap"] = singleMap;
+		(*program)["roughnessCellSize"] = terrainBounds.patchQuads() * terrain.getSpacing();
+		(*program)["displaceHeights"] = displaceHeights;
+	}
+}
+
+
+/// <summary>
+/// Replace the terrain with the newest level terrainRefiner finished, and free the refiner after the full map.
+/// Only uploads, the level was generated on the refiner's thread.
+/// </summary>
+/// <returns>true if the terrain changed and has to be drawn again</returns>
+bool swapInRefinedTerrain()
+{
+	if (terrainRefiner == nullptr) { return false; }
+	Mesh refined;
+	unsigned int gridSize;
+	if (!terrainRefiner->takeFinished(refined, gridSize)) { return false; }
+
+	terrain = std::move(refined);
+	terrainGridSize = gridSize;
+	if (terrainMode == TerrainMode::Cdlod)
+	{
+		delete cdlodTerrain;
+		cdlodTerrain = new CdlodTerrain();
+		cdlodTerrain->create(terrain, terrainGridSize, terrainGridSize);
+	}
+	else
+	{
+		deleteSceneTerrain();
+		createTerrainBounds(terrainGridSize);
+		createSceneTerrain(terrainVao, terrainGridSize);
+	}
+	setTerrainUniforms();
+
+	double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startupTime).count();
+	std::cout << "Terrain refined to " << terrainGridSize << "x" << terrainGridSize << " after " << ms << " ms" << std::endl;
+	if (!terrainRefiner->pending())
+	{
+		delete terrainRefiner;
+		terrainRefiner = nullptr;
+	}
+	return true;
+}
+
+
+/// <summary>
+/// Print the time from the start of main() to the first finished frame, once
+/// </summary>
+void reportFirstFrame()
+{
+	static bool reported = false;
+	if (reported) { return; }
+	reported = true;
+	double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startupTime).count();
+	std::cout << "Time to first frame: " << ms << " ms" << std::endl;
+}
+
+
 /**
 *
 * Set the x, y, and z rotation values given based on mouse location.
@@ -549,6 +1047,307 @@ float RAD2DEG(float radians)
 	return (radians * 180.0f) / M_PI;
 }
 
+/**
+*
+* Note that the scene changed and make sure the idle callback runs to draw the next frame
+*
+**/
+void requestRedraw(unsigned int changes)
+{
+	frameScheduler.markDirty(changes);
+	glutIdleFunc(idleCallback);
+}
+
+/**
+*
+* Swap the finished frame in, and keep frames coming while streamed tiles are still on their way
+*
+**/
+void presentFrame()
+{
+	glutSwapBuffers();
+	reportFirstFrame();
+	frameProfiler.endFrame();
+	if (terrainMode == TerrainMode::Streamed && terrainChunks->pendingCount() > 0)
+	{
+		requestRedraw(RenderScheduler::Streaming);
+	}
+	frameScheduler.endFrame();
+}
+
+/**
+*
+* Make the buffer swap wait for the display refresh in FramePacing::VSync only.
+* Other platforms keep their driver's default.
+*
+**/
+void applySwapInterval()
+{
+#ifdef _WIN32
+	if (WGLEW_EXT_swap_control) { wglSwapIntervalEXT(frameScheduler.swapInterval()); }
+#endif
+}
+
+/**
+*
+* Read the options of the scene, for the interactive window and the headless benchmark alike.
+* Unknown arguments are left to parseBenchmarkOptions() and GLUT.
+*   --terrain MODE        single (default), streamed or cdlod
+*   --noise ENGINE        perlin, simplex2d or simplex3d, the noise the terrain octaves are summed from
+*   --noise-hash MODE     permutation or integer, where the Perlin noise takes its corner gradients from
+*
+**/
+void parseSceneOptions(int argc, char* argv[])
+{
+	for (int i = 1; i + 1 < argc; i++)
+	{
+		std::string arg = argv[i];
+		const char* value = argv[i + 1];
+		if (arg == "--terrain")
+		{
+			std::string mode = value;
+			if (mode == "single") { terrainMode = TerrainMode::SingleMap; }
+			else if (mode == "streamed") { terrainMode = TerrainMode::Streamed; }
+			else if (mode == "cdlod") { terrainMode = TerrainMode::Cdlod; }
+			else { std::cerr << "Unknown terrain mode " << mode << std::endl; continue; }
+		}
+		else if (arg == "--noise")
+		{
+			const NoiseEngine* engine = NoiseEngine::find(value);
+			if (engine == nullptr) { std::cerr << "Unknown noise engine " << value << std::endl; continue; }
+			NoiseEngine::setActive(*engine);
+		}
+		else if (arg == "--noise-hash")
+		{
+			std::string mode = value;
+			if (mode == "permutation") { PerlinNoise::setHashing(PerlinNoise::Hashing::Permutation); }
+			else if (mode == "integer") { PerlinNoise::setHashing(PerlinNoise::Hashing::Integer); }
+			else { std::cerr << "Unknown noise hashing " << mode << std::endl; continue; }
+		}
+		else { continue; }
+		i++;
+	}
+}
+
+/**
+*
+* Read the options of the headless benchmark, unknown arguments are left to parseSceneOptions() and GLUT.
+* Only reads, --save DIR is created by runHeadlessBenchmark().
+*   --headless            run the benchmark instead of the interactive window
+*   --frames N            frames per tessellation level
+*   --tess 8,16,32        tessellation levels to run
+*   --size 1280x720       size of the offscreen frame buffer
+*   --save DIR            save every --save-every th frame (default 30) as DIR/tess<level>_<frame>.png, creates DIR
+*
+* returns whether --headless was given
+*
+**/
+bool parseBenchmarkOptions(int argc, char* argv[], BenchmarkOptions& options)
+{
+	bool headless = false;
+	for (int i = 1; i < argc; i++)
+	{
+		std::string arg = argv[i];
+		const char* value = i + 1 < argc ? argv[i + 1] : nullptr;
+		if (arg == "--headless") { headless = true; continue; }
+		if (value == nullptr) { continue; }
+
+		if (arg == "--frames") { options.frames = std::max(1, atoi(value)); }
+		else if (arg == "--save") { options.saveDirectory = value; }
+		else if (arg == "--save-every") { options.saveEvery = std::max(1, atoi(value)); }
+		else if (arg == "--size")
+		{
+			int width, height;
+			if (sscanf(value, "%dx%d", &width, &height) == 2 && width > 0 && height > 0)
+			{
+				options.width = width;
+				options.height = height;
+			}
+		}
+		else if (arg == "--tess")
+		{
+			options.tessLevels.clear();
+			for (const char* c = value; *c != '\0';)
+			{
+				char* end;
+				long level = strtol(c, &end, 10);
+				if (end == c) { break; }
+				if (level > 0) { options.tessLevels.push_back((unsigned short)level); }
+				c = *end == ',' ? end + 1 : end;
+			}
+		}
+		else { continue; }
+		i++;
+	}
+	return headless;
+}
+
+/**
+*
+* Fly the same camera path once per tessellation level, drawing into an offscreen frame buffer,
+* and print the frame times of every run along with the per pass times of frameProfiler.
+* Every frame ends with glFinish(), so a frame's time includes the GPU work and not just its submission.
+*
+* returns the exit code of the program, 1 on GL errors, a --save directory that cannot be made or frames that could not be saved
+*
+**/
+int runHeadlessBenchmark(const BenchmarkOptions& options)
+{
+	// every frame would fail to save later on, so a directory that cannot be made ends the run here
+	if (!options.saveDirectory.empty())
+	{
+		std::error_code error;
+		std::filesystem::create_directories(options.saveDirectory, error);
+		if (error)
+		{
+			std::cerr << "Could not create the --save directory " << options.saveDirectory << ": " << error.message() << std::endl;
+			return 1;
+		}
+	}
+
+	cy::GLRenderTexture2D target;
+	if (!target.Initialize(true, 4, options.width, options.height))
+	{
+		std::cerr << "Could not create the " << options.width << "x" << options.height << " frame buffer" << std::endl;
+		return 1;
+	}
+	target.Bind();
+	frameScheduler.setPacing(FramePacing::Uncapped, 60.0);
+
+	// streamed tiles are placed around the world origin, the other modes center the map on it
+	bool streamed = terrainMode == TerrainMode::Streamed;
+	auto cameraLoop = [streamed]() {
+		float radius = streamed ? 800.0f : terrainWidth * 0.3f;
+		float height = streamed ? 300.0f : terrain.getMaxHeight() + 50.0f;
+		return CameraPath::loop(cy::Vec3f(0.0f, 0.0f, 0.0f), radius, height, 8);
+	};
+	CameraPath path = cameraLoop();
+	cy::Vec3f lookDown(0.0f, -0.35f, 0.0f);
+
+	// the first frame shows whatever terrain is ready, as the window would
+	camPos = path.position(0.0f);
+	cameraFront = Normalize(path.direction(0.0f) + lookDown);
+	updateFrame();
+	renderTerrain();
+	glFinish();
+	reportFirstFrame();
+
+	// the timed runs only start once the full resolution map is in
+	while (terrainRefiner != nullptr)
+	{
+		if (!swapInRefinedTerrain()) { std::this_thread::sleep_for(std::chrono::milliseconds(1)); }
+	}
+	path = cameraLoop();
+
+	bool saved = true;
+	for (unsigned short level : options.tessLevels)
+	{
+		tessLevel = level;
+		camPos = path.position(0.0f);
+		cameraFront = Normalize(path.direction(0.0f) + lookDown);
+
+		// the tiles at the start are in place before timing begins, the others stream in during the run as they would in the window
+		if (streamed)
+		{
+			do
+			{
+				updateFrame();
+				renderTerrain();
+				glFinish();
+				std::this_thread::sleep_for(std::chrono::milliseconds(1));
+			} while (terrainChunks->pendingCount() > 0);
+		}
+
+		std::vector<float> frameTimes;
+		frameTimes.reserve(options.frames);
+		frameProfiler.setEnabled(true);
+		for (unsigned int frame = 0; frame < options.frames; frame++)
+		{
+			float t = (float)frame / options.frames;
+			camPos = path.position(t);
+			cameraFront = Normalize(path.direction(t) + lookDown);
+
+			auto start = std::chrono::steady_clock::now();
+			updateFrame();
+			renderTerrain();
+			frameProfiler.endFrame();
+			glFinish();
+			frameTimes.push_back(std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count());
+
+			if (!options.saveDirectory.empty() && frame % options.saveEvery == 0)
+			{
+				char name[64];
+				snprintf(name, sizeof(name), "/tess%u_%05u.png", (unsigned int)level, frame);
+				saved &= saveFrame(target, options.width, options.height, options.saveDirectory + name);
+			}
+		}
+
+		TimingStats stats = computeTimingStats(frameTimes);
+		std::cout << "tessLevel " << level << ": " << stats.count << " frames, min " << stats.min << " avg " << stats.avg
+			<< " p99 " << stats.p99 << " ms, " << (stats.avg > 0 ? 1000.0 / stats.avg : 0.0) << " fps" << std::endl;
+		// prints the per pass times of the run
+		frameProfiler.setEnabled(false);
+	}
+	target.Unbind();
+
+	GLenum error = glGetError();
+	if (error != GL_NO_ERROR) { std::cerr << "GL error " << error << " during the benchmark" << std::endl; }
+	return error == GL_NO_ERROR && saved ? 0 : 1;
+}
+
+/**
+*
+* Write the color texture of a render target to a png file
+*
+* returns false if lodepng could not write the file
+*
+**/
+bool saveFrame(const cy::GLRenderTexture2D& target, int width, int height, const std::string& path)
+{
+	// without alpha, the clear color's alpha is 0 and would make the sky transparent
+	std::vector<unsigned char> pixels(width * height * 3);
+	std::vector<unsigned char> flipped(pixels.size());
+	// GLRenderTexture::Bind() only binds the draw frame buffer
+	GLint previousRead;
+	glGetIntegerv(GL_READ_FRAMEBUFFER_BINDING, &previousRead);
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, target.GetID());
+	glPixelStorei(GL_PACK_ALIGNMENT, 1);
+	glReadPixels(0, 0, width, height, GL_RGB, GL_UNSIGNED_BYTE, pixels.data());
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, previousRead);
+
+	// GL rows start at the bottom, png rows at the top
+	size_t rowBytes = (size_t)width * 3;
+	for (int row = 0; row < height; row++)
+	{
+		std::copy_n(&pixels[row * rowBytes], rowBytes, &flipped[(height - 1 - row) * rowBytes]);
+	}
+
+	unsigned int error = lodepng::encode(path, flipped, width, height, LCT_RGB);
+	if (error != 0)
+	{
+		std::cerr << "Could not save " << path << ": " << lodepng_error_text(error) << std::endl;
+		return false;
+	}
+	return true;
+}
+
+/**
+*
+* Draw the terrain as triangle patches, the visible index ranges of the last TerrainCuller::cull() with one indirect draw,
+* or for the heightmap layout the whole map straight from gl_VertexID
+*
+**/
+void drawTerrainPatches()
+{
+	if (terrain.getVertexLayout() == TerrainVertexLayout::Heightmap)
+	{
+		glDrawArrays(GL_PATCHES, 0, (GLsizei)terrain.indexCount());
+		return;
+	}
+
+	terrainDraws.draw(GL_PATCHES);
+}
+
 void drawPoint(float x, float y, float z)
 {
 	GLuint vaoID;
@@ -7,175 +7,372 @@
 **/
 
 #include "Mesh.h"
+#include "../Threading/ThreadPool.h"
+#include "../Noise/PerlinNoise.h"
+#include "../Noise/NoiseEngine.h"
+
+/// <summary>
+/// Free the memory of a vector, clear() alone keeps the capacity
+/// </summary>
+template <class T>
+static void freeVector(std::vector<T>& v)
+{
+    std::vector<T>().swap(v);
+}
+
+/// <summary>
+/// Octahedral encode a unit normal into two snorm8 values.
+/// The octahedron is folded along y, so upward normals keep the full precision of the upper half.
+/// Decoded by decodeOctahedral() in Shaders/PackedTerrain.vert.
+/// </summary>
+/// <param name="n">unit length normal</param>
+/// <param name="out">receives the encoded x and z</param>
+static void encodeOctahedral(const cy::Vec3f& n, signed char out[2])
+{
+    float l1 = fabsf(n.x) + fabsf(n.y) + fabsf(n.z);
+    float u = n.x / l1;
+    float v = n.z / l1;
+    if (n.y < 0) {
+        float foldedU = (1 - fabsf(v)) * (u >= 0 ? 1 : -1);
+        float foldedV = (1 - fabsf(u)) * (v >= 0 ? 1 : -1);
+        u = foldedU;
+        v = foldedV;
+    }
+    out[0] = (signed char)roundf(u * 127);
+    out[1] = (signed char)roundf(v * 127);
+}
+
+/// <summary>
+/// Height of a vertex from its normalized (0 - 1) noise value, before the grid spacing is applied
+/// </summary>
+static float noiseHeight(float noise)
+{
+    // modify y to make the terrain more extreme
+    // this was determined by guess and test and is subjective
+    return noise * noise * 200;
+}
 
 /// <summary>
 /// Generate the attributes of this Mesh instance
+/// The vertex grid is kept shared and the triangles are emitted as an index buffer.
+/// Every pass is split into row bands across a thread pool. Each band only writes its own rows
+/// (or faces), and the only cross-row dependency - the max height used for lakes and colour
+/// bands - is a separate reduction pass, so the output is identical for any thread count.
+/// Depending on the vertex layout the float arrays, the packed vertices or only the heightmap are filled.
+/// </summary>
+/// <param name="w">width of the mesh(num of vertices)</param>
+/// <param name="h">height of the mesh(num of vertices)</param>
+/// <param name="threadCount">number of threads to generate with, 0 uses every hardware thread</param>
+void Mesh::generateVertices(unsigned int w, unsigned int h, unsigned int threadCount) {
+    generateRegion(w, h, TerrainParams(), threadCount);
+}
+
+/// <summary>
+/// Generate the attributes of this Mesh for one region of the infinite noise field (see generateVertices).
+/// Vertex positions stay local to the region, vertex (c, r) samples the noise at grid point
+/// (originX + c * step, originZ + r * step), so regions that share their border vertices are seamless as long as they
+/// use the same noise scale and reference height. A step above 1 spaces the vertices further apart but keeps
+/// the heights, so the mesh is a coarse version of the full resolution one.
+/// </summary>
+/// <param name="w">width of the mesh(num of vertices)</param>
+/// <param name="h">height of the mesh(num of vertices)</param>
+/// <param name="params">noise parameters and which part of the noise field to generate</param>
+/// <param name="threadCount">number of threads to generate with, 0 uses every hardware thread</param>
+void Mesh::generateRegion(unsigned int w, unsigned int h, const TerrainParams& params, unsigned int threadCount) {
+    ThreadPool pool(threadCount);
+    generateRegion(w, h, params, pool);
+}
+
+/// <summary>
+/// Generate a region like generateRegion(w, h, params, threadCount), on a pool the caller keeps, so repeated calls do not start new threads.
+/// The pool may be one the caller is itself running on, parallelFor() takes part with the calling thread.
 /// </summary>
 /// <param name="w">width of the mesh(num of vertices)</param>
 /// <param name="h">height of the mesh(num of vertices)</param>
-void Mesh::generateVertices(unsigned int w, unsigned int h) {
-    // Create vertices
-    vertices.reserve(w * h);
+/// <param name="params">noise parameters and which part of the noise field to generate</param>
+/// <param name="pool">threads to generate with</param>
+void Mesh::generateRegion(unsigned int w, unsigned int h, const TerrainParams& params, ThreadPool& pool) {
+    // grid vertices per noise unit along x and z, by default the mesh spans exactly one unit
+    unsigned int step = params.step > 0 ? params.step : 1;
+    float scaleX = params.noiseScale > 0 ? params.noiseScale : (float)(w * step);
+    float scaleZ = params.noiseScale > 0 ? params.noiseScale : (float)(h * step);
     vertex_width = w;
     vertex_length = h;
-    spacing = 5.0;
-    int maxHeight = 0;
-    // Rows
-    for (int r = 0; r < h; r++) {
-        // Cols
-        for (int c = 0; c < w; c++) {
-            // NOTE: origin is not at center of mesh
-            float x = c; // col
-            float z = r; // row
-            float y =
-                
-                noise_callback( // perlin or other noise func
-                    (float)c / w,   // x - normalized between 0-1
-                    1,              // y
-                    (float)r / h,   // z - normalized between 0-1
-                    6,              // octaves
-                    0.5               // persistance
-                );
-            // modify y to make the terrain more extreme
-            // this was determined by guess and test and is subjective
-            y = pow(y, 2) * 200;
-
-            if (y * spacing > maxHeight) { maxHeight = y * spacing; }
-            cy::Vec3f v(x * spacing, y * spacing, z * spacing); //
-
-            // Vertex colors supported!
-            if (v.y < (.3 * maxHeight))
+    spacing = params.spacing * step;
+    // heights do not depend on the step, only the distance between vertices does
+    float heightSpacing = params.spacing;
+    bool packed = vertex_layout == TerrainVertexLayout::Packed;
+    bool heightmapOnly = vertex_layout == TerrainVertexLayout::Heightmap;
+    bool quantized = packed || heightmapOnly;
+
+    // the quantized layouts keep the heights aside until the max height is known
+    std::vector<float> heights;
+    if (quantized) {
+        freeVector(vertices);
+        freeVector(normals);
+        freeVector(vertex_colors);
+        heights.resize(w * h);
+    }
+    else {
+        vertices.resize(w * h);
+        normals.resize(w * h);
+        vertex_colors.resize(w * h);
+    }
+    if (packed) { packed_vertices.assign(w * h, PackedTerrainVertex()); }
+    else { freeVector(packed_vertices); }
+    if (heightmapOnly) { height_map.resize(w * h); }
+    else { freeVector(height_map); }
+
+    // Create vertices and their normals in the same pass
+    std::vector<float> rowMaxHeight(h, 0.0f);
+    pool.parallelFor(h, [&](size_t rowBegin, size_t rowEnd) {
+        // x of every column in noise units, shared by all rows of the band
+        std::vector<float> rowX(w);
+        std::vector<float> rowY(w);
+        std::vector<float> rowDx(w);
+        std::vector<float> rowDz(w);
+        for (unsigned int c = 0; c < w; c++) {
+            rowX[c] = (float)(params.originX + (int)c * (int)step) / scaleX;
+        }
+        // the rows of the band only differ in z, so the sampler hands lattice hashes from one row to the next
+        FbmParams fbm;
+        fbm.octaves = params.octaves;
+        fbm.persistence = params.persistence;
+        fbm.frequency = params.frequency;
+        std::unique_ptr<NoiseGridSampler> sampler = getNoiseEngine().gridSampler(
+            &rowX[0],       // x - normalized between 0-1 for a single mesh
+            w,              // number of samples per row
+            1,              // y
+            fbm
+        );
+        // Rows
+        for (size_t r = rowBegin; r < rowEnd; r++) {
+            // perlin or other noise func for the whole row at once, z normalized between 0-1 for a single mesh
+            // slope along x and z, used for the normals
+            sampler->sampleRow((float)(params.originZ + (int)r * (int)step) / scaleZ, &rowY[0], &rowDx[0], &rowDz[0]);
+
+            float rowMax = 0.0f;
+            // Cols
+            for (unsigned int c = 0; c < w; c++) {
+                // NOTE: origin is not at center of mesh
+                float x = c; // col
+                float z = r; // row
+                float y = noiseHeight(rowY[c]);
+
+                if (y * heightSpacing > rowMax) { rowMax = y * heightSpacing; }
+
+                unsigned int i = (r * w) + c;
+                if (heightmapOnly) {
+                    // the shader rebuilds the normal from the neighbouring heights
+                    heights[i] = y * heightSpacing;
+                    continue;
+                }
+
+                // terrain normal from the analytic slope of the height
+                // the slope is taken per noise unit and scaled to world units, so spacing and step cancel out
+                float slopeX = 2 * rowY[c] * 200 * rowDx[c] / scaleX;
+                float slopeZ = 2 * rowY[c] * 200 * rowDz[c] / scaleZ;
+                cy::Vec3f normal = cy::Normalize(cy::Vec3f(-slopeX, 1.0f, -slopeZ));
+
+                if (packed) {
+                    heights[i] = y * heightSpacing;
+                    packed_vertices[i].x = c;
+                    packed_vertices[i].z = r;
+                    encodeOctahedral(normal, packed_vertices[i].normal);
+                }
+                else {
+                    vertices[i] = cy::Vec3f(x * spacing, y * heightSpacing, z * spacing);
+                    normals[i] = normal;
+                }
+            }
+            rowMaxHeight[r] = rowMax;
+        }
+    });
+
+    // Reduce the max height of the whole map, the lake level and colour bands are relative to it
+    float maxHeight = 0.0f;
+    for (unsigned int r = 0; r < h; r++) {
+        if (rowMaxHeight[r] > maxHeight) { maxHeight = rowMaxHeight[r]; }
+    }
+
+    // neighbouring regions have to agree on the lake level and colour bands, so they use a fixed reference
+    // and quantize up to the highest possible height (noise of 1) instead of their own max
+    float quantizeTop = maxHeight;
+    if (params.referenceHeight > 0) {
+        maxHeight = params.referenceHeight;
+        quantizeTop = 200 * heightSpacing;
+    }
+
+    // lakes are flattened, so the quantized heights only have to cover lake level to max height
+    max_height = maxHeight;
+    float lakeLevel = .3 * maxHeight;
+    packed_height_offset = lakeLevel;
+    packed_height_scale = (quantizeTop - lakeLevel) / 65535;
+
+    // Vertex colors supported!
+    pool.parallelFor(h, [&](size_t rowBegin, size_t rowEnd) {
+        cy::Vec3f up(0.0f, 1.0f, 0.0f);
+        for (size_t i = rowBegin * w; i < rowEnd * w; i++) {
+            float height = quantized ? heights[i] : vertices[i].y;
+            TerrainMaterial material;
+            if (height < (.3 * maxHeight))
             {
                 // blue lakes
-                vertex_colors.push_back(cy::Vec4f(0.0, 0.0, 1.0, 1.0));
+                material = TerrainMaterial::Water;
                 // flatten lakes
-                v.y = .3 * maxHeight;
+                height = lakeLevel;
             }
-            else if (v.y < (.4 * maxHeight))
+            else if (height < (.4 * maxHeight))
             {
-                // color: https://htmlcolorcodes.com/colors/sand/
-                vertex_colors.push_back(cy::Vec4f(0.7578, 0.6953, 0.5, 1.0));
+                material = TerrainMaterial::Sand;
             }
-            else if (v.y < (.6 * maxHeight))
+            else if (height < (.6 * maxHeight))
             {
-                // green grass
-                vertex_colors.push_back(cy::Vec4f(0.0, 1.0, 0.0, 1.0));
+                material = TerrainMaterial::Grass;
             }
             else
             {
-                // stone grey
-                vertex_colors.push_back(cy::Vec4f(0.5, 0.5, 0.5, 1.0));
+                material = TerrainMaterial::Stone;
             }
 
-            vertices.emplace_back(v);
-
-            // Create a vector in the mapping
-            std::vector<int> triangles;
-            vertex_to_triangles_map.emplace(vertices.size() - 1, triangles);
+            if (quantized) {
+                float step = packed_height_scale > 0 ? (height - lakeLevel) / packed_height_scale : 0;
+                unsigned short quantizedHeight = (unsigned short)(step < 65535 ? step + 0.5f : 65535);
+                if (heightmapOnly) {
+                    // water is recognised by the shader as a height of exactly the lake level
+                    height_map[i] = quantizedHeight;
+                    continue;
+                }
+                PackedTerrainVertex& v = packed_vertices[i];
+                v.height = quantizedHeight;
+                v.material = material;
+                if (material == TerrainMaterial::Water) { encodeOctahedral(up, v.normal); }
+            }
+            else {
+                vertices[i].y = height;
+                vertex_colors[i] = materialColor(material);
+                if (material == TerrainMaterial::Water) { normals[i] = up; }
+            }
         }
+    });
+
+    // the vertex to triangle adjacency is only built when someone asks for it
+    triangle_adjacency.offsets.clear();
+    triangle_adjacency.triangles.clear();
+
+    // kept separately so the counts stay valid after the arrays are released
+    // the heightmap layout draws the same triangles, just without an index buffer
+    vertex_count = w * h;
+    index_count = (w - 1) * (h - 1) * 6;
+    if (heightmapOnly) {
+        freeVector(indices);
+        return;
     }
 
-    // Generate faces
-
-    // Rows (-1 for last)
-    for (int r = 0; r < h - 1; r++) {
-        // Cols (-1 for last)
-        for (int c = 0; c < w - 1; c++) {
-            // Upper triangle
-            /*
-
-                v0 -- v2
-                |    /
-                |  /
-                v1
-            */
-            int f0_0 = (r * w) + c;
-            int f0_1 = ((r + 1) * w) + c;
-            int f0_2 = (r * w) + c + 1;
-            cy::Vec3f f0(f0_0, f0_1, f0_2);
-            faces.push_back(f0); // TODO: emplace
-
-            // Lower triangle
-            /*
-
-                      v2
-                     / |
-                   /   |
-                v0 --- v1
-            */
-            int f1_0 = ((r + 1) * w) + c;
-            ;
-            int f1_1 = ((r + 1) * w) + c + 1;
-            int f1_2 = (r * w) + c + 1;
+    // Generate faces as an index buffer into the shared vertex grid
+    // Shaders/HeightmapTerrain.vert rebuilds the same order from gl_VertexID
+    indices.resize(index_count);
+    // a single row or column of vertices has no triangles
+    if (index_count == 0) { return; }
+    pool.parallelFor(h - 1, [&](size_t rowBegin, size_t rowEnd) {
+        writeGridIndices(w, rowBegin, rowEnd, &indices[0]);
+    });
+}
 
-            cy::Vec3f f1(f1_0, f1_1, f1_2);
-            faces.push_back(f1); // TODO: emplace
+/// <summary>
+/// Highest vertex generateRegion() would produce for the same region, without generating the mesh.
+/// Only samples the noise, so it is much cheaper than the region itself. Coarse versions of a region
+/// pass it as their referenceHeight so they share the lake level and colour bands of the full resolution one.
+/// </summary>
+/// <param name="w">width of the region(num of vertices)</param>
+/// <param name="h">height of the region(num of vertices)</param>
+/// <param name="params">noise parameters and which part of the noise field to measure</param>
+/// <param name="pool">threads to measure with</param>
+/// <returns>the max height in world units</returns>
+float Mesh::measureMaxHeight(unsigned int w, unsigned int h, const TerrainParams& params, ThreadPool& pool) const {
+    unsigned int step = params.step > 0 ? params.step : 1;
+    float scaleX = params.noiseScale > 0 ? params.noiseScale : (float)(w * step);
+    float scaleZ = params.noiseScale > 0 ? params.noiseScale : (float)(h * step);
+
+    std::vector<float> rowMaxHeight(h, 0.0f);
+    pool.parallelFor(h, [&](size_t rowBegin, size_t rowEnd) {
+        std::vector<float> rowX(w);
+        std::vector<float> rowY(w);
+        std::vector<float> rowDx(w);
+        std::vector<float> rowDz(w);
+        for (unsigned int c = 0; c < w; c++) {
+            rowX[c] = (float)(params.originX + (int)c * (int)step) / scaleX;
         }
-    }
-
-    // Generate Normals
-    normals.reserve(w * h);
-    // rows (x)
-    for (int r = 0; r < h; r++) {
-        // Cols (z)
-        for (int c = 0; c < w; c++) {
-
-            float x = c; // col
-            float z = r; // row
-
-            // account for edge normals
-            if (x == 0 || z == 0 || z == h - 1 || x == w-1)
-            {
-                normals.push_back(cy::Vec3f(0.0f, 1.0f, 0.0f));
-                continue;
+        FbmParams fbm;
+        fbm.octaves = params.octaves;
+        fbm.persistence = params.persistence;
+        fbm.frequency = params.frequency;
+        std::unique_ptr<NoiseGridSampler> sampler = getNoiseEngine().gridSampler(&rowX[0], w, 1, fbm);
+        for (size_t r = rowBegin; r < rowEnd; r++) {
+            sampler->sampleRow((float)(params.originZ + (int)r * (int)step) / scaleZ, &rowY[0], &rowDx[0], &rowDz[0]);
+            float rowMax = 0.0f;
+            for (unsigned int c = 0; c < w; c++) {
+                float y = noiseHeight(rowY[c]) * params.spacing;
+                if (y > rowMax) { rowMax = y; }
             }
-
-            // read neightbor heights using an arbitrary small offset
-            // first vector is position, second is offset
-            float hL = height(cy::Vec2f(x, z) - cy::Vec2f(1.0, 0.0));
-            float hR = height(cy::Vec2f(x, z) + cy::Vec2f(1.0, 0.0));
-            float hD = height(cy::Vec2f(x, z) - cy::Vec2f(0.0, 1.0));
-            float hU = height(cy::Vec2f(x, z) + cy::Vec2f(0.0, 1.0));
-
-            // deduce terrain normal
-            cy::Vec3f N;
-            N.x = hL - hR;
-            N.y = hD - hU;
-            N.z = 1.0 * spacing;
-            normals.push_back(cy::Normalize(N));
+            rowMaxHeight[r] = rowMax;
         }
+    });
+
+    float maxHeight = 0.0f;
+    for (unsigned int r = 0; r < h; r++) {
+        if (rowMaxHeight[r] > maxHeight) { maxHeight = rowMaxHeight[r]; }
     }
+    return maxHeight;
+}
 
-    // Post-processing code
-    std::vector<cy::Vec3f> newVerts;
-    std::vector<cy::Vec3f> newNorms;
-    std::vector<cy::Vec4f> newColors;
-    int faceCount = faces.size();
-    newVerts.reserve(faceCount);
-    newNorms.reserve(faceCount);
-    newColors.reserve(faceCount);
-    for (int i = 0; i < faceCount; i++)
-    {
-        // arrange vertices
-        newVerts.emplace_back(vertices[faces[i][2]]);
-        newVerts.emplace_back(vertices[faces[i][1]]);
-        newVerts.emplace_back(vertices[faces[i][0]]);
-
-        // arrange normals
-        newNorms.emplace_back(normals[faces[i][2]]);
-        newNorms.emplace_back(normals[faces[i][1]]);
-        newNorms.emplace_back(normals[faces[i][0]]);
-
-        // arrange colors
-        newColors.emplace_back(vertex_colors[faces[i][2]]);
-        newColors.emplace_back(vertex_colors[faces[i][1]]);
-        newColors.emplace_back(vertex_colors[faces[i][0]]);
+/// <summary>
+/// Fill this Mesh with a region generated earlier in the packed or heightmap layout, e.g. one read back from
+/// Terrain/TileCache, instead of sampling the noise again. The layout set with setVertexLayout() picks which
+/// of the two arrays is copied, the other one may be empty. The indices are rebuilt, they only depend on the size.
+/// </summary>
+/// <param name="w">width of the region(num of vertices)</param>
+/// <param name="h">height of the region(num of vertices)</param>
+/// <param name="spacing">getSpacing() of the generated region</param>
+/// <param name="heightOffset">getPackedHeightOffset() of the generated region</param>
+/// <param name="heightScale">getPackedHeightScale() of the generated region</param>
+/// <param name="maxHeight">getMaxHeight() of the generated region</param>
+/// <param name="packed">w * h packed vertices, used by the packed layout</param>
+/// <param name="heightmap">w * h quantized heights, used by the heightmap layout</param>
+void Mesh::loadRegion(unsigned int w, unsigned int h, float spacing, float heightOffset, float heightScale, float maxHeight,
+    std::span<const PackedTerrainVertex> packed, std::span<const unsigned short> heightmap) {
+    bool heightmapOnly = vertex_layout == TerrainVertexLayout::Heightmap;
+    freeVector(vertices);
+    freeVector(normals);
+    freeVector(vertex_colors);
+    if (heightmapOnly) {
+        freeVector(packed_vertices);
+        height_map.assign(heightmap.begin(), heightmap.end());
+    }
+    else {
+        packed_vertices.assign(packed.begin(), packed.end());
+        freeVector(height_map);
     }
 
-    //  udate this field to make it easier to draw arrays and access the ordered list later.
-    vertices = newVerts;
-    normals = newNorms;
-    vertex_colors = newColors;
+    vertex_width = w;
+    vertex_length = h;
+    this->spacing = spacing;
+    packed_height_offset = heightOffset;
+    packed_height_scale = heightScale;
+    max_height = maxHeight;
+    triangle_adjacency.offsets.clear();
+    triangle_adjacency.triangles.clear();
+
+    // same counts and indices as generateRegion()
+    vertex_count = w * h;
+    index_count = (w - 1) * (h - 1) * 6;
+    if (heightmapOnly) {
+        freeVector(indices);
+        return;
+    }
+    indices.resize(index_count);
+    if (index_count == 0) { return; }
+    writeGridIndices(w, 0, h - 1, &indices[0]);
 }
 
 /// <summary>
@@ -207,18 +404,39 @@ float Mesh::noise_callback(float x, float y, float z, int octaves, double persis
 }
 
 /// <summary>
-/// 
+/// Batched float version of noise_callback() for a row of samples that share y and z.
+/// The octaves are summed by the noise engine's fBm kernels (see NoiseEngine::fbmBatchGradient()),
+/// along with the analytic slope of every octave.
+/// generateRegion() samples its rows with NoiseEngine::gridSampler() instead, this is the row by row baseline.
 /// </summary>
-/// <param name="loc"></param>
-/// <returns></returns>
-float Mesh::height(cy::Vec2f loc)
+/// <param name="x">x coordinate of every sample</param>
+/// <param name="y">y coordinate shared by the row</param>
+/// <param name="z">z coordinate shared by the row</param>
+/// <param name="count">number of samples in the row</param>
+/// <param name="octaves">number of noise layers to add up</param>
+/// <param name="persistence">amplitude falloff between octaves</param>
+/// <param name="frequency">frequency of the first octave</param>
+/// <param name="out">receives the normalized (0-1) noise value of every sample</param>
+/// <param name="outDx">receives d(out)/dx of every sample</param>
+/// <param name="outDz">receives d(out)/dz of every sample</param>
+void Mesh::noise_row(const float* x, float y, float z, unsigned int count, int octaves, float persistence,
+    float frequency, float* out, float* outDx, float* outDz)
 {
-    return vertices[(loc.y * vertex_width) + loc.x].y;
+    std::vector<float> ys(count, y);
+    std::vector<float> zs(count, z);
+    std::vector<float> dy(count);
+
+    // the amplitude of the first octave cancels out in the normalization, so it is not passed on
+    FbmParams fbm;
+    fbm.octaves = octaves;
+    fbm.persistence = persistence;
+    fbm.frequency = frequency;
+    getNoiseEngine().fbmBatchGradient(x, &ys[0], &zs[0], out, outDx, &dy[0], outDz, count, fbm);
 }
 
 /// <summary>
 /// Get Vertices List - returns a deep copy of vertices
-/// Designed to be rendered using glDrawArrays()
+/// One vertex per grid point, designed to be rendered with the indices from getIndices()
 /// </summary>
 /// <returns>vector of cy::Vec3f indicating vertex positions</returns>
 std::vector<cy::Vec3f> Mesh::getVertices() { return vertices; }
@@ -237,16 +455,309 @@ std::vector<cy::Vec4f> Mesh::getColors() { return vertex_colors; }
 
 /// <summary>
 /// Get Face Indices List - returns a deep copy of indices
-/// Designed to be rendered using glDrawArrays()
+/// Designed to be rendered using glDrawElements() with GL_UNSIGNED_INT
+/// </summary>
+/// <returns>vector of vertex indices, 3 per triangle</returns>
+std::vector<unsigned int> Mesh::getIndices() { return indices; }
+
+/// <summary>
+/// Non-owning view of the vertex positions, valid until the mesh is regenerated or released
+/// </summary>
+std::span<const cy::Vec3f> Mesh::viewVertices() const { return vertices; }
+
+/// <summary>
+/// Non-owning view of the vertex normals, valid until the mesh is regenerated or released
+/// </summary>
+std::span<const cy::Vec3f> Mesh::viewNorms() const { return normals; }
+
+/// <summary>
+/// Non-owning view of the vertex colors, valid until the mesh is regenerated or released
+/// </summary>
+std::span<const cy::Vec4f> Mesh::viewColors() const { return vertex_colors; }
+
+/// <summary>
+/// Non-owning view of the triangle indices, valid until the mesh is regenerated or released
+/// </summary>
+std::span<const unsigned int> Mesh::viewIndices() const { return indices; }
+
+/// <summary>
+/// Number of vertices generated, still valid after releaseVertices()
+/// </summary>
+size_t Mesh::vertexCount() const { return vertex_count; }
+
+/// <summary>
+/// Number of indices generated (3 per triangle), still valid after releaseIndices()
+/// </summary>
+size_t Mesh::indexCount() const { return index_count; }
+
+/// <summary>
+/// Move the vertex positions out of the mesh without copying, the mesh is left without positions
+/// </summary>
+std::vector<cy::Vec3f> Mesh::releaseVertices() { return std::move(vertices); }
+
+/// <summary>
+/// Move the vertex normals out of the mesh without copying, the mesh is left without normals
+/// </summary>
+std::vector<cy::Vec3f> Mesh::releaseNorms() { return std::move(normals); }
+
+/// <summary>
+/// Move the vertex colors out of the mesh without copying, the mesh is left without colors
 /// </summary>
-/// <returns>vector of cy::Vec3f indicating vertex indices in face groups of triangles</returns>
-std::vector<cy::Vec3f> Mesh::getFaces() { return faces; }
+std::vector<cy::Vec4f> Mesh::releaseColors() { return std::move(vertex_colors); }
 
 /// <summary>
-/// Get map of triangles - currently unsupported
+/// Move the triangle indices out of the mesh without copying, the mesh is left without indices
 /// </summary>
-/// <returns> returns map of triangles(vector<int>)</returns>
-std::map<unsigned long, std::vector<int>>  Mesh::getTrianglesMap() { return vertex_to_triangles_map;  }
+std::vector<unsigned int> Mesh::releaseIndices() { return std::move(indices); }
+
+/// <summary>
+/// Move the packed vertices out of the mesh without copying, the mesh is left without packed vertices
+/// </summary>
+std::vector<PackedTerrainVertex> Mesh::releasePackedVertices() { return std::move(packed_vertices); }
+
+/// <summary>
+/// Non-owning view of the packed vertices, empty unless the mesh was generated with the packed layout
+/// </summary>
+std::span<const PackedTerrainVertex> Mesh::viewPackedVertices() const { return packed_vertices; }
+
+/// <summary>
+/// Move the heightmap out of the mesh without copying, the mesh is left without a heightmap
+/// </summary>
+std::vector<unsigned short> Mesh::releaseHeightmap() { return std::move(height_map); }
+
+/// <summary>
+/// Non-owning view of the quantized heights, row by row, empty unless the mesh was generated with the
+/// heightmap layout. World height = getPackedHeightOffset() + value * getPackedHeightScale()
+/// </summary>
+std::span<const unsigned short> Mesh::viewHeightmap() const { return height_map; }
+
+/// <summary>
+/// Pick which vertex arrays the next generateVertices() call fills
+/// </summary>
+/// <param name="layout">Float for separate float arrays, Packed for PackedTerrainVertex</param>
+void Mesh::setVertexLayout(TerrainVertexLayout layout) { vertex_layout = layout; }
+
+/// <summary>
+/// Vertex layout used by generateVertices()
+/// </summary>
+TerrainVertexLayout Mesh::getVertexLayout() const { return vertex_layout; }
+
+/// <summary>
+/// Pick the noise the next generateVertices() call sums up
+/// </summary>
+/// <param name="engine">e.g. NoiseEngine::simplex2D(), nullptr follows NoiseEngine::active()</param>
+void Mesh::setNoiseEngine(const NoiseEngine* engine) { noise_engine = engine; }
+
+/// <summary>
+/// Noise engine used by generateVertices()
+/// </summary>
+const NoiseEngine& Mesh::getNoiseEngine() const { return noise_engine ? *noise_engine : NoiseEngine::active(); }
+
+/// <summary>
+/// Distance between two neighbouring grid vertices, scales the packed x and z
+/// </summary>
+float Mesh::getSpacing() const { return spacing; }
+
+/// <summary>
+/// World height of a packed height of 0 (the lake level)
+/// </summary>
+float Mesh::getPackedHeightOffset() const { return packed_height_offset; }
+
+/// <summary>
+/// World height of one packed height step
+/// </summary>
+float Mesh::getPackedHeightScale() const { return packed_height_scale; }
+
+/// <summary>
+/// Highest point of the map (or the reference height of a region), the colour bands are fractions of it
+/// </summary>
+float Mesh::getMaxHeight() const { return max_height; }
+
+/// <summary>
+/// World height of grid vertex (x, z) in any vertex layout, the packed layouts return the quantized height.
+/// Only valid while the height array of the layout has not been released.
+/// </summary>
+/// <param name="x">grid column</param>
+/// <param name="z">grid row</param>
+float Mesh::getHeight(unsigned int x, unsigned int z) const
+{
+    size_t i = (size_t)z * (unsigned int)vertex_width + x;
+    switch (vertex_layout)
+    {
+    case TerrainVertexLayout::Packed:    return packed_height_offset + packed_vertices[i].height * packed_height_scale;
+    case TerrainVertexLayout::Heightmap: return packed_height_offset + height_map[i] * packed_height_scale;
+    default:                             return vertices[i].y;
+    }
+}
+
+/// <summary>
+/// Colour of a terrain material, Shaders/PackedTerrain.vert and HeightmapTerrain.vert hold the same table
+/// </summary>
+/// <param name="material">surface type of the vertex</param>
+/// <returns>RGBA colour</returns>
+cy::Vec4f Mesh::materialColor(TerrainMaterial material)
+{
+    switch (material)
+    {
+    case TerrainMaterial::Water:
+        return cy::Vec4f(0.0, 0.0, 1.0, 1.0);
+    case TerrainMaterial::Sand:
+        // color: https://htmlcolorcodes.com/colors/sand/
+        return cy::Vec4f(0.7578, 0.6953, 0.5, 1.0);
+    case TerrainMaterial::Grass:
+        // green grass
+        return cy::Vec4f(0.0, 1.0, 0.0, 1.0);
+    default:
+        // stone grey
+        return cy::Vec4f(0.5, 0.5, 0.5, 1.0);
+    }
+}
+
+/// <summary>
+/// Write the triangles of the quad rows [rowBegin, rowEnd) of a w wide vertex grid.
+/// Quad q = r * (w - 1) + c holds the upper triangle 2q and the lower triangle 2q + 1, 6 indices per quad,
+/// each triangle stored v2, v1, v0 to keep the winding the patches were drawn with.
+/// Every grid of the same size gets the same indices, so they can be shared between meshes.
+/// </summary>
+/// <param name="w">width of the grid(num of vertices)</param>
+/// <param name="rowBegin">first quad row to write</param>
+/// <param name="rowEnd">one past the last quad row to write</param>
+/// <param name="out">index buffer of the whole grid, (w - 1) * (h - 1) * 6 entries</param>
+void Mesh::writeGridIndices(unsigned int w, unsigned int rowBegin, unsigned int rowEnd, unsigned int* out)
+{
+    // Rows (-1 for last)
+    for (unsigned int r = rowBegin; r < rowEnd; r++) {
+        // Cols (-1 for last)
+        for (unsigned int c = 0; c < w - 1; c++) {
+            unsigned int f = ((r * (w - 1)) + c) * 6;
+            // Upper triangle
+            /*
+
+                v0 -- v2
+                |    /
+                |  /
+                v1
+            */
+            unsigned int f0_0 = (r * w) + c;
+            unsigned int f0_1 = ((r + 1) * w) + c;
+            unsigned int f0_2 = (r * w) + c + 1;
+            out[f + 0] = f0_2;
+            out[f + 1] = f0_1;
+            out[f + 2] = f0_0;
+
+            // Lower triangle
+            /*
+
+                      v2
+                     / |
+                   /   |
+                v0 --- v1
+            */
+            unsigned int f1_0 = ((r + 1) * w) + c;
+            unsigned int f1_1 = ((r + 1) * w) + c + 1;
+            unsigned int f1_2 = (r * w) + c + 1;
+            out[f + 3] = f1_2;
+            out[f + 4] = f1_1;
+            out[f + 5] = f1_0;
+        }
+    }
+}
+
+/// <summary>
+/// Calls visit(t) for every triangle t that uses grid vertex (r, c), in ascending triangle order.
+/// Quad q = r * (w - 1) + c holds the upper triangle 2q and the lower triangle 2q + 1 (see writeGridIndices).
+/// </summary>
+template <class Visitor>
+static void forEachVertexTriangle(unsigned int r, unsigned int c, unsigned int w, unsigned int h, Visitor visit)
+{
+    unsigned int quadsPerRow = w - 1;
+    if (r > 0 && c > 0) {
+        // bottom right corner of the quad up-left of the vertex
+        visit(2 * ((r - 1) * quadsPerRow + c - 1) + 1);
+    }
+    if (r > 0 && c < w - 1) {
+        // bottom left corner of the quad above the vertex
+        visit(2 * ((r - 1) * quadsPerRow + c));
+        visit(2 * ((r - 1) * quadsPerRow + c) + 1);
+    }
+    if (r < h - 1 && c > 0) {
+        // top right corner of the quad left of the vertex
+        visit(2 * (r * quadsPerRow + c - 1));
+        visit(2 * (r * quadsPerRow + c - 1) + 1);
+    }
+    if (r < h - 1 && c < w - 1) {
+        // top left corner of the quad right of the vertex
+        visit(2 * (r * quadsPerRow + c));
+    }
+}
+
+/// <summary>
+/// Get the vertex to triangle adjacency in compressed sparse row form.
+/// The triangles of vertex v are triangles[offsets[v]] up to (not including) triangles[offsets[v + 1]],
+/// where triangle t is made of indices 3t, 3t + 1 and 3t + 2 of the grid order of writeGridIndices()
+/// (getIndices() where the layout has an index buffer, Shaders/HeightmapTerrain.vert rebuilds the same order).
+/// Only depends on the grid size, so it is the same for every layout and after the arrays are released.
+/// Built in parallel on the first call after generateVertices() and cached afterwards.
+/// Not thread safe - do not call from several threads before it has been built once.
+/// </summary>
+/// <param name="threadCount">number of threads to build with, 0 uses every hardware thread</param>
+/// <returns>reference to the cached adjacency, valid until the mesh is regenerated</returns>
+const VertexTriangleAdjacency& Mesh::getTriangleAdjacency(unsigned int threadCount)
+{
+    if (!triangle_adjacency.offsets.empty() || vertex_count == 0) { return triangle_adjacency; }
+    ThreadPool pool(threadCount);
+    return getTriangleAdjacency(pool);
+}
+
+/// <summary>
+/// Get the vertex to triangle adjacency like getTriangleAdjacency(threadCount), built on a pool the caller keeps
+/// </summary>
+/// <param name="pool">threads to build with</param>
+/// <returns>reference to the cached adjacency, valid until the mesh is regenerated</returns>
+const VertexTriangleAdjacency& Mesh::getTriangleAdjacency(ThreadPool& pool)
+{
+    if (!triangle_adjacency.offsets.empty() || vertex_count == 0) { return triangle_adjacency; }
+
+    unsigned int w = vertex_width;
+    unsigned int h = vertex_length;
+    std::vector<unsigned int>& offsets = triangle_adjacency.offsets;
+    std::vector<unsigned int>& triangles = triangle_adjacency.triangles;
+    offsets.resize((w * h) + 1);
+
+    // count the triangles of every vertex, and total them per row
+    std::vector<unsigned int> rowStart(h + 1, 0);
+    pool.parallelFor(h, [&](size_t rowBegin, size_t rowEnd) {
+        for (unsigned int r = rowBegin; r < rowEnd; r++) {
+            unsigned int rowTotal = 0;
+            for (unsigned int c = 0; c < w; c++) {
+                unsigned int count = 0;
+                forEachVertexTriangle(r, c, w, h, [&count](unsigned int) { count++; });
+                offsets[(r * w) + c] = rowTotal;
+                rowTotal += count;
+            }
+            rowStart[r + 1] = rowTotal;
+        }
+    });
+
+    // prefix sum over the rows, then shift every row's local offsets by its start
+    for (unsigned int r = 0; r < h; r++) {
+        rowStart[r + 1] += rowStart[r];
+    }
+    offsets[w * h] = rowStart[h];
+    triangles.resize(rowStart[h]);
+    pool.parallelFor(h, [&](size_t rowBegin, size_t rowEnd) {
+        for (unsigned int r = rowBegin; r < rowEnd; r++) {
+            for (unsigned int c = 0; c < w; c++) {
+                unsigned int v = (r * w) + c;
+                offsets[v] += rowStart[r];
+                unsigned int next = offsets[v];
+                forEachVertexTriangle(r, c, w, h, [&](unsigned int t) { triangles[next++] = t; });
+            }
+        }
+    });
+
+    return triangle_adjacency;
+}
 
 /// <summary>
 /// calculates mesh width in world coordinates
@@ -268,6 +779,7 @@ float Mesh::getMeshLength()
 
 /// <summary>
 /// Generate Perlin noise
+/// Double precision scalar reference, kept to validate PerlinNoise::sampleBatch() against
 /// Source: https://adrianb.io/2014/08/09/perlinnoise.html
 /// </summary>
 /// <param name="x">x coordinate in the mesh</param>
@@ -276,16 +788,17 @@ float Mesh::getMeshLength()
 /// <returns>a new a value representing the new height of the mesh at the  x,z location</returns>
 double Mesh::perlin(double x, double y, double z)
 {
-    for (int x = 0; x < 512; x++) {
-        p[x] = permutation[x % 256];
-    }
-
-    int xi = (int)x & 255;                              // Calculate the "unit cube" that the point asked will be located in
-    int yi = (int)y & 255;                              // The left bound is ( |_x_|,|_y_|,|_z_| ) and the right bound is that
-    int zi = (int)z & 255;                              // plus 1.  Next we calculate the location (from 0.0 to 1.0) in that cube.
-    double xf = x - (int)x;
-    double yf = y - (int)y;
-    double zf = z - (int)z;
+    const int* p = PerlinNoise::permutationTable();
+
+    double fx = floor(x);                               // floor rather than truncate so negative coordinates
+    double fy = floor(y);                               // land in the right cube (same result for positive ones)
+    double fz = floor(z);
+    int xi = (int)fx & 255;                             // Calculate the "unit cube" that the point asked will be located in
+    int yi = (int)fy & 255;                             // The left bound is ( |_x_|,|_y_|,|_z_| ) and the right bound is that
+    int zi = (int)fz & 255;                             // plus 1.  Next we calculate the location (from 0.0 to 1.0) in that cube.
+    double xf = x - fx;
+    double yf = y - fy;
+    double zf = z - fz;
 
     double u = fade(xf);
     double v = fade(yf);
@@ -377,24 +890,3 @@ double Mesh::grad(int hash, double x, double y, double z) {
 double Mesh::lerp(double a, double b, double x) {
     return a + x * (b - a);
 }
-
-/// <summary>
-/// Initalize permutation array for Perlin Noise
-/// Source: https://adrianb.io/2014/08/09/perlinnoise.html
-/// </summary>
-const int Mesh::permutation[] = { 151, 160, 137, 91, 90, 15,												// Hash lookup table as defined by Ken Perlin.  This is a randomly
-        131, 13, 201, 95, 96, 53, 194, 233, 7, 225, 140, 36, 103, 30, 69, 142, 8, 99, 37, 240, 21, 10, 23,		// arranged array of all numbers from 0-255 inclusive.
-        190, 6, 148, 247, 120, 234, 75, 0, 26, 197, 62, 94, 252, 219, 203, 117, 35, 11, 32, 57, 177, 33,
-        88, 237, 149, 56, 87, 174, 20, 125, 136, 171, 168, 68, 175, 74, 165, 71, 134, 139, 48, 27, 166,
-        77, 146, 158, 231, 83, 111, 229, 122, 60, 211, 133, 230, 220, 105, 92, 41, 55, 46, 245, 40, 244,
-        102, 143, 54, 65, 25, 63, 161, 1, 216, 80, 73, 209, 76, 132, 187, 208, 89, 18, 169, 200, 196,
-        135, 130, 116, 188, 159, 86, 164, 100, 109, 198, 173, 186, 3, 64, 52, 217, 226, 250, 124, 123,
-        5, 202, 38, 147, 118, 126, 255, 82, 85, 212, 207, 206, 59, 227, 47, 16, 58, 17, 182, 189, 28, 42,
-        223, 183, 170, 213, 119, 248, 152, 2, 44, 154, 163, 70, 221, 153, 101, 155, 167, 43, 172, 9,
-        129, 22, 39, 253, 19, 98, 108, 110, 79, 113, 224, 232, 178, 185, 112, 104, 218, 246, 97, 228,
-        251, 34, 242, 193, 238, 210, 144, 12, 191, 179, 162, 241, 81, 51, 145, 235, 249, 14, 239, 107,
-        49, 192, 214, 31, 181, 199, 106, 157, 184, 84, 204, 176, 115, 121, 50, 45, 127, 4, 150, 254,
-        138, 236, 205, 93, 222, 114, 67, 29, 24, 72, 243, 141, 128, 195, 78, 66, 215, 61, 156, 180
-};
-
-int* Mesh::p = new int[512];                           // Doubled permutation to avoid overflow
\ No newline at end of file
@@ -9,43 +9,138 @@
 #pragma once
 
 #include <vector>
-#include <map>
+#include <span>
 #include <stdlib.h>
 #include <math.h>
 #include "glm/vec3.hpp"
 #include "glm/mat4x4.hpp"
 #include "../CyCodeBase/cyVector.h"
 
+class NoiseEngine;
+class ThreadPool;
+
+// Compressed sparse row vertex to triangle adjacency
+// the triangles of vertex v are triangles[offsets[v]] up to triangles[offsets[v + 1]]
+struct VertexTriangleAdjacency
+{
+	std::vector<unsigned int> offsets;
+	std::vector<unsigned int> triangles;
+};
+
+// Surface type of a terrain vertex, stored instead of a float colour by the packed layout
+enum class TerrainMaterial : unsigned char { Water, Sand, Grass, Stone };
+
+// Vertex arrays generateVertices() fills
+// Float:     separate position (12 B), normal (12 B) and colour (16 B) arrays, 40 B per vertex
+// Packed:    one interleaved PackedTerrainVertex array, 12 B per vertex
+// Heightmap: only the quantized heights (2 B per vertex) and no index buffer, the vertex shader
+//            rebuilds everything else from gl_VertexID (see Shaders/HeightmapTerrain.vert)
+enum class TerrainVertexLayout { Float, Packed, Heightmap };
+
+// Quantized interleaved terrain vertex
+// x and z are the grid column and row, height is quantized between the lake level and the
+// highest point of the map (world height = getPackedHeightOffset() + height * getPackedHeightScale())
+// the normal is octahedral encoded into two snorm8 values
+struct PackedTerrainVertex
+{
+	unsigned short x;
+	unsigned short height;
+	unsigned short z;
+	signed char normal[2];
+	TerrainMaterial material;
+	unsigned char padding[3];	// keeps the stride a multiple of 4 bytes
+};
+
+// Generation parameters of a Mesh, and which part of the infinite noise field it covers
+// see Mesh::generateRegion()
+struct TerrainParams
+{
+	int originX = 0;			// grid column of the first vertex
+	int originZ = 0;			// grid row of the first vertex
+	float noiseScale = 0;		// grid vertices per noise unit, 0 stretches one unit over the mesh
+	float referenceHeight = 0;	// height the lake level and colour bands are relative to, 0 uses the mesh max
+	int octaves = 6;			// noise layers added up
+	float persistence = 0.5f;	// amplitude falloff between octaves
+	float frequency = 4;		// frequency of the first octave
+	float amplitude = 128;		// amplitude of the first octave, cancels out in the normalized sum
+	float spacing = 5;			// distance between two neighbouring grid vertices
+	unsigned int step = 1;		// only every step-th grid vertex is generated, a coarse version of the same region
+};
+
 class Mesh
 {
 public:
-	void generateVertices(unsigned int w, unsigned int h);
+	void generateVertices(unsigned int w, unsigned int h, unsigned int threadCount = 0);
+	void generateRegion(unsigned int w, unsigned int h, const TerrainParams& params, unsigned int threadCount = 0);
+	void generateRegion(unsigned int w, unsigned int h, const TerrainParams& params, ThreadPool& pool);
+	float measureMaxHeight(unsigned int w, unsigned int h, const TerrainParams& params, ThreadPool& pool) const;
+	void loadRegion(unsigned int w, unsigned int h, float spacing, float heightOffset, float heightScale, float maxHeight,
+		std::span<const PackedTerrainVertex> packed, std::span<const unsigned short> heightmap);
+	void setVertexLayout(TerrainVertexLayout layout);
+	TerrainVertexLayout getVertexLayout() const;
+	void setNoiseEngine(const NoiseEngine* engine);
+	const NoiseEngine& getNoiseEngine() const;
 	std::vector<cy::Vec3f> getVertices();
 	std::vector<cy::Vec3f> getNorms();
 	std::vector<cy::Vec4f> getColors();
-	std::vector<cy::Vec3f> getFaces();
-	std::map<unsigned long, std::vector<int>> getTrianglesMap();
+	std::vector<unsigned int> getIndices();
+	std::span<const cy::Vec3f> viewVertices() const;
+	std::span<const cy::Vec3f> viewNorms() const;
+	std::span<const cy::Vec4f> viewColors() const;
+	std::span<const unsigned int> viewIndices() const;
+	std::span<const PackedTerrainVertex> viewPackedVertices() const;
+	std::span<const unsigned short> viewHeightmap() const;
+	size_t vertexCount() const;
+	size_t indexCount() const;
+	std::vector<cy::Vec3f> releaseVertices();
+	std::vector<cy::Vec3f> releaseNorms();
+	std::vector<cy::Vec4f> releaseColors();
+	std::vector<unsigned int> releaseIndices();
+	std::vector<PackedTerrainVertex> releasePackedVertices();
+	std::vector<unsigned short> releaseHeightmap();
+	const VertexTriangleAdjacency& getTriangleAdjacency(unsigned int threadCount = 0);
+	const VertexTriangleAdjacency& getTriangleAdjacency(ThreadPool& pool);
 	float getMeshWidth();
 	float getMeshLength();
+	float getSpacing() const;
+	float getPackedHeightOffset() const;
+	float getPackedHeightScale() const;
+	float getMaxHeight() const;
+	float getHeight(unsigned int x, unsigned int z) const;
+
+	static cy::Vec4f materialColor(TerrainMaterial material);
+	static void writeGridIndices(unsigned int w, unsigned int rowBegin, unsigned int rowEnd, unsigned int* out);
 
 private:
+	// Benchmark/BenchmarkMain.cpp times the scalar noise functions and rebuilds the adjacency
+	friend class MeshBenchmark;
+
 	float noise_callback(float x, float y, float z, int octaves, double persistence);
-	float height(cy::Vec2f loc);
+	void noise_row(const float* x, float y, float z, unsigned int count, int octaves, float persistence,
+		float frequency, float* out, float* outDx, float* outDz);
 	double perlin(double x, double y, double z);
 
 	std::vector<cy::Vec3f> vertices;
 	std::vector<cy::Vec3f> normals;
 	std::vector<cy::Vec4f> vertex_colors;
-	std::vector<cy::Vec3f> faces;
-	std::map<unsigned long, std::vector<int>> vertex_to_triangles_map;
+	std::vector<unsigned int> indices;
+	std::vector<PackedTerrainVertex> packed_vertices;
+	std::vector<unsigned short> height_map;
+	TerrainVertexLayout vertex_layout = TerrainVertexLayout::Float;
+	const NoiseEngine* noise_engine = nullptr;	// nullptr follows NoiseEngine::active()
+	float packed_height_offset = 0;
+	float packed_height_scale = 0;
+	float max_height = 0;
+	size_t vertex_count = 0;
+	size_t index_count = 0;
+	VertexTriangleAdjacency triangle_adjacency;
 	float spacing;
 	float vertex_width;
 	float vertex_length;
 
 	// Perlin Noise Generator from: https://adrianb.io/2014/08/09/perlinnoise.html
 	// most of this code is static, const, or both because in this program it does not matter if every mesh looks the same
-	static const int permutation[];
-	static int* p;
+	// the permutation table is shared with the batched implementation in Noise/PerlinNoise
 	static double fade(double t);
 	static double grad(int hash, double x, double y, double z);
 	static double lerp(double a, double b, double x);
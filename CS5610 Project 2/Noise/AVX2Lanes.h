@@ -0,0 +1,50 @@
+/**
+*
+* AVX2 lanes for the noise kernels - 8 points per call.
+* Only include it inside an AVX2 target region, see PerlinAVX2.cpp.
+*
+**/
+
+#pragma once
+
+#include <stddef.h>
+#include <immintrin.h>
+
+// internal linkage, so every translation unit that includes the lanes gets its own copy built for its own target
+namespace {
+
+struct AVX2Lanes
+{
+    static const size_t width = 8;
+    typedef __m256 F;
+    typedef __m256i I;
+    typedef __m256 M;
+
+    static F load(const float* src) { return _mm256_loadu_ps(src); }
+    static void store(float* dst, F a) { _mm256_storeu_ps(dst, a); }
+    static F set1(float a) { return _mm256_set1_ps(a); }
+    static F add(F a, F b) { return _mm256_add_ps(a, b); }
+    static F sub(F a, F b) { return _mm256_sub_ps(a, b); }
+    static F mul(F a, F b) { return _mm256_mul_ps(a, b); }
+    static F floor(F a) { return _mm256_floor_ps(a); }
+
+    static I toInt(F a) { return _mm256_cvttps_epi32(a); }
+    static I set1i(int a) { return _mm256_set1_epi32(a); }
+    static I addi(I a, I b) { return _mm256_add_epi32(a, b); }
+    static I andi(I a, I b) { return _mm256_and_si256(a, b); }
+    template <int N> static I shl(I a) { return _mm256_slli_epi32(a, N); }
+    static I muli(I a, I b) { return _mm256_mullo_epi32(a, b); }
+    static I xori(I a, I b) { return _mm256_xor_si256(a, b); }
+    template <int N> static I shr(I a) { return _mm256_srli_epi32(a, N); }
+    static I gather(const int* table, I index) { return _mm256_i32gather_epi32(table, index, 4); }
+
+    static M less(I a, I b) { return _mm256_castsi256_ps(_mm256_cmpgt_epi32(b, a)); }
+    static M equal(I a, I b) { return _mm256_castsi256_ps(_mm256_cmpeq_epi32(a, b)); }
+    static M either(M a, M b) { return _mm256_or_ps(a, b); }
+    static M lessf(F a, F b) { return _mm256_cmp_ps(a, b, _CMP_LT_OQ); }
+    static F max(F a, F b) { return _mm256_max_ps(a, b); }
+    static F select(M mask, F a, F b) { return _mm256_blendv_ps(b, a, mask); }
+    static F flipSign(F a, I bits) { return _mm256_xor_ps(a, _mm256_castsi256_ps(bits)); }
+};
+
+}
@@ -0,0 +1,51 @@
+/**
+*
+* AVX-512 lanes for the noise kernels - 16 points per call.
+* Only include it inside an AVX-512F target region, see PerlinAVX512.cpp.
+*
+**/
+
+#pragma once
+
+#include <stddef.h>
+#include <immintrin.h>
+
+// internal linkage, so every translation unit that includes the lanes gets its own copy built for its own target
+namespace {
+
+struct AVX512Lanes
+{
+    static const size_t width = 16;
+    typedef __m512 F;
+    typedef __m512i I;
+    typedef __mmask16 M;
+
+    static F load(const float* src) { return _mm512_loadu_ps(src); }
+    static void store(float* dst, F a) { _mm512_storeu_ps(dst, a); }
+    static F set1(float a) { return _mm512_set1_ps(a); }
+    static F add(F a, F b) { return _mm512_add_ps(a, b); }
+    static F sub(F a, F b) { return _mm512_sub_ps(a, b); }
+    static F mul(F a, F b) { return _mm512_mul_ps(a, b); }
+    static F floor(F a) { return _mm512_roundscale_ps(a, _MM_FROUND_TO_NEG_INF | _MM_FROUND_NO_EXC); }
+
+    static I toInt(F a) { return _mm512_cvttps_epi32(a); }
+    static I set1i(int a) { return _mm512_set1_epi32(a); }
+    static I addi(I a, I b) { return _mm512_add_epi32(a, b); }
+    static I andi(I a, I b) { return _mm512_and_si512(a, b); }
+    template <int N> static I shl(I a) { return _mm512_slli_epi32(a, N); }
+    static I muli(I a, I b) { return _mm512_mullo_epi32(a, b); }
+    static I xori(I a, I b) { return _mm512_xor_si512(a, b); }
+    template <int N> static I shr(I a) { return _mm512_srli_epi32(a, N); }
+    static I gather(const int* table, I index) { return _mm512_i32gather_epi32(index, table, 4); }
+
+    static M less(I a, I b) { return _mm512_cmplt_epi32_mask(a, b); }
+    static M equal(I a, I b) { return _mm512_cmpeq_epi32_mask(a, b); }
+    static M either(M a, M b) { return (M)(a | b); }
+    static M lessf(F a, F b) { return _mm512_cmp_ps_mask(a, b, _CMP_LT_OQ); }
+    static F max(F a, F b) { return _mm512_max_ps(a, b); }
+    static F select(M mask, F a, F b) { return _mm512_mask_blend_ps(mask, b, a); }
+    // float xor needs AVX-512DQ, the integer form only needs AVX-512F
+    static F flipSign(F a, I bits) { return _mm512_castsi512_ps(_mm512_xor_si512(_mm512_castps_si512(a), bits)); }
+};
+
+}
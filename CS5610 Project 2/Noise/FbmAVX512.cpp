@@ -0,0 +1,44 @@
+/**
+*
+* AVX-512 lanes for the fBm kernels - 16 points per call.
+* Compiled for AVX-512F only inside the target region below, the dispatcher in FbmNoise.cpp
+* makes sure it only runs on CPUs that support it.
+*
+**/
+
+#include "FbmNoise.h"
+#include "PerlinNoise.h"
+#include "FbmSchedule.h"
+
+#include <utility>
+#include <immintrin.h>
+
+#if defined(__clang__)
+#pragma clang attribute push (__attribute__((target("avx512f"))), apply_to = function)
+#elif defined(__GNUC__)
+#pragma GCC push_options
+#pragma GCC target("avx512f")
+#pragma GCC optimize("fp-contract=off")
+#endif
+
+// included inside the target region so the lanes and the kernel templates are compiled for this instruction set
+#include "AVX512Lanes.h"
+#include "FbmKernel.h"
+
+void fbmBatchAVX512(FbmNoise::Basis basis, const FbmParams& params, const float* x, const float* y, const float* z, float* out, size_t count)
+{
+    size_t done = fbm_kernel::dispatch<AVX512Lanes, false>(basis, params, { x, y, z, out, nullptr, nullptr, nullptr, count });
+    fbmBatchScalar(basis, params, x + done, y + done, z + done, out + done, count - done);
+}
+
+void fbmBatchGradientAVX512(FbmNoise::Basis basis, const FbmParams& params, const float* x, const float* y, const float* z, float* out, float* dx, float* dy, float* dz, size_t count)
+{
+    size_t done = fbm_kernel::dispatch<AVX512Lanes, true>(basis, params, { x, y, z, out, dx, dy, dz, count });
+    fbmBatchGradientScalar(basis, params, x + done, y + done, z + done, out + done, dx + done, dy + done, dz + done, count - done);
+}
+
+#if defined(__clang__)
+#pragma clang attribute pop
+#elif defined(__GNUC__)
+#pragma GCC pop_options
+#endif
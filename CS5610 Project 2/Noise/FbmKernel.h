@@ -0,0 +1,181 @@
+/**
+*
+* Instruction set independent fBm kernels, written against the lanes interface of PerlinKernel.h.
+* A kernel is a template on
+*   the lanes V                 scalar or SIMD width, one instantiation per instruction set translation unit
+*   the basis                   the noise of every octave, and with it the dimension: 2D bases never load y
+*   the octave count            the octave loop is unrolled, every octave is sampled by the same V::width lanes
+*   the amplitude schedule      ConstantSchedule works the normalized octave weights out at compile time,
+*                               RuntimeSchedule once per batch for persistences without a schedule of their own
+* dispatch() maps the runtime FbmParams to this fixed set of instantiations.
+*
+**/
+
+#pragma once
+
+#include <utility>
+#include "PerlinKernel.h"
+#include "SimplexKernel.h"
+#include "PerlinNoise.h"
+#include "FbmNoise.h"
+#include "FbmSchedule.h"
+
+namespace fbm_kernel {
+
+using perlin_kernel::Gradient;
+
+template <class Hash>
+struct PerlinBasis
+{
+	static const int dimensions = 3;
+	Hash hash;
+
+	template <class V, bool Derivatives>
+	typename V::F noise(typename V::F x, typename V::F y, typename V::F z, Gradient<V>& gradient) const
+	{
+		if (Derivatives) { return perlin_kernel::noiseGradient<V>(hash, x, y, z, gradient); }
+		return perlin_kernel::noise<V>(hash, x, y, z);
+	}
+};
+
+struct Simplex2Basis
+{
+	static const int dimensions = 2;
+
+	template <class V, bool Derivatives>
+	typename V::F noise(typename V::F x, typename V::F /*y*/, typename V::F z, Gradient<V>& gradient) const
+	{
+		gradient.y = V::set1(0.0f);
+		return simplex_kernel::noise2<V, Derivatives>(x, z, gradient.x, gradient.z);
+	}
+};
+
+struct Simplex3Basis
+{
+	static const int dimensions = 3;
+
+	template <class V, bool Derivatives>
+	typename V::F noise(typename V::F x, typename V::F y, typename V::F z, Gradient<V>& gradient) const
+	{
+		return simplex_kernel::noise3<V, Derivatives>(x, y, z, gradient);
+	}
+};
+
+// The arrays of one batch call, dx, dy and dz are only written by the Derivatives kernels
+struct Points
+{
+	const float* x;
+	const float* y;
+	const float* z;
+	float* out;
+	float* dx;
+	float* dy;
+	float* dz;
+	size_t count;
+};
+
+// Add one octave, sampled at frequency * 2^Octave, to the weighted sum.
+// Its slope scales with its frequency, like in Mesh::noise_row().
+template <class V, bool Derivatives, int Octave, class Basis, class Schedule>
+inline void addOctave(const Basis& basis, const Schedule& schedule, float frequency,
+	typename V::F x, typename V::F y, typename V::F z, typename V::F& total, Gradient<V>& slope)
+{
+	typedef typename V::F F;
+
+	float octaveFrequency = frequency * (float)(1 << Octave);
+	F f = V::set1(octaveFrequency);
+	F w = V::set1(schedule.template weight<Octave>());
+	Gradient<V> g;
+	F yf = Basis::dimensions == 2 ? y : V::mul(y, f);
+	F n = basis.template noise<V, Derivatives>(V::mul(x, f), yf, V::mul(z, f), g);
+	total = V::add(total, V::mul(n, w));
+	if (Derivatives)
+	{
+		F wf = V::set1(schedule.template weight<Octave>() * octaveFrequency);
+		slope.x = V::add(slope.x, V::mul(g.x, wf));
+		slope.y = V::add(slope.y, V::mul(g.y, wf));
+		slope.z = V::add(slope.z, V::mul(g.z, wf));
+	}
+}
+
+// fBm of V::width points with every octave unrolled, normalized to 0 - 1
+template <class V, bool Derivatives, int Octaves, class Basis, class Schedule>
+inline typename V::F fbm(const Basis& basis, const Schedule& schedule, float frequency,
+	typename V::F x, typename V::F y, typename V::F z, Gradient<V>& slope)
+{
+	typename V::F total = V::set1(0.0f);
+	slope = { total, total, total };
+	[&]<int... O>(std::integer_sequence<int, O...>) {
+		(addOctave<V, Derivatives, O>(basis, schedule, frequency, x, y, z, total, slope), ...);
+	}(std::make_integer_sequence<int, Octaves>());
+	return total;
+}
+
+// Evaluate as many whole V::width groups as fit in the batch, returns how many points were written
+template <class V, bool Derivatives, int Octaves, class Basis, class Schedule>
+inline size_t batch(const Basis& basis, const Schedule& schedule, float frequency, const Points& points)
+{
+	size_t i = 0;
+	for (; i + V::width <= points.count; i += V::width)
+	{
+		Gradient<V> g;
+		typename V::F y = Basis::dimensions == 2 ? V::set1(0.0f) : V::load(points.y + i);
+		V::store(points.out + i, fbm<V, Derivatives, Octaves>(basis, schedule, frequency,
+			V::load(points.x + i), y, V::load(points.z + i), g));
+		if (Derivatives)
+		{
+			V::store(points.dx + i, g.x);
+			V::store(points.dy + i, g.y);
+			V::store(points.dz + i, g.z);
+		}
+	}
+	return i;
+}
+
+// the persistence of the shipped terrain gets its weights folded at compile time
+template <class V, bool Derivatives, int Octaves, class Basis>
+inline size_t batchSchedule(const Basis& basis, const FbmParams& params, const Points& points)
+{
+	if (params.persistence == 0.5f)
+	{
+		return batch<V, Derivatives, Octaves>(basis, ConstantSchedule<Octaves, 1, 2>(), params.frequency, points);
+	}
+	return batch<V, Derivatives, Octaves>(basis, RuntimeSchedule<Octaves>(params.persistence), params.frequency, points);
+}
+
+template <class V, bool Derivatives, class Basis>
+inline size_t batchOctaves(const Basis& basis, const FbmParams& params, const Points& points)
+{
+	static_assert(FbmNoise::maxOctaves == 8, "every octave count up to maxOctaves needs a case below");
+	switch (params.octaves)
+	{
+	case 1: return batchSchedule<V, Derivatives, 1>(basis, params, points);
+	case 2: return batchSchedule<V, Derivatives, 2>(basis, params, points);
+	case 3: return batchSchedule<V, Derivatives, 3>(basis, params, points);
+	case 4: return batchSchedule<V, Derivatives, 4>(basis, params, points);
+	case 5: return batchSchedule<V, Derivatives, 5>(basis, params, points);
+	case 6: return batchSchedule<V, Derivatives, 6>(basis, params, points);
+	case 7: return batchSchedule<V, Derivatives, 7>(basis, params, points);
+	case 8: return batchSchedule<V, Derivatives, 8>(basis, params, points);
+	default: return 0;
+	}
+}
+
+// Pick the instantiation for the runtime basis and parameters, see FbmNoise::specialized()
+template <class V, bool Derivatives>
+inline size_t dispatch(FbmNoise::Basis basis, const FbmParams& params, const Points& points)
+{
+	switch (basis)
+	{
+	case FbmNoise::Basis::PerlinPermutation:
+		return batchOctaves<V, Derivatives>(PerlinBasis<perlin_kernel::TableHash>{ { PerlinNoise::permutationTable() } }, params, points);
+	case FbmNoise::Basis::PerlinInteger:
+		return batchOctaves<V, Derivatives>(PerlinBasis<perlin_kernel::IntegerHash>(), params, points);
+	case FbmNoise::Basis::Simplex2D:
+		return batchOctaves<V, Derivatives>(Simplex2Basis(), params, points);
+	default:
+		return batchOctaves<V, Derivatives>(Simplex3Basis(), params, points);
+	}
+}
+
+}
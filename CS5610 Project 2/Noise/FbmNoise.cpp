@@ -0,0 +1,91 @@
+/**
+*
+* Batched fractal Brownian motion - sums octaves of a noise with kernels specialized at compile time
+* for the octave count, the noise (and with it the dimension) and the instruction set, see FbmKernel.h.
+*
+**/
+
+#include "FbmNoise.h"
+#include "PerlinNoise.h"
+
+// no FMA contraction in the kernels, see PerlinKernel.h
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC optimize("fp-contract=off")
+#endif
+
+#include "ScalarLanes.h"
+#include "FbmKernel.h"
+
+void fbmBatchScalar(FbmNoise::Basis basis, const FbmParams& params, const float* x, const float* y, const float* z, float* out, size_t count)
+{
+    fbm_kernel::dispatch<ScalarLanes, false>(basis, params, { x, y, z, out, nullptr, nullptr, nullptr, count });
+}
+
+void fbmBatchGradientScalar(FbmNoise::Basis basis, const FbmParams& params, const float* x, const float* y, const float* z, float* out, float* dx, float* dy, float* dz, size_t count)
+{
+    fbm_kernel::dispatch<ScalarLanes, true>(basis, params, { x, y, z, out, dx, dy, dz, count });
+}
+
+/// <summary>
+/// Whether the octave count of params has kernels of its own. Other counts are left to the
+/// octave by octave loop of NoiseEngine.
+/// </summary>
+bool FbmNoise::specialized(const FbmParams& params)
+{
+    return params.octaves >= 1 && params.octaves <= maxOctaves;
+}
+
+/// <summary>
+/// Evaluate the fBm of count points at once with the instruction set PerlinNoise::simdLevel() picks.
+/// Output matches the scalar kernel bit for bit whatever instruction set is picked.
+/// </summary>
+/// <param name="basis">noise of every octave, 2D bases ignore y</param>
+/// <param name="params">octave count, persistence and frequency of the first octave</param>
+/// <param name="x">x coordinates of the points</param>
+/// <param name="y">y coordinates of the points</param>
+/// <param name="z">z coordinates of the points</param>
+/// <param name="out">receives the normalized (0 - 1) sum of every point</param>
+/// <param name="count">number of points</param>
+/// <returns>false without writing anything if params are not specialized()</returns>
+bool FbmNoise::sampleBatch(Basis basis, const FbmParams& params,
+    const float* x, const float* y, const float* z, float* out, size_t count)
+{
+    if (!specialized(params)) { return false; }
+    switch (PerlinNoise::simdLevel())
+    {
+    case PerlinNoise::SimdLevel::AVX512: fbmBatchAVX512(basis, params, x, y, z, out, count); break;
+    case PerlinNoise::SimdLevel::AVX2:   fbmBatchAVX2(basis, params, x, y, z, out, count); break;
+    case PerlinNoise::SimdLevel::SSE41:  fbmBatchSSE41(basis, params, x, y, z, out, count); break;
+    default:                             fbmBatchScalar(basis, params, x, y, z, out, count); break;
+    }
+    return true;
+}
+
+/// <summary>
+/// Evaluate the fBm and its analytic gradient for count points at once.
+/// out matches sampleBatch() bit for bit, dx/dy/dz are the partial derivatives of out.
+/// </summary>
+/// <param name="basis">noise of every octave, 2D bases ignore y and write a dy of 0</param>
+/// <param name="params">octave count, persistence and frequency of the first octave</param>
+/// <param name="x">x coordinates of the points</param>
+/// <param name="y">y coordinates of the points</param>
+/// <param name="z">z coordinates of the points</param>
+/// <param name="out">receives the normalized (0 - 1) sum of every point</param>
+/// <param name="dx">receives d(out)/dx of every point</param>
+/// <param name="dy">receives d(out)/dy of every point</param>
+/// <param name="dz">receives d(out)/dz of every point</param>
+/// <param name="count">number of points</param>
+/// <returns>false without writing anything if params are not specialized()</returns>
+bool FbmNoise::sampleBatchGradient(Basis basis, const FbmParams& params, const float* x, const float* y, const float* z,
+    float* out, float* dx, float* dy, float* dz, size_t count)
+{
+    if (!specialized(params)) { return false; }
+    switch (PerlinNoise::simdLevel())
+    {
+    case PerlinNoise::SimdLevel::AVX512: fbmBatchGradientAVX512(basis, params, x, y, z, out, dx, dy, dz, count); break;
+    case PerlinNoise::SimdLevel::AVX2:   fbmBatchGradientAVX2(basis, params, x, y, z, out, dx, dy, dz, count); break;
+    case PerlinNoise::SimdLevel::SSE41:  fbmBatchGradientSSE41(basis, params, x, y, z, out, dx, dy, dz, count); break;
+    default:                             fbmBatchGradientScalar(basis, params, x, y, z, out, dx, dy, dz, count); break;
+    }
+    return true;
+}
@@ -0,0 +1,44 @@
+/**
+*
+* Batched fractal Brownian motion - sums octaves of a noise with kernels specialized at compile time
+* for the octave count, the noise (and with it the dimension) and the instruction set, see FbmKernel.h.
+*
+**/
+
+#pragma once
+
+#include <stddef.h>
+
+// Every octave has twice the frequency of the previous one and persistence times its amplitude.
+// The sum is normalized back to 0 - 1, so the amplitude of the first octave cancels out.
+struct FbmParams
+{
+	int octaves = 6;
+	float persistence = 0.5f;
+	float frequency = 4;	// frequency of the first octave
+};
+
+class FbmNoise
+{
+public:
+	// noise the octaves are made of
+	enum class Basis { PerlinPermutation, PerlinInteger, Simplex2D, Simplex3D };
+	// octave counts 1 - maxOctaves have kernels of their own
+	static const int maxOctaves = 8;
+
+	static bool specialized(const FbmParams& params);
+	static bool sampleBatch(Basis basis, const FbmParams& params,
+		const float* x, const float* y, const float* z, float* out, size_t count);
+	static bool sampleBatchGradient(Basis basis, const FbmParams& params, const float* x, const float* y, const float* z,
+		float* out, float* dx, float* dy, float* dz, size_t count);
+};
+
+// per instruction set kernels, each lives in its own translation unit like the Perlin ones
+void fbmBatchScalar(FbmNoise::Basis basis, const FbmParams& params, const float* x, const float* y, const float* z, float* out, size_t count);
+void fbmBatchSSE41(FbmNoise::Basis basis, const FbmParams& params, const float* x, const float* y, const float* z, float* out, size_t count);
+void fbmBatchAVX2(FbmNoise::Basis basis, const FbmParams& params, const float* x, const float* y, const float* z, float* out, size_t count);
+void fbmBatchAVX512(FbmNoise::Basis basis, const FbmParams& params, const float* x, const float* y, const float* z, float* out, size_t count);
+void fbmBatchGradientScalar(FbmNoise::Basis basis, const FbmParams& params, const float* x, const float* y, const float* z, float* out, float* dx, float* dy, float* dz, size_t count);
+void fbmBatchGradientSSE41(FbmNoise::Basis basis, const FbmParams& params, const float* x, const float* y, const float* z, float* out, float* dx, float* dy, float* dz, size_t count);
+void fbmBatchGradientAVX2(FbmNoise::Basis basis, const FbmParams& params, const float* x, const float* y, const float* z, float* out, float* dx, float* dy, float* dz, size_t count);
+void fbmBatchGradientAVX512(FbmNoise::Basis basis, const FbmParams& params, const float* x, const float* y, const float* z, float* out, float* dx, float* dy, float* dz, size_t count);
@@ -0,0 +1,64 @@
+/**
+*
+* Amplitude schedules of the fBm kernels (FbmKernel.h) - the normalized weight of every octave.
+* They do not depend on the lanes, so the instruction set translation units include this header before their
+* target region: a schedule compiled for AVX-512 there would be the same inline symbol the scalar kernels use,
+* and the linker could keep that copy for both.
+*
+**/
+
+#pragma once
+
+namespace fbm_kernel {
+
+// Octave weights of a persistence of Numerator / Denominator, the amplitude of every octave divided by
+// the sum of all of them, folded into constants
+template <int Octaves, int Numerator, int Denominator>
+struct ConstantSchedule
+{
+	static constexpr float weightOf(int octave)
+	{
+		double amplitude = 1;
+		double sum = 0;
+		double weight = 0;
+		for (int o = 0; o < Octaves; o++)
+		{
+			if (o == octave) { weight = amplitude; }
+			sum += amplitude;
+			amplitude = amplitude * Numerator / Denominator;
+		}
+		return (float)(weight / sum);
+	}
+
+	template <int Octave>
+	float weight() const
+	{
+		constexpr float w = weightOf(Octave);
+		return w;
+	}
+};
+
+// Same weights for any persistence, worked out once per batch
+template <int Octaves>
+struct RuntimeSchedule
+{
+	float weights[Octaves];
+
+	explicit RuntimeSchedule(float persistence)
+	{
+		float amplitude = 1;
+		float sum = 0;
+		for (int o = 0; o < Octaves; o++)
+		{
+			weights[o] = amplitude;
+			sum += amplitude;
+			amplitude *= persistence;
+		}
+		for (int o = 0; o < Octaves; o++) { weights[o] /= sum; }
+	}
+
+	template <int Octave>
+	float weight() const { return weights[Octave]; }
+};
+
+}
@@ -0,0 +1,260 @@
+/**
+*
+* Pluggable noise function of the terrain - Mesh sums octaves of whichever engine it is given.
+*
+**/
+
+#include "NoiseEngine.h"
+#include "PerlinNoise.h"
+#include "PerlinGrid.h"
+#include "SimplexNoise.h"
+
+#include <string.h>
+#include <vector>
+
+namespace {
+
+class PerlinEngine : public NoiseEngine
+{
+public:
+    const char* name() const override { return "perlin"; }
+
+    void sampleBatch(const float* x, const float* y, const float* z, float* out, size_t count) const override
+    {
+        PerlinNoise::sampleBatch(x, y, z, out, count);
+    }
+
+    void sampleBatchGradient(const float* x, const float* y, const float* z,
+        float* out, float* dx, float* dy, float* dz, size_t count) const override
+    {
+        PerlinNoise::sampleBatchGradient(x, y, z, out, dx, dy, dz, count);
+    }
+
+    float sample(float x, float y, float z) const override { return PerlinNoise::sample(x, y, z); }
+
+    // hashes every lattice point of a row once and shares the cells between the samples, see PerlinGrid.h
+    std::unique_ptr<NoiseGridSampler> gridSampler(const float* x, unsigned int columns, float y, const FbmParams& params) const override
+    {
+        return std::unique_ptr<NoiseGridSampler>(new PerlinGridSampler(*this, PerlinNoise::hashing(), x, columns, y, params));
+    }
+
+protected:
+    bool fbmBasis(FbmNoise::Basis& basis) const override
+    {
+        basis = PerlinNoise::hashing() == PerlinNoise::Hashing::Integer ? FbmNoise::Basis::PerlinInteger : FbmNoise::Basis::PerlinPermutation;
+        return true;
+    }
+};
+
+class Simplex2DEngine : public NoiseEngine
+{
+public:
+    const char* name() const override { return "simplex2d"; }
+
+    void sampleBatch(const float* x, const float* /*y*/, const float* z, float* out, size_t count) const override
+    {
+        SimplexNoise::sampleBatch2D(x, z, out, count);
+    }
+
+    // the noise does not change along y, so its derivative along y is 0
+    void sampleBatchGradient(const float* x, const float* /*y*/, const float* z,
+        float* out, float* dx, float* dy, float* dz, size_t count) const override
+    {
+        SimplexNoise::sampleBatchGradient2D(x, z, out, dx, dz, count);
+        for (size_t i = 0; i < count; i++) { dy[i] = 0.0f; }
+    }
+
+    float sample(float x, float /*y*/, float z) const override { return SimplexNoise::sample2D(x, z); }
+
+protected:
+    bool fbmBasis(FbmNoise::Basis& basis) const override
+    {
+        basis = FbmNoise::Basis::Simplex2D;
+        return true;
+    }
+};
+
+class Simplex3DEngine : public NoiseEngine
+{
+public:
+    const char* name() const override { return "simplex3d"; }
+
+    void sampleBatch(const float* x, const float* y, const float* z, float* out, size_t count) const override
+    {
+        SimplexNoise::sampleBatch3D(x, y, z, out, count);
+    }
+
+    void sampleBatchGradient(const float* x, const float* y, const float* z,
+        float* out, float* dx, float* dy, float* dz, size_t count) const override
+    {
+        SimplexNoise::sampleBatchGradient3D(x, y, z, out, dx, dy, dz, count);
+    }
+
+    float sample(float x, float y, float z) const override { return SimplexNoise::sample3D(x, y, z); }
+
+protected:
+    bool fbmBasis(FbmNoise::Basis& basis) const override
+    {
+        basis = FbmNoise::Basis::Simplex3D;
+        return true;
+    }
+};
+
+const PerlinEngine perlinEngine;
+const Simplex2DEngine simplex2DEngine;
+const Simplex3DEngine simplex3DEngine;
+const NoiseEngine* const engines[] = { &perlinEngine, &simplex2DEngine, &simplex3DEngine };
+
+}
+
+const NoiseEngine* NoiseEngine::activeEngine = &perlinEngine;
+
+/// <summary>
+/// 3D Perlin noise, the engine terrain was generated with before engines existed
+/// </summary>
+const NoiseEngine& NoiseEngine::perlin()
+{
+    return perlinEngine;
+}
+
+/// <summary>
+/// 2D OpenSimplex2 in the x, z plane, the y coordinate is ignored
+/// </summary>
+const NoiseEngine& NoiseEngine::simplex2D()
+{
+    return simplex2DEngine;
+}
+
+/// <summary>
+/// 3D OpenSimplex2
+/// </summary>
+const NoiseEngine& NoiseEngine::simplex3D()
+{
+    return simplex3DEngine;
+}
+
+/// <summary>
+/// Sum the octaves of this engine's noise for count points at once, with the analytic gradient of the sum.
+/// Uses the FbmNoise kernel of the octave count where there is one, and fbmBatchGradientLoop() otherwise.
+/// </summary>
+/// <param name="x">x coordinates of the points</param>
+/// <param name="y">y coordinates of the points</param>
+/// <param name="z">z coordinates of the points</param>
+/// <param name="out">receives the normalized (0 - 1) sum of every point</param>
+/// <param name="dx">receives d(out)/dx of every point</param>
+/// <param name="dy">receives d(out)/dy of every point</param>
+/// <param name="dz">receives d(out)/dz of every point</param>
+/// <param name="count">number of points</param>
+/// <param name="params">octave count, persistence and frequency of the first octave</param>
+void NoiseEngine::fbmBatchGradient(const float* x, const float* y, const float* z,
+    float* out, float* dx, float* dy, float* dz, size_t count, const FbmParams& params) const
+{
+    FbmNoise::Basis basis;
+    if (fbmBasis(basis) && FbmNoise::sampleBatchGradient(basis, params, x, y, z, out, dx, dy, dz, count)) { return; }
+    fbmBatchGradientLoop(x, y, z, out, dx, dy, dz, count, params);
+}
+
+/// <summary>
+/// Same as fbmBatchGradient() with the octaves and the persistence as runtime values: one sampleBatchGradient()
+/// call per octave, summed up through scratch arrays. Works for any engine and octave count, and is what the
+/// specialized kernels are benchmarked against.
+/// </summary>
+void NoiseEngine::fbmBatchGradientLoop(const float* x, const float* y, const float* z,
+    float* out, float* dx, float* dy, float* dz, size_t count, const FbmParams& params) const
+{
+    std::vector<float> xs(count);
+    std::vector<float> ys(count);
+    std::vector<float> zs(count);
+    std::vector<float> octave(count);
+    std::vector<float> octaveDx(count);
+    std::vector<float> octaveDy(count);
+    std::vector<float> octaveDz(count);
+    for (size_t i = 0; i < count; i++)
+    {
+        out[i] = 0.0f;
+        dx[i] = 0.0f;
+        dy[i] = 0.0f;
+        dz[i] = 0.0f;
+    }
+
+    float frequency = params.frequency;
+    float amplitude = 1;
+    float maxValue = 0;  // Used for normalizing result to 0.0 - 1.0
+    for (int o = 0; o < params.octaves; o++)
+    {
+        for (size_t i = 0; i < count; i++)
+        {
+            xs[i] = x[i] * frequency;
+            ys[i] = y[i] * frequency;
+            zs[i] = z[i] * frequency;
+        }
+        sampleBatchGradient(&xs[0], &ys[0], &zs[0], &octave[0], &octaveDx[0], &octaveDy[0], &octaveDz[0], count);
+        // the octave is sampled at position * frequency, so its slope scales with the frequency too
+        for (size_t i = 0; i < count; i++)
+        {
+            out[i] += octave[i] * amplitude;
+            dx[i] += octaveDx[i] * amplitude * frequency;
+            dy[i] += octaveDy[i] * amplitude * frequency;
+            dz[i] += octaveDz[i] * amplitude * frequency;
+        }
+
+        maxValue += amplitude;
+
+        amplitude *= params.persistence;
+        frequency *= 2;
+    }
+
+    for (size_t i = 0; i < count; i++)
+    {
+        out[i] /= maxValue;
+        dx[i] /= maxValue;
+        dy[i] /= maxValue;
+        dz[i] /= maxValue;
+    }
+}
+
+/// <summary>
+/// Sampler of a grid whose rows share the columns x and the coordinate y, and only differ in z.
+/// Engines without a grid sampler of their own sample every row with fbmBatchGradient().
+/// The engine has to outlive the sampler.
+/// </summary>
+/// <param name="x">x coordinate of every column</param>
+/// <param name="columns">samples per row</param>
+/// <param name="y">y coordinate shared by every sample</param>
+/// <param name="params">octave count, persistence and frequency of the first octave</param>
+std::unique_ptr<NoiseGridSampler> NoiseEngine::gridSampler(const float* x, unsigned int columns, float y, const FbmParams& params) const
+{
+    return std::unique_ptr<NoiseGridSampler>(new RowGridSampler(*this, x, columns, y, params));
+}
+
+/// <summary>
+/// Look an engine up by its name()
+/// </summary>
+/// <param name="name">perlin, simplex2d or simplex3d</param>
+/// <returns>the engine, or nullptr if no engine has that name</returns>
+const NoiseEngine* NoiseEngine::find(const char* name)
+{
+    for (const NoiseEngine* engine : engines)
+    {
+        if (strcmp(engine->name(), name) == 0) { return engine; }
+    }
+    return nullptr;
+}
+
+/// <summary>
+/// Engine of every Mesh that was not given one with Mesh::setNoiseEngine()
+/// </summary>
+const NoiseEngine& NoiseEngine::active()
+{
+    return *activeEngine;
+}
+
+/// <summary>
+/// Change the default engine.
+/// Not thread safe - only call while no terrain is being generated.
+/// </summary>
+/// <param name="engine">engine to use from now on</param>
+void NoiseEngine::setActive(const NoiseEngine& engine)
+{
+    activeEngine = &engine;
+}
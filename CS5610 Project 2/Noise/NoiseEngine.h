@@ -0,0 +1,53 @@
+/**
+*
+* Pluggable noise function of the terrain - Mesh sums octaves of whichever engine it is given.
+*   perlin:    3D Perlin noise (PerlinNoise), eight corners per sample
+*   simplex2d: 2D OpenSimplex2 in the ground plane (SimplexNoise), three corners per sample, ignores y
+*   simplex3d: 3D OpenSimplex2 (SimplexNoise), four corners per sample
+* Every engine returns values between 0 and 1 and uses the instruction set PerlinNoise::simdLevel() picks.
+* fbmBatchGradient() sums the octaves with the specialized kernels of FbmNoise where it has them,
+* gridSampler() samples whole grids of rows and reuses what the rows share (NoiseGrid.h).
+*
+**/
+
+#pragma once
+
+#include <stddef.h>
+#include <memory>
+#include "FbmNoise.h"
+#include "NoiseGrid.h"
+
+class NoiseEngine
+{
+public:
+	virtual ~NoiseEngine() = default;
+
+	virtual const char* name() const = 0;
+	virtual void sampleBatch(const float* x, const float* y, const float* z, float* out, size_t count) const = 0;
+	virtual void sampleBatchGradient(const float* x, const float* y, const float* z,
+		float* out, float* dx, float* dy, float* dz, size_t count) const = 0;
+	virtual float sample(float x, float y, float z) const = 0;
+
+	void fbmBatchGradient(const float* x, const float* y, const float* z,
+		float* out, float* dx, float* dy, float* dz, size_t count, const FbmParams& params) const;
+	void fbmBatchGradientLoop(const float* x, const float* y, const float* z,
+		float* out, float* dx, float* dy, float* dz, size_t count, const FbmParams& params) const;
+
+	// sampler of rows that share the columns x and the coordinate y, see NoiseGrid.h
+	virtual std::unique_ptr<NoiseGridSampler> gridSampler(const float* x, unsigned int columns, float y, const FbmParams& params) const;
+
+	static const NoiseEngine& perlin();
+	static const NoiseEngine& simplex2D();
+	static const NoiseEngine& simplex3D();
+	static const NoiseEngine* find(const char* name);
+
+	static const NoiseEngine& active();
+	static void setActive(const NoiseEngine& engine);
+
+protected:
+	// the noise of the engine as an FbmNoise basis, false if FbmNoise has no kernels for it
+	virtual bool fbmBasis(FbmNoise::Basis& /*basis*/) const { return false; }
+
+private:
+	static const NoiseEngine* activeEngine;
+};
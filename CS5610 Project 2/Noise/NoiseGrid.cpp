@@ -0,0 +1,35 @@
+/**
+*
+* Grid evaluation of fBm - rows of samples whose columns share the same x in every row, and whose samples
+* in one row share y and z, like the vertex rows of a terrain mesh.
+*
+**/
+
+#include "NoiseGrid.h"
+#include "NoiseEngine.h"
+
+/// <summary>
+/// Copy the columns, the engine has to outlive the sampler
+/// </summary>
+/// <param name="engine">noise of every octave</param>
+/// <param name="x">x coordinate of every column</param>
+/// <param name="columns">samples per row</param>
+/// <param name="y">y coordinate shared by every sample</param>
+/// <param name="params">octave count, persistence and frequency of the first octave</param>
+RowGridSampler::RowGridSampler(const NoiseEngine& engine, const float* x, unsigned int columns, float y, const FbmParams& params)
+    : engine(engine), xs(x, x + columns), ys(columns, y), zs(columns), dy(columns), params(params)
+{
+}
+
+/// <summary>
+/// Sample one row with the fBm kernels of the engine
+/// </summary>
+/// <param name="z">z coordinate shared by the row</param>
+/// <param name="out">receives the normalized (0 - 1) sum of every column</param>
+/// <param name="dx">receives d(out)/dx of every column</param>
+/// <param name="dz">receives d(out)/dz of every column</param>
+void RowGridSampler::sampleRow(float z, float* out, float* dx, float* dz)
+{
+    for (float& value : zs) { value = z; }
+    engine.fbmBatchGradient(&xs[0], &ys[0], &zs[0], out, dx, &dy[0], dz, xs.size(), params);
+}
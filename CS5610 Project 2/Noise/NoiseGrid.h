@@ -0,0 +1,41 @@
+/**
+*
+* Grid evaluation of fBm - rows of samples whose columns share the same x in every row, and whose samples
+* in one row share y and z, like the vertex rows of a terrain mesh.
+* A sampler keeps what one row can hand to the next, see NoiseEngine::gridSampler().
+*
+**/
+
+#pragma once
+
+#include <stddef.h>
+#include <vector>
+#include "FbmNoise.h"
+
+class NoiseEngine;
+
+class NoiseGridSampler
+{
+public:
+	virtual ~NoiseGridSampler() = default;
+
+	// fBm of every column at the z of the row, with its derivatives along x and z
+	virtual void sampleRow(float z, float* out, float* dx, float* dz) = 0;
+};
+
+// Samples every row on its own with NoiseEngine::fbmBatchGradient(), for engines without a grid sampler of their own
+class RowGridSampler : public NoiseGridSampler
+{
+public:
+	RowGridSampler(const NoiseEngine& engine, const float* x, unsigned int columns, float y, const FbmParams& params);
+
+	void sampleRow(float z, float* out, float* dx, float* dz) override;
+
+private:
+	const NoiseEngine& engine;
+	std::vector<float> xs;
+	std::vector<float> ys;
+	std::vector<float> zs;
+	std::vector<float> dy;
+	FbmParams params;
+};
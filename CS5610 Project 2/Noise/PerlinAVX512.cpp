@@ -0,0 +1,60 @@
+/**
+*
+* AVX-512 lanes for the Perlin kernel - 16 points per call.
+* Compiled for AVX-512F only inside the target region below, the dispatcher in PerlinNoise.cpp
+* makes sure it only runs on CPUs that support it.
+*
+**/
+
+#include "PerlinNoise.h"
+#include "PerlinGrid.h"
+
+#include <immintrin.h>
+
+#if defined(__clang__)
+#pragma clang attribute push (__attribute__((target("avx512f"))), apply_to = function)
+#elif defined(__GNUC__)
+#pragma GCC push_options
+#pragma GCC target("avx512f")
+#pragma GCC optimize("fp-contract=off")
+#endif
+
+// included inside the target region so the lanes and the kernel templates are compiled for this instruction set
+#include "AVX512Lanes.h"
+#include "PerlinKernel.h"
+#include "PerlinGridKernel.h"
+
+void perlinBatchAVX512(const int* p, const float* x, const float* y, const float* z, float* out, size_t count)
+{
+    size_t done = perlin_kernel::batch<AVX512Lanes>(perlin_kernel::TableHash{ p }, x, y, z, out, count);
+    perlinBatchScalar(p, x + done, y + done, z + done, out + done, count - done);
+}
+
+void perlinBatchGradientAVX512(const int* p, const float* x, const float* y, const float* z, float* out, float* dx, float* dy, float* dz, size_t count)
+{
+    size_t done = perlin_kernel::batchGradient<AVX512Lanes>(perlin_kernel::TableHash{ p }, x, y, z, out, dx, dy, dz, count);
+    perlinBatchGradientScalar(p, x + done, y + done, z + done, out + done, dx + done, dy + done, dz + done, count - done);
+}
+
+void perlinHashBatchAVX512(const float* x, const float* y, const float* z, float* out, size_t count)
+{
+    size_t done = perlin_kernel::batch<AVX512Lanes>(perlin_kernel::IntegerHash(), x, y, z, out, count);
+    perlinHashBatchScalar(x + done, y + done, z + done, out + done, count - done);
+}
+
+void perlinHashBatchGradientAVX512(const float* x, const float* y, const float* z, float* out, float* dx, float* dy, float* dz, size_t count)
+{
+    size_t done = perlin_kernel::batchGradient<AVX512Lanes>(perlin_kernel::IntegerHash(), x, y, z, out, dx, dy, dz, count);
+    perlinHashBatchGradientScalar(x + done, y + done, z + done, out + done, dx + done, dy + done, dz + done, count - done);
+}
+
+void perlinGridWalkAVX512(const PerlinGridCell* cells, size_t cellCount, const float* xf, const float* u, const float* duf, float* out, float* dx, float* dz)
+{
+    perlin_grid_kernel::walk<AVX512Lanes>(cells, cellCount, xf, u, duf, out, dx, dz);
+}
+
+#if defined(__clang__)
+#pragma clang attribute pop
+#elif defined(__GNUC__)
+#pragma GCC pop_options
+#endif
@@ -0,0 +1,292 @@
+/**
+*
+* Grid sampler of Perlin fBm. Along a row y and z are fixed, so inside one lattice cell every octave is
+* the lerp of two faces that are linear in x. Per octave and row, every lattice point is hashed once
+* (and not at all if the row before was in the same or the previous lattice row), every cell collapses
+* its 8 corners into a few coefficients, and the samples of the cell only evaluate those, see PerlinGridKernel.h.
+* Columns that span more lattice points than there are columns, and coordinates outside the int range of the
+* lattice, are left to the fBm kernels of the engine (RowGridSampler).
+*
+**/
+
+#include "PerlinGrid.h"
+
+// no FMA contraction in the kernels, see PerlinKernel.h
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC optimize("fp-contract=off")
+#endif
+
+#include "ScalarLanes.h"
+#include "PerlinGridKernel.h"
+
+#include <math.h>
+
+void perlinGridWalkScalar(const PerlinGridCell* cells, size_t cellCount, const float* xf, const float* u, const float* duf, float* out, float* dx, float* dz)
+{
+    perlin_grid_kernel::walk<ScalarLanes>(cells, cellCount, xf, u, duf, out, dx, dz);
+}
+
+// lattice coordinates stay well inside the int range, so the corner at + 1 does not overflow either
+static const float latticeLimit = 1073741824.0f;
+
+/// <summary>
+/// Work out everything that is the same in every row: the lattice cell, position and fade of every
+/// column per octave, and which columns share a cell
+/// </summary>
+/// <param name="engine">noise engine of the rows that cannot be walked on the lattice, has to outlive the sampler</param>
+/// <param name="hashing">where the corner gradients come from, fixed for the life of the sampler</param>
+/// <param name="x">x coordinate of every column</param>
+/// <param name="columns">samples per row</param>
+/// <param name="y">y coordinate shared by every sample</param>
+/// <param name="params">octave count, persistence and frequency of the first octave</param>
+PerlinGridSampler::PerlinGridSampler(const NoiseEngine& engine, PerlinNoise::Hashing hashing, const float* x, unsigned int columns,
+    float y, const FbmParams& params)
+    : hashing(hashing), columns(columns), octaves(params.octaves > 0 ? params.octaves : 0),
+    rows(engine, x, columns, y, params), gridded(params.octaves > 0)
+{
+    // same weights as the RuntimeSchedule of FbmKernel.h
+    float amplitude = 1;
+    float sum = 0;
+    for (Octave& octave : octaves)
+    {
+        octave.weight = amplitude;
+        sum += amplitude;
+        amplitude *= params.persistence;
+    }
+
+    float frequency = params.frequency;
+    for (Octave& octave : octaves)
+    {
+        octave.weight /= sum;
+        octave.frequency = frequency;
+        frequency *= 2;
+        if (!buildOctave(octave, x, y))
+        {
+            gridded = false;
+            octaves.clear();
+            return;
+        }
+    }
+}
+
+/// <summary>
+/// Whether floorf() of the coordinate can be taken as a lattice index, false for NaN too
+/// </summary>
+bool PerlinGridSampler::onLattice(float coordinate)
+{
+    return fabsf(coordinate) < latticeLimit;
+}
+
+/// <summary>
+/// Lattice cells and per column values of one octave. Lattice x is worked out relative to the first column,
+/// so only the span of the columns has to fit, and it must not have more lattice points than the row has columns.
+/// </summary>
+/// <returns>false if the octave cannot be walked on the lattice</returns>
+bool PerlinGridSampler::buildOctave(Octave& octave, const float* x, float y)
+{
+    if (columns == 0) { return false; }
+    if (!onLattice(y * octave.frequency)) { return false; }
+    float fy = floorf(y * octave.frequency);
+    octave.latticeY = (int)fy;
+    octave.yf = y * octave.frequency - fy;
+    octave.v = perlin_kernel::fade<ScalarLanes>(octave.yf);
+
+    octave.xf.resize(columns);
+    octave.u.resize(columns);
+    octave.duf.resize(columns);
+    std::vector<int> offsets(columns);
+    int firstX = 0;
+    int minOffset = 0;
+    int maxOffset = 0;
+    for (unsigned int i = 0; i < columns; i++)
+    {
+        if (!onLattice(x[i] * octave.frequency)) { return false; }
+        float fx = floorf(x[i] * octave.frequency);
+        int latticeX = (int)fx;
+        if (i == 0) { firstX = latticeX; }
+        // both are below latticeLimit in size, so the difference fits
+        offsets[i] = latticeX - firstX;
+        if (offsets[i] < minOffset) { minOffset = offsets[i]; }
+        if (offsets[i] > maxOffset) { maxOffset = offsets[i]; }
+        // the right face of the last cell is one lattice point past it
+        if ((unsigned int)(maxOffset - minOffset) + 2 > columns + 1) { return false; }
+
+        octave.xf[i] = x[i] * octave.frequency - fx;
+        octave.u[i] = perlin_kernel::fade<ScalarLanes>(octave.xf[i]);
+        octave.duf[i] = perlin_kernel::fadeDerivative<ScalarLanes>(octave.xf[i]) * octave.frequency;
+    }
+
+    for (unsigned int i = 0; i < columns; i++)
+    {
+        unsigned int point = (unsigned int)(offsets[i] - minOffset);
+        if (i == 0 || point != octave.cellPoint.back())
+        {
+            octave.cells.push_back(PerlinGridCell{ 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, i, i });
+            octave.cellPoint.push_back(point);
+        }
+        octave.cells.back().end = i + 1;
+    }
+
+    // cells shorter than the lanes of an instruction set only run its scalar tail
+    size_t cellLength = columns / octave.cells.size();
+    octave.widest = cellLength >= 16 ? PerlinNoise::SimdLevel::AVX512
+        : cellLength >= 8 ? PerlinNoise::SimdLevel::AVX2
+        : cellLength >= 4 ? PerlinNoise::SimdLevel::SSE41 : PerlinNoise::SimdLevel::Scalar;
+
+    octave.firstX = firstX + minOffset;
+    octave.gradients.resize((size_t)(maxOffset - minOffset + 2) * 12);
+    octave.latticeZ = 0;
+    octave.cached = false;
+    return true;
+}
+
+/// <summary>
+/// Hash of one lattice point with the hashing of the sampler
+/// </summary>
+int PerlinGridSampler::cornerHash(int x, int y, int z) const
+{
+    if (hashing == PerlinNoise::Hashing::Integer)
+    {
+        return perlin_kernel::pointHash<ScalarLanes>(perlin_kernel::IntegerHash(), x, y, z);
+    }
+    return perlin_kernel::pointHash<ScalarLanes>(perlin_kernel::TableHash{ PerlinNoise::permutationTable() }, x, y, z);
+}
+
+/// <summary>
+/// Bring the corner gradients of the octave to the lattice row latticeZ. The corners of the same lattice
+/// row are kept as they are, and one row further on only the new z + 1 corners are hashed.
+/// </summary>
+void PerlinGridSampler::hashLattice(Octave& octave, int latticeZ)
+{
+    if (octave.cached && octave.latticeZ == latticeZ) { return; }
+
+    bool step = octave.cached && octave.latticeZ + 1 == latticeZ;
+    size_t points = octave.gradients.size() / 12;
+    for (size_t p = 0; p < points; p++)
+    {
+        float* g = &octave.gradients[p * 12];
+        int latticeX = octave.firstX + (int)p;
+        for (int j = 0; j < 2; j++)
+        {
+            float* k0 = g + j * 6;
+            float* k1 = k0 + 3;
+            if (step)
+            {
+                k0[0] = k1[0];
+                k0[1] = k1[1];
+                k0[2] = k1[2];
+            }
+            else
+            {
+                perlin_kernel::gradVector<ScalarLanes>(cornerHash(latticeX, octave.latticeY + j, latticeZ), k0[0], k0[1], k0[2]);
+            }
+            perlin_kernel::gradVector<ScalarLanes>(cornerHash(latticeX, octave.latticeY + j, latticeZ + 1), k1[0], k1[1], k1[2]);
+        }
+    }
+    octave.latticeZ = latticeZ;
+    octave.cached = true;
+}
+
+/// <summary>
+/// Sample one row. Matches NoiseEngine::fbmBatchGradient() of the Perlin engine up to float rounding,
+/// the octaves are summed in a different order of operations.
+/// </summary>
+/// <param name="z">z coordinate shared by the row</param>
+/// <param name="out">receives the normalized (0 - 1) sum of every column</param>
+/// <param name="dx">receives d(out)/dx of every column</param>
+/// <param name="dz">receives d(out)/dz of every column</param>
+void PerlinGridSampler::sampleRow(float z, float* out, float* dx, float* dz)
+{
+    // the highest octave has the largest lattice coordinates
+    if (!gridded || !onLattice(z * octaves.back().frequency))
+    {
+        rows.sampleRow(z, out, dx, dz);
+        return;
+    }
+
+    // every octave maps its noise from [-1, 1] to [0, 1] and the weights sum up to 1
+    for (unsigned int i = 0; i < columns; i++)
+    {
+        out[i] = 0.5f;
+        dx[i] = 0.0f;
+        dz[i] = 0.0f;
+    }
+
+    for (Octave& octave : octaves)
+    {
+        float fz = floorf(z * octave.frequency);
+        float zf = z * octave.frequency - fz;
+        hashLattice(octave, (int)fz);
+
+        float w = perlin_kernel::fade<ScalarLanes>(zf);
+        float dw = perlin_kernel::fadeDerivative<ScalarLanes>(zf);
+        float wy[2] = { 1 - octave.v, octave.v };
+        float wz[2] = { 1 - w, w };
+        float dwz[2] = { -dw, dw };
+        float scale = octave.weight * 0.5f;
+        float slopeScale = scale * octave.frequency;
+
+        // per lattice point, the faces x = const of the cells it borders: value A + B xf and z slope C + D xf,
+        // with xf measured from that lattice point
+        size_t points = octave.gradients.size() / 12;
+        faces.resize(points * 4);
+        for (size_t p = 0; p < points; p++)
+        {
+            const float* g = &octave.gradients[p * 12];
+            float a = 0, b = 0, c = 0, d = 0;
+            for (int j = 0; j < 2; j++)
+            {
+                for (int k = 0; k < 2; k++)
+                {
+                    const float* corner = g + j * 6 + k * 3;
+                    float offset = corner[1] * (octave.yf - j) + corner[2] * (zf - k);
+                    a += wy[j] * wz[k] * offset;
+                    b += wy[j] * wz[k] * corner[0];
+                    c += wy[j] * (dwz[k] * offset + wz[k] * corner[2]);
+                    d += wy[j] * dwz[k] * corner[0];
+                }
+            }
+            faces[p * 4 + 0] = a * scale;
+            faces[p * 4 + 1] = b * scale;
+            faces[p * 4 + 2] = c * slopeScale;
+            faces[p * 4 + 3] = d * slopeScale;
+        }
+
+        for (size_t c = 0; c < octave.cells.size(); c++)
+        {
+            const float* left = &faces[(size_t)octave.cellPoint[c] * 4];
+            const float* right = left + 4;
+            PerlinGridCell& cell = octave.cells[c];
+            // the right face is measured from the lattice point at xf = 1
+            cell.a0 = left[0];
+            cell.b0 = left[1];
+            cell.a1 = right[0] - right[1];
+            cell.b1 = right[1];
+            cell.e0 = cell.b0 * octave.frequency;
+            cell.de = (cell.b1 - cell.b0) * octave.frequency;
+            cell.c0 = left[2];
+            cell.d0 = left[3];
+            cell.c1 = right[2] - right[3];
+            cell.d1 = right[3];
+        }
+
+        walk(octave, out, dx, dz);
+    }
+}
+
+/// <summary>
+/// Add the cells of the octave to the row, with the instruction set PerlinNoise::simdLevel() picks unless
+/// the cells are too short for its lanes. Every walk gives bit-identical rows.
+/// </summary>
+void PerlinGridSampler::walk(const Octave& octave, float* out, float* dx, float* dz) const
+{
+    PerlinNoise::SimdLevel level = PerlinNoise::simdLevel() < octave.widest ? PerlinNoise::simdLevel() : octave.widest;
+    const PerlinGridCell* cells = &octave.cells[0];
+    switch (level)
+    {
+    case PerlinNoise::SimdLevel::AVX512: perlinGridWalkAVX512(cells, octave.cells.size(), &octave.xf[0], &octave.u[0], &octave.duf[0], out, dx, dz); break;
+    case PerlinNoise::SimdLevel::AVX2:   perlinGridWalkAVX2(cells, octave.cells.size(), &octave.xf[0], &octave.u[0], &octave.duf[0], out, dx, dz); break;
+    case PerlinNoise::SimdLevel::SSE41:  perlinGridWalkSSE41(cells, octave.cells.size(), &octave.xf[0], &octave.u[0], &octave.duf[0], out, dx, dz); break;
+    default:                             perlinGridWalkScalar(cells, octave.cells.size(), &octave.xf[0], &octave.u[0], &octave.duf[0], out, dx, dz); break;
+    }
+}
@@ -0,0 +1,79 @@
+/**
+*
+* Grid sampler of Perlin fBm. Along a row y and z are fixed, so inside one lattice cell every octave is
+* the lerp of two faces that are linear in x. Per octave and row, every lattice point is hashed once
+* (and not at all if the row before was in the same or the previous lattice row), every cell collapses
+* its 8 corners into a few coefficients, and the samples of the cell only evaluate those, see PerlinGridKernel.h.
+* Columns that span more lattice points than there are columns, and coordinates outside the int range of the
+* lattice, are left to the fBm kernels of the engine (RowGridSampler).
+*
+**/
+
+#pragma once
+
+#include <stddef.h>
+#include <vector>
+#include "NoiseGrid.h"
+#include "PerlinNoise.h"
+
+// One lattice cell of one octave in one row. With xf the position of a sample in the cell, u its fade and
+// duf the fade derivative times the octave frequency, the cell adds to the samples begin - end:
+//   out += f0 + u (f1 - f0)               f0 = a0 + b0 xf, f1 = a1 + b1 xf
+//   dx  += e0 + u de + duf (f1 - f0)
+//   dz  += g0 + u (g1 - g0)               g0 = c0 + d0 xf, g1 = c1 + d1 xf
+// The octave weight, the 0 - 1 mapping and the frequency of the derivatives are folded into the coefficients.
+struct PerlinGridCell
+{
+	float a0, b0, a1, b1;
+	float e0, de;
+	float c0, d0, c1, d1;
+	unsigned int begin, end;
+};
+
+class PerlinGridSampler : public NoiseGridSampler
+{
+public:
+	PerlinGridSampler(const NoiseEngine& engine, PerlinNoise::Hashing hashing, const float* x, unsigned int columns, float y, const FbmParams& params);
+
+	void sampleRow(float z, float* out, float* dx, float* dz) override;
+
+private:
+	// What every row of one octave shares, and the corner gradients of the last row
+	struct Octave
+	{
+		float frequency;
+		float weight;						// amplitude divided by the sum of all amplitudes
+		int latticeY;
+		float yf;
+		float v;							// fade of yf
+		std::vector<float> xf;				// per column: position in its lattice cell, its fade,
+		std::vector<float> u;				// and the fade derivative times the frequency
+		std::vector<float> duf;
+		std::vector<PerlinGridCell> cells;	// runs of columns in the same lattice cell
+		std::vector<unsigned int> cellPoint;	// entry of gradients at the left face of every cell
+		PerlinNoise::SimdLevel widest;		// widest walk the cells are long enough for, see walk()
+		int firstX;							// lattice x of the first entry of gradients
+		int latticeZ;						// lattice z the gradients belong to
+		bool cached;
+		std::vector<float> gradients;		// per lattice x: the 4 corners (y, z), (y, z + 1), (y + 1, z), (y + 1, z + 1)
+	};
+
+	static bool onLattice(float coordinate);
+	bool buildOctave(Octave& octave, const float* x, float y);
+	int cornerHash(int x, int y, int z) const;
+	void hashLattice(Octave& octave, int latticeZ);
+	void walk(const Octave& octave, float* out, float* dx, float* dz) const;
+
+	PerlinNoise::Hashing hashing;
+	unsigned int columns;
+	std::vector<Octave> octaves;
+	RowGridSampler rows;					// samples the rows the lattice walk cannot
+	bool gridded;							// false if every row goes through rows
+	std::vector<float> faces;				// per lattice x of the current octave: value and z derivative coefficients
+};
+
+// per instruction set kernels that walk the samples of a row's cells, each lives in its Perlin translation unit
+void perlinGridWalkScalar(const PerlinGridCell* cells, size_t cellCount, const float* xf, const float* u, const float* duf, float* out, float* dx, float* dz);
+void perlinGridWalkSSE41(const PerlinGridCell* cells, size_t cellCount, const float* xf, const float* u, const float* duf, float* out, float* dx, float* dz);
+void perlinGridWalkAVX2(const PerlinGridCell* cells, size_t cellCount, const float* xf, const float* u, const float* duf, float* out, float* dx, float* dz);
+void perlinGridWalkAVX512(const PerlinGridCell* cells, size_t cellCount, const float* xf, const float* u, const float* duf, float* out, float* dx, float* dz);
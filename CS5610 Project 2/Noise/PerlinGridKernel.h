@@ -0,0 +1,68 @@
+/**
+*
+* Instruction set independent walk over the samples of the lattice cells of a row, see PerlinGrid.h.
+* Written against the lanes interface of PerlinKernel.h. The columns of a cell that do not fill a whole
+* V::width group go through ScalarLanes, which runs the same float operations, so all instruction sets
+* produce bit-identical rows.
+*
+**/
+
+#pragma once
+
+#include "PerlinKernel.h"
+#include "PerlinGrid.h"
+#include "ScalarLanes.h"
+
+namespace perlin_grid_kernel {
+
+// Add the cell to the columns begin - end as long as whole V::width groups fit, returns the first column left
+template <class V>
+inline size_t walkColumns(const PerlinGridCell& cell, size_t begin, size_t end,
+	const float* xf, const float* u, const float* duf, float* out, float* dx, float* dz)
+{
+	typedef typename V::F F;
+
+	F a0 = V::set1(cell.a0);
+	F b0 = V::set1(cell.b0);
+	F a1 = V::set1(cell.a1);
+	F b1 = V::set1(cell.b1);
+	F e0 = V::set1(cell.e0);
+	F de = V::set1(cell.de);
+	F c0 = V::set1(cell.c0);
+	F d0 = V::set1(cell.d0);
+	F c1 = V::set1(cell.c1);
+	F d1 = V::set1(cell.d1);
+
+	size_t i = begin;
+	for (; i + V::width <= end; i += V::width)
+	{
+		F x = V::load(xf + i);
+		F fade = V::load(u + i);
+		F f0 = V::add(a0, V::mul(b0, x));
+		F f1 = V::add(a1, V::mul(b1, x));
+		F diff = V::sub(f1, f0);
+		V::store(out + i, V::add(V::load(out + i), V::add(f0, V::mul(fade, diff))));
+
+		F slopeX = V::add(V::add(e0, V::mul(fade, de)), V::mul(V::load(duf + i), diff));
+		V::store(dx + i, V::add(V::load(dx + i), slopeX));
+
+		F g0 = V::add(c0, V::mul(d0, x));
+		F g1 = V::add(c1, V::mul(d1, x));
+		V::store(dz + i, V::add(V::load(dz + i), V::add(g0, V::mul(fade, V::sub(g1, g0)))));
+	}
+	return i;
+}
+
+// Every cell of one octave of a row
+template <class V>
+inline void walk(const PerlinGridCell* cells, size_t cellCount,
+	const float* xf, const float* u, const float* duf, float* out, float* dx, float* dz)
+{
+	for (size_t c = 0; c < cellCount; c++)
+	{
+		size_t rest = walkColumns<V>(cells[c], cells[c].begin, cells[c].end, xf, u, duf, out, dx, dz);
+		walkColumns<ScalarLanes>(cells[c], rest, cells[c].end, xf, u, duf, out, dx, dz);
+	}
+}
+
+}
@@ -0,0 +1,355 @@
+/**
+*
+* Instruction set independent Perlin noise kernel.
+*
+* The kernel is written once against a small "lanes" interface and each instruction set
+* provides its own lanes type (ScalarLanes.h, SSE41Lanes.h, ...), compiled in its own translation unit
+* (PerlinSSE41.cpp, PerlinAVX2.cpp, ...). SimplexKernel.h uses the same lanes.
+* Every lane runs exactly the same sequence of float operations as the scalar lanes, so all
+* instruction sets produce bit-identical results.
+*
+* A lanes type V provides:
+*   V::width                                  number of points per call
+*   V::F, V::I, V::M                          float vector, int vector and lane mask types
+*   load, store, set1, add, sub, mul, floor   float operations
+*   toInt, set1i, addi, andi, shl<N>          int operations
+*   muli, xori, shr<N>                        low 32 bits of the product, xor, logical right shift
+*   gather(table, I)                          table lookup per lane
+*   less(I, I), equal(I, I), either(M, M)     lane masks
+*   lessf(F, F), max(F, F)                    float compare and maximum
+*   select(M, a, b)                           a where the mask is set, b elsewhere
+*   flipSign(F, I)                            flip the sign of lanes whose int has the sign bit set
+*
+* The corner hashes come from a hashing policy: TableHash does Ken Perlin's three dependent lookups
+* into the permutation table per corner, IntegerHash computes them with integer arithmetic and no lookups.
+*
+**/
+
+#pragma once
+
+#include <stddef.h>
+
+// Contracting mul + add into FMA would round differently per instruction set. GCC contracts by default (into FMA for
+// AVX-512 targets), so every translation unit that instantiates the kernels sets #pragma GCC optimize("fp-contract=off")
+// for itself, the instruction set units inside their target region. The Visual Studio projects build with /fp:precise,
+// and Clang only contracts within one expression, which the lanes never form.
+
+namespace perlin_kernel {
+
+// Fade function as defined by Ken Perlin: 6t^5 - 15t^4 + 10t^3
+template <class V>
+inline typename V::F fade(typename V::F t)
+{
+	typename V::F inner = V::add(V::mul(t, V::sub(V::mul(t, V::set1(6.0f)), V::set1(15.0f))), V::set1(10.0f));
+	return V::mul(V::mul(V::mul(t, t), t), inner);
+}
+
+template <class V>
+inline typename V::F lerp(typename V::F a, typename V::F b, typename V::F x)
+{
+	return V::add(a, V::mul(x, V::sub(b, a)));
+}
+
+// Branch free form of Mesh::grad() - picks one of the 12 gradient directions from the low 4 bits of the hash
+template <class V>
+inline typename V::F grad(typename V::I hash, typename V::F x, typename V::F y, typename V::F z)
+{
+	typename V::I h = V::andi(hash, V::set1i(15));
+	typename V::F u = V::select(V::less(h, V::set1i(8)), x, y);
+	typename V::M useX = V::either(V::equal(h, V::set1i(12)), V::equal(h, V::set1i(14)));
+	typename V::F v = V::select(V::less(h, V::set1i(4)), y, V::select(useX, x, z));
+	typename V::F signedU = V::flipSign(u, V::template shl<31>(V::andi(h, V::set1i(1))));
+	typename V::F signedV = V::flipSign(v, V::template shl<30>(V::andi(h, V::set1i(2))));
+	return V::add(signedU, signedV);
+}
+
+// Derivative of fade(): 30t^4 - 60t^3 + 30t^2 = 30t^2(t - 1)^2
+template <class V>
+inline typename V::F fadeDerivative(typename V::F t)
+{
+	typename V::F t1 = V::sub(t, V::set1(1.0f));
+	return V::mul(V::mul(V::set1(30.0f), V::mul(t, t)), V::mul(t1, t1));
+}
+
+// The gradient direction grad() takes the dot product with, each component is -1, 0 or 1
+template <class V>
+inline void gradVector(typename V::I hash, typename V::F& gx, typename V::F& gy, typename V::F& gz)
+{
+	typename V::I h = V::andi(hash, V::set1i(15));
+	typename V::F zero = V::set1(0.0f);
+	typename V::F su = V::flipSign(V::set1(1.0f), V::template shl<31>(V::andi(h, V::set1i(1))));
+	typename V::F sv = V::flipSign(V::set1(1.0f), V::template shl<30>(V::andi(h, V::set1i(2))));
+	typename V::M uIsX = V::less(h, V::set1i(8));
+	typename V::M vIsY = V::less(h, V::set1i(4));
+	typename V::M vIsX = V::either(V::equal(h, V::set1i(12)), V::equal(h, V::set1i(14)));
+	gx = V::add(V::select(uIsX, su, zero), V::select(vIsX, sv, zero));
+	gy = V::add(V::select(uIsX, zero, su), V::select(vIsY, sv, zero));
+	gz = V::select(vIsY, zero, V::select(vIsX, zero, sv));
+}
+
+template <class V>
+struct Gradient
+{
+	typename V::F x, y, z;
+};
+
+// Gradient of lerp(a, b, t) where a and b have gradients ga and gb, and t only depends on the Axis coordinate
+template <class V, int Axis>
+inline Gradient<V> lerpGradient(typename V::F a, const Gradient<V>& ga, typename V::F b, const Gradient<V>& gb,
+	typename V::F t, typename V::F dt)
+{
+	Gradient<V> r;
+	r.x = lerp<V>(ga.x, gb.x, t);
+	r.y = lerp<V>(ga.y, gb.y, t);
+	r.z = lerp<V>(ga.z, gb.z, t);
+	typename V::F slope = V::mul(dt, V::sub(b, a));
+	if (Axis == 0) { r.x = V::add(r.x, slope); }
+	if (Axis == 1) { r.y = V::add(r.y, slope); }
+	if (Axis == 2) { r.z = V::add(r.z, slope); }
+	return r;
+}
+
+// The unit cube a point falls in: corner hashes, position inside the cube and fade weights
+template <class V>
+struct Cell
+{
+	typename V::I aaa, aab, aba, abb, baa, bab, bba, bbb;
+	typename V::F xf, yf, zf, xf1, yf1, zf1;
+	typename V::F u, v, w;
+};
+
+// Corner hashes from the doubled permutation table, the lattice repeats every 256 cells
+struct TableHash
+{
+	const int* p;
+};
+
+// Corner hashes from integer arithmetic, gather free and without a period within the int range
+struct IntegerHash
+{
+};
+
+template <class V>
+inline void hashCorners(const TableHash& hash, typename V::F fx, typename V::F fy, typename V::F fz, Cell<V>& cell)
+{
+	typedef typename V::I I;
+	const int* p = hash.p;
+
+	I mask = V::set1i(255);
+	I xi = V::andi(V::toInt(fx), mask);
+	I yi = V::andi(V::toInt(fy), mask);
+	I zi = V::andi(V::toInt(fz), mask);
+
+	// hash the 8 cube corners, sharing the partial lookups between corners
+	I one = V::set1i(1);
+	I pA = V::gather(p, xi);
+	I pB = V::gather(p, V::addi(xi, one));
+	I AA = V::gather(p, V::addi(pA, yi));
+	I AB = V::gather(p, V::addi(V::addi(pA, yi), one));
+	I BA = V::gather(p, V::addi(pB, yi));
+	I BB = V::gather(p, V::addi(V::addi(pB, yi), one));
+	I zi1 = V::addi(zi, one);
+	cell.aaa = V::gather(p, V::addi(AA, zi));
+	cell.aab = V::gather(p, V::addi(AA, zi1));
+	cell.aba = V::gather(p, V::addi(AB, zi));
+	cell.abb = V::gather(p, V::addi(AB, zi1));
+	cell.baa = V::gather(p, V::addi(BA, zi));
+	cell.bab = V::gather(p, V::addi(BA, zi1));
+	cell.bba = V::gather(p, V::addi(BB, zi));
+	cell.bbb = V::gather(p, V::addi(BB, zi1));
+}
+
+// Final mix of IntegerHash, C. Wellons' "lowbias32", so every bit of the corner depends on every input bit
+// (grad() only reads the low 4, which a plain multiply would leave depending on the low bits of x, y and z alone)
+template <class V>
+inline typename V::I mixHash(typename V::I h)
+{
+	h = V::xori(h, V::template shr<16>(h));
+	h = V::muli(h, V::set1i(0x7feb352d));
+	h = V::xori(h, V::template shr<15>(h));
+	h = V::muli(h, V::set1i((int)0x846ca68bu));
+	return V::xori(h, V::template shr<16>(h));
+}
+
+template <class V>
+inline void hashCorners(const IntegerHash&, typename V::F fx, typename V::F fy, typename V::F fz, Cell<V>& cell)
+{
+	typedef typename V::I I;
+
+	// each axis is scaled by its own odd constant, a step along an axis adds the constant instead of multiplying again
+	I kx = V::set1i((int)0x8da6b343u);
+	I ky = V::set1i((int)0xd8163841u);
+	I kz = V::set1i((int)0xcb1ab31fu);
+	I x0 = V::muli(V::toInt(fx), kx);
+	I y0 = V::muli(V::toInt(fy), ky);
+	I z0 = V::muli(V::toInt(fz), kz);
+	I x1 = V::addi(x0, kx);
+	I y1 = V::addi(y0, ky);
+	I z1 = V::addi(z0, kz);
+
+	I AA = V::addi(x0, y0);
+	I AB = V::addi(x0, y1);
+	I BA = V::addi(x1, y0);
+	I BB = V::addi(x1, y1);
+	cell.aaa = mixHash<V>(V::addi(AA, z0));
+	cell.aab = mixHash<V>(V::addi(AA, z1));
+	cell.aba = mixHash<V>(V::addi(AB, z0));
+	cell.abb = mixHash<V>(V::addi(AB, z1));
+	cell.baa = mixHash<V>(V::addi(BA, z0));
+	cell.bab = mixHash<V>(V::addi(BA, z1));
+	cell.bba = mixHash<V>(V::addi(BB, z0));
+	cell.bbb = mixHash<V>(V::addi(BB, z1));
+}
+
+// Hash of a single lattice point, the same hash hashCorners() gives the cube corner at that point.
+// Used by the grid sampler of PerlinGrid.cpp, which hashes every lattice point once instead of once per cube.
+template <class V>
+inline typename V::I pointHash(const TableHash& hash, typename V::I x, typename V::I y, typename V::I z)
+{
+	typename V::I mask = V::set1i(255);
+	typename V::I h = V::gather(hash.p, V::andi(x, mask));
+	h = V::gather(hash.p, V::addi(h, V::andi(y, mask)));
+	return V::gather(hash.p, V::addi(h, V::andi(z, mask)));
+}
+
+template <class V>
+inline typename V::I pointHash(const IntegerHash&, typename V::I x, typename V::I y, typename V::I z)
+{
+	typename V::I h = V::addi(V::muli(x, V::set1i((int)0x8da6b343u)), V::muli(y, V::set1i((int)0xd8163841u)));
+	return mixHash<V>(V::addi(h, V::muli(z, V::set1i((int)0xcb1ab31fu))));
+}
+
+template <class V, class Hash>
+inline void findCell(const Hash& hash, typename V::F x, typename V::F y, typename V::F z, Cell<V>& cell)
+{
+	typedef typename V::F F;
+
+	// unit cube that contains the point, and the location of the point inside that cube
+	F fx = V::floor(x);
+	F fy = V::floor(y);
+	F fz = V::floor(z);
+	cell.xf = V::sub(x, fx);
+	cell.yf = V::sub(y, fy);
+	cell.zf = V::sub(z, fz);
+
+	cell.u = fade<V>(cell.xf);
+	cell.v = fade<V>(cell.yf);
+	cell.w = fade<V>(cell.zf);
+
+	hashCorners<V>(hash, fx, fy, fz, cell);
+
+	F oneF = V::set1(1.0f);
+	cell.xf1 = V::sub(cell.xf, oneF);
+	cell.yf1 = V::sub(cell.yf, oneF);
+	cell.zf1 = V::sub(cell.zf, oneF);
+}
+
+// Perlin noise for V::width points, mapped to 0 - 1
+template <class V, class Hash>
+inline typename V::F noise(const Hash& hash, typename V::F x, typename V::F y, typename V::F z)
+{
+	typedef typename V::F F;
+
+	Cell<V> c;
+	findCell<V>(hash, x, y, z, c);
+
+	F x1 = lerp<V>(grad<V>(c.aaa, c.xf, c.yf, c.zf), grad<V>(c.baa, c.xf1, c.yf, c.zf), c.u);
+	F x2 = lerp<V>(grad<V>(c.aba, c.xf, c.yf1, c.zf), grad<V>(c.bba, c.xf1, c.yf1, c.zf), c.u);
+	F y1 = lerp<V>(x1, x2, c.v);
+
+	x1 = lerp<V>(grad<V>(c.aab, c.xf, c.yf, c.zf1), grad<V>(c.bab, c.xf1, c.yf, c.zf1), c.u);
+	x2 = lerp<V>(grad<V>(c.abb, c.xf, c.yf1, c.zf1), grad<V>(c.bbb, c.xf1, c.yf1, c.zf1), c.u);
+	F y2 = lerp<V>(x1, x2, c.v);
+
+	// bind the result to 0 - 1 (theoretical min/max before is [-1, 1])
+	return V::mul(V::add(lerp<V>(y1, y2, c.w), V::set1(1.0f)), V::set1(0.5f));
+}
+
+// Perlin noise and its analytic gradient for V::width points.
+// The value is computed exactly like noise(), the gradient follows the same lerp chain with the
+// fade derivatives added in (see https://iquilezles.org/articles/gradientnoise/).
+template <class V, class Hash>
+inline typename V::F noiseGradient(const Hash& hash, typename V::F x, typename V::F y, typename V::F z, Gradient<V>& gradient)
+{
+	typedef typename V::F F;
+
+	Cell<V> c;
+	findCell<V>(hash, x, y, z, c);
+
+	// corner values and the gradient directions they were made from
+	F n000 = grad<V>(c.aaa, c.xf, c.yf, c.zf);
+	F n100 = grad<V>(c.baa, c.xf1, c.yf, c.zf);
+	F n010 = grad<V>(c.aba, c.xf, c.yf1, c.zf);
+	F n110 = grad<V>(c.bba, c.xf1, c.yf1, c.zf);
+	F n001 = grad<V>(c.aab, c.xf, c.yf, c.zf1);
+	F n101 = grad<V>(c.bab, c.xf1, c.yf, c.zf1);
+	F n011 = grad<V>(c.abb, c.xf, c.yf1, c.zf1);
+	F n111 = grad<V>(c.bbb, c.xf1, c.yf1, c.zf1);
+	Gradient<V> g000, g100, g010, g110, g001, g101, g011, g111;
+	gradVector<V>(c.aaa, g000.x, g000.y, g000.z);
+	gradVector<V>(c.baa, g100.x, g100.y, g100.z);
+	gradVector<V>(c.aba, g010.x, g010.y, g010.z);
+	gradVector<V>(c.bba, g110.x, g110.y, g110.z);
+	gradVector<V>(c.aab, g001.x, g001.y, g001.z);
+	gradVector<V>(c.bab, g101.x, g101.y, g101.z);
+	gradVector<V>(c.abb, g011.x, g011.y, g011.z);
+	gradVector<V>(c.bbb, g111.x, g111.y, g111.z);
+
+	F du = fadeDerivative<V>(c.xf);
+	F dv = fadeDerivative<V>(c.yf);
+	F dw = fadeDerivative<V>(c.zf);
+
+	F x1 = lerp<V>(n000, n100, c.u);
+	F x2 = lerp<V>(n010, n110, c.u);
+	F y1 = lerp<V>(x1, x2, c.v);
+	Gradient<V> gx1 = lerpGradient<V, 0>(n000, g000, n100, g100, c.u, du);
+	Gradient<V> gx2 = lerpGradient<V, 0>(n010, g010, n110, g110, c.u, du);
+	Gradient<V> gy1 = lerpGradient<V, 1>(x1, gx1, x2, gx2, c.v, dv);
+
+	F x3 = lerp<V>(n001, n101, c.u);
+	F x4 = lerp<V>(n011, n111, c.u);
+	F y2 = lerp<V>(x3, x4, c.v);
+	Gradient<V> gx3 = lerpGradient<V, 0>(n001, g001, n101, g101, c.u, du);
+	Gradient<V> gx4 = lerpGradient<V, 0>(n011, g011, n111, g111, c.u, du);
+	Gradient<V> gy2 = lerpGradient<V, 1>(x3, gx3, x4, gx4, c.v, dv);
+
+	Gradient<V> g = lerpGradient<V, 2>(y1, gy1, y2, gy2, c.w, dw);
+
+	// same 0 - 1 mapping as noise(), which halves the gradient
+	F half = V::set1(0.5f);
+	gradient.x = V::mul(g.x, half);
+	gradient.y = V::mul(g.y, half);
+	gradient.z = V::mul(g.z, half);
+	return V::mul(V::add(lerp<V>(y1, y2, c.w), V::set1(1.0f)), half);
+}
+
+// Evaluate as many whole V::width groups as fit in count, returns how many points were written
+template <class V, class Hash>
+inline size_t batch(const Hash& hash, const float* x, const float* y, const float* z, float* out, size_t count)
+{
+	size_t i = 0;
+	for (; i + V::width <= count; i += V::width)
+	{
+		V::store(out + i, noise<V>(hash, V::load(x + i), V::load(y + i), V::load(z + i)));
+	}
+	return i;
+}
+
+// Same as batch() but also writes the gradient of every point
+template <class V, class Hash>
+inline size_t batchGradient(const Hash& hash, const float* x, const float* y, const float* z,
+	float* out, float* dx, float* dy, float* dz, size_t count)
+{
+	size_t i = 0;
+	for (; i + V::width <= count; i += V::width)
+	{
+		Gradient<V> g;
+		V::store(out + i, noiseGradient<V>(hash, V::load(x + i), V::load(y + i), V::load(z + i), g));
+		V::store(dx + i, g.x);
+		V::store(dy + i, g.y);
+		V::store(dz + i, g.z);
+	}
+	return i;
+}
+
+}
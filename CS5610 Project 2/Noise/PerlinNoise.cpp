@@ -0,0 +1,257 @@
+/**
+*
+* Batched Perlin noise - evaluates many points per call with the widest SIMD unit the CPU has.
+* Based on the reference implementation from: https://adrianb.io/2014/08/09/perlinnoise.html
+*
+**/
+
+#include "PerlinNoise.h"
+
+// no FMA contraction in the kernels, see PerlinKernel.h
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC optimize("fp-contract=off")
+#endif
+
+#include "ScalarLanes.h"
+#include "PerlinKernel.h"
+
+#include <math.h>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+void perlinBatchScalar(const int* p, const float* x, const float* y, const float* z, float* out, size_t count)
+{
+    perlin_kernel::batch<ScalarLanes>(perlin_kernel::TableHash{ p }, x, y, z, out, count);
+}
+
+void perlinBatchGradientScalar(const int* p, const float* x, const float* y, const float* z, float* out, float* dx, float* dy, float* dz, size_t count)
+{
+    perlin_kernel::batchGradient<ScalarLanes>(perlin_kernel::TableHash{ p }, x, y, z, out, dx, dy, dz, count);
+}
+
+void perlinHashBatchScalar(const float* x, const float* y, const float* z, float* out, size_t count)
+{
+    perlin_kernel::batch<ScalarLanes>(perlin_kernel::IntegerHash(), x, y, z, out, count);
+}
+
+void perlinHashBatchGradientScalar(const float* x, const float* y, const float* z, float* out, float* dx, float* dy, float* dz, size_t count)
+{
+    perlin_kernel::batchGradient<ScalarLanes>(perlin_kernel::IntegerHash(), x, y, z, out, dx, dy, dz, count);
+}
+
+PerlinNoise::SimdLevel PerlinNoise::activeLevel = PerlinNoise::detectSimdLevel();
+PerlinNoise::Hashing PerlinNoise::activeHashing = PerlinNoise::Hashing::Permutation;
+
+/// <summary>
+/// Evaluate Perlin noise for count points at once, using the active instruction set and hashing.
+/// Output matches sample() bit for bit whatever instruction set is picked.
+/// </summary>
+/// <param name="x">x coordinates of the points</param>
+/// <param name="y">y coordinates of the points</param>
+/// <param name="z">z coordinates of the points</param>
+/// <param name="out">receives the noise value (0 - 1) of every point</param>
+/// <param name="count">number of points</param>
+void PerlinNoise::sampleBatch(const float* x, const float* y, const float* z, float* out, size_t count)
+{
+    if (activeHashing == Hashing::Integer)
+    {
+        switch (activeLevel)
+        {
+        case SimdLevel::AVX512: perlinHashBatchAVX512(x, y, z, out, count); break;
+        case SimdLevel::AVX2:   perlinHashBatchAVX2(x, y, z, out, count); break;
+        case SimdLevel::SSE41:  perlinHashBatchSSE41(x, y, z, out, count); break;
+        default:                perlinHashBatchScalar(x, y, z, out, count); break;
+        }
+        return;
+    }
+    switch (activeLevel)
+    {
+    case SimdLevel::AVX512: perlinBatchAVX512(p, x, y, z, out, count); break;
+    case SimdLevel::AVX2:   perlinBatchAVX2(p, x, y, z, out, count); break;
+    case SimdLevel::SSE41:  perlinBatchSSE41(p, x, y, z, out, count); break;
+    default:                perlinBatchScalar(p, x, y, z, out, count); break;
+    }
+}
+
+/// <summary>
+/// Evaluate Perlin noise and its analytic gradient for count points at once.
+/// out matches sampleBatch() bit for bit, dx/dy/dz are the partial derivatives of out.
+/// </summary>
+/// <param name="x">x coordinates of the points</param>
+/// <param name="y">y coordinates of the points</param>
+/// <param name="z">z coordinates of the points</param>
+/// <param name="out">receives the noise value (0 - 1) of every point</param>
+/// <param name="dx">receives d(out)/dx of every point</param>
+/// <param name="dy">receives d(out)/dy of every point</param>
+/// <param name="dz">receives d(out)/dz of every point</param>
+/// <param name="count">number of points</param>
+void PerlinNoise::sampleBatchGradient(const float* x, const float* y, const float* z,
+    float* out, float* dx, float* dy, float* dz, size_t count)
+{
+    if (activeHashing == Hashing::Integer)
+    {
+        switch (activeLevel)
+        {
+        case SimdLevel::AVX512: perlinHashBatchGradientAVX512(x, y, z, out, dx, dy, dz, count); break;
+        case SimdLevel::AVX2:   perlinHashBatchGradientAVX2(x, y, z, out, dx, dy, dz, count); break;
+        case SimdLevel::SSE41:  perlinHashBatchGradientSSE41(x, y, z, out, dx, dy, dz, count); break;
+        default:                perlinHashBatchGradientScalar(x, y, z, out, dx, dy, dz, count); break;
+        }
+        return;
+    }
+    switch (activeLevel)
+    {
+    case SimdLevel::AVX512: perlinBatchGradientAVX512(p, x, y, z, out, dx, dy, dz, count); break;
+    case SimdLevel::AVX2:   perlinBatchGradientAVX2(p, x, y, z, out, dx, dy, dz, count); break;
+    case SimdLevel::SSE41:  perlinBatchGradientSSE41(p, x, y, z, out, dx, dy, dz, count); break;
+    default:                perlinBatchGradientScalar(p, x, y, z, out, dx, dy, dz, count); break;
+    }
+}
+
+/// <summary>
+/// Evaluate Perlin noise for a single point in float precision
+/// </summary>
+/// <returns>noise value between 0 and 1</returns>
+float PerlinNoise::sample(float x, float y, float z)
+{
+    if (activeHashing == Hashing::Integer) { return perlin_kernel::noise<ScalarLanes>(perlin_kernel::IntegerHash(), x, y, z); }
+    return perlin_kernel::noise<ScalarLanes>(perlin_kernel::TableHash{ p }, x, y, z);
+}
+
+/// <summary>
+/// Instruction set currently used by sampleBatch()
+/// </summary>
+PerlinNoise::SimdLevel PerlinNoise::simdLevel()
+{
+    return activeLevel;
+}
+
+/// <summary>
+/// Force an instruction set, e.g. to compare against the scalar path.
+/// Levels the CPU does not support are clamped to the best supported one.
+/// Not thread safe - only call while no terrain is being generated.
+/// </summary>
+/// <param name="level">instruction set to use from now on</param>
+void PerlinNoise::setSimdLevel(SimdLevel level)
+{
+    SimdLevel supported = detectSimdLevel();
+    activeLevel = (int)level > (int)supported ? supported : level;
+}
+
+/// <summary>
+/// Find the widest instruction set that both the CPU and the OS support
+/// </summary>
+/// <returns>best supported SimdLevel</returns>
+PerlinNoise::SimdLevel PerlinNoise::detectSimdLevel()
+{
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+    int info[4];
+    __cpuid(info, 0);
+    int maxLeaf = info[0];
+    __cpuid(info, 1);
+    bool sse41 = (info[2] & (1 << 19)) != 0;
+    bool osxsave = (info[2] & (1 << 27)) != 0;
+    bool avx = (info[2] & (1 << 28)) != 0;
+    // the OS has to save the wide registers on context switches, or the wide paths are unusable
+    unsigned long long xcr0 = osxsave ? _xgetbv(0) : 0;
+    bool avx2 = false;
+    bool avx512 = false;
+    if (maxLeaf >= 7)
+    {
+        __cpuidex(info, 7, 0);
+        avx2 = avx && (info[1] & (1 << 5)) != 0 && (xcr0 & 0x6) == 0x6;
+        avx512 = (info[1] & (1 << 16)) != 0 && (xcr0 & 0xE6) == 0xE6;
+    }
+    if (avx512) { return SimdLevel::AVX512; }
+    if (avx2) { return SimdLevel::AVX2; }
+    if (sse41) { return SimdLevel::SSE41; }
+    return SimdLevel::Scalar;
+#elif (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f")) { return SimdLevel::AVX512; }
+    if (__builtin_cpu_supports("avx2")) { return SimdLevel::AVX2; }
+    if (__builtin_cpu_supports("sse4.1")) { return SimdLevel::SSE41; }
+    return SimdLevel::Scalar;
+#else
+    return SimdLevel::Scalar;
+#endif
+}
+
+/// <summary>
+/// Readable name of an instruction set for log output
+/// </summary>
+const char* PerlinNoise::simdLevelName(SimdLevel level)
+{
+    switch (level)
+    {
+    case SimdLevel::AVX512: return "AVX-512";
+    case SimdLevel::AVX2:   return "AVX2";
+    case SimdLevel::SSE41:  return "SSE4.1";
+    default:                return "scalar";
+    }
+}
+
+/// <summary>
+/// Hashing currently used by sample() and the batches
+/// </summary>
+PerlinNoise::Hashing PerlinNoise::hashing()
+{
+    return activeHashing;
+}
+
+/// <summary>
+/// Pick where the corner gradients come from. Hashing::Integer needs no table lookups, so its SIMD paths
+/// are not bound by gathers, but it is a different noise field with the same character, not the same heights.
+/// Not thread safe - only call while no terrain is being generated.
+/// </summary>
+/// <param name="mode">hashing to use from now on</param>
+void PerlinNoise::setHashing(Hashing mode)
+{
+    activeHashing = mode;
+}
+
+/// <summary>
+/// Readable name of a hashing for log output and command lines
+/// </summary>
+const char* PerlinNoise::hashingName(Hashing mode)
+{
+    return mode == Hashing::Integer ? "integer" : "permutation";
+}
+
+/// <summary>
+/// Doubled permutation table (512 entries) shared by every Perlin implementation
+/// </summary>
+const int* PerlinNoise::permutationTable()
+{
+    return p;
+}
+
+/// <summary>
+/// Initalize permutation array for Perlin Noise
+/// Source: https://adrianb.io/2014/08/09/perlinnoise.html
+/// </summary>
+const int PerlinNoise::permutation[] = { 151, 160, 137, 91, 90, 15,                                    // Hash lookup table as defined by Ken Perlin.  This is a randomly
+        131, 13, 201, 95, 96, 53, 194, 233, 7, 225, 140, 36, 103, 30, 69, 142, 8, 99, 37, 240, 21, 10, 23,        // arranged array of all numbers from 0-255 inclusive.
+        190, 6, 148, 247, 120, 234, 75, 0, 26, 197, 62, 94, 252, 219, 203, 117, 35, 11, 32, 57, 177, 33,
+        88, 237, 149, 56, 87, 174, 20, 125, 136, 171, 168, 68, 175, 74, 165, 71, 134, 139, 48, 27, 166,
+        77, 146, 158, 231, 83, 111, 229, 122, 60, 211, 133, 230, 220, 105, 92, 41, 55, 46, 245, 40, 244,
+        102, 143, 54, 65, 25, 63, 161, 1, 216, 80, 73, 209, 76, 132, 187, 208, 89, 18, 169, 200, 196,
+        135, 130, 116, 188, 159, 86, 164, 100, 109, 198, 173, 186, 3, 64, 52, 217, 226, 250, 124, 123,
+        5, 202, 38, 147, 118, 126, 255, 82, 85, 212, 207, 206, 59, 227, 47, 16, 58, 17, 182, 189, 28, 42,
+        223, 183, 170, 213, 119, 248, 152, 2, 44, 154, 163, 70, 221, 153, 101, 155, 167, 43, 172, 9,
+        129, 22, 39, 253, 19, 98, 108, 110, 79, 113, 224, 232, 178, 185, 112, 104, 218, 246, 97, 228,
+        251, 34, 242, 193, 238, 210, 144, 12, 191, 179, 162, 241, 81, 51, 145, 235, 249, 14, 239, 107,
+        49, 192, 214, 31, 181, 199, 106, 157, 184, 84, 204, 176, 115, 121, 50, 45, 127, 4, 150, 254,
+        138, 236, 205, 93, 222, 114, 67, 29, 24, 72, 243, 141, 128, 195, 78, 66, 215, 61, 156, 180
+};
+
+// Doubled permutation to avoid overflow, built once and only read afterwards
+const int* PerlinNoise::p = []() {
+    int* table = new int[512];
+    for (int x = 0; x < 512; x++) {
+        table[x] = permutation[x % 256];
+    }
+    return table;
+}();
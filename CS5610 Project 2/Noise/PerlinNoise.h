@@ -0,0 +1,58 @@
+/**
+*
+* Batched Perlin noise - evaluates many points per call with the widest SIMD unit the CPU has.
+* Based on the reference implementation from: https://adrianb.io/2014/08/09/perlinnoise.html
+*
+**/
+
+#pragma once
+
+#include <stddef.h>
+
+class PerlinNoise
+{
+public:
+	enum class SimdLevel { Scalar, SSE41, AVX2, AVX512 };
+	// where the gradients of the lattice corners come from, see PerlinKernel.h
+	enum class Hashing { Permutation, Integer };
+
+	static void sampleBatch(const float* x, const float* y, const float* z, float* out, size_t count);
+	static void sampleBatchGradient(const float* x, const float* y, const float* z,
+		float* out, float* dx, float* dy, float* dz, size_t count);
+	static float sample(float x, float y, float z);
+
+	static SimdLevel simdLevel();
+	static void setSimdLevel(SimdLevel level);
+	static SimdLevel detectSimdLevel();
+	static const char* simdLevelName(SimdLevel level);
+
+	static Hashing hashing();
+	static void setHashing(Hashing mode);
+	static const char* hashingName(Hashing mode);
+
+	static const int* permutationTable();
+
+private:
+	static SimdLevel activeLevel;
+	static Hashing activeHashing;
+	static const int permutation[];
+	static const int* p;
+};
+
+// per instruction set kernels, each lives in its own translation unit (see PerlinKernel.h)
+void perlinBatchScalar(const int* p, const float* x, const float* y, const float* z, float* out, size_t count);
+void perlinBatchSSE41(const int* p, const float* x, const float* y, const float* z, float* out, size_t count);
+void perlinBatchAVX2(const int* p, const float* x, const float* y, const float* z, float* out, size_t count);
+void perlinBatchAVX512(const int* p, const float* x, const float* y, const float* z, float* out, size_t count);
+void perlinBatchGradientScalar(const int* p, const float* x, const float* y, const float* z, float* out, float* dx, float* dy, float* dz, size_t count);
+void perlinBatchGradientSSE41(const int* p, const float* x, const float* y, const float* z, float* out, float* dx, float* dy, float* dz, size_t count);
+void perlinBatchGradientAVX2(const int* p, const float* x, const float* y, const float* z, float* out, float* dx, float* dy, float* dz, size_t count);
+void perlinBatchGradientAVX512(const int* p, const float* x, const float* y, const float* z, float* out, float* dx, float* dy, float* dz, size_t count);
+void perlinHashBatchScalar(const float* x, const float* y, const float* z, float* out, size_t count);
+void perlinHashBatchSSE41(const float* x, const float* y, const float* z, float* out, size_t count);
+void perlinHashBatchAVX2(const float* x, const float* y, const float* z, float* out, size_t count);
+void perlinHashBatchAVX512(const float* x, const float* y, const float* z, float* out, size_t count);
+void perlinHashBatchGradientScalar(const float* x, const float* y, const float* z, float* out, float* dx, float* dy, float* dz, size_t count);
+void perlinHashBatchGradientSSE41(const float* x, const float* y, const float* z, float* out, float* dx, float* dy, float* dz, size_t count);
+void perlinHashBatchGradientAVX2(const float* x, const float* y, const float* z, float* out, float* dx, float* dy, float* dz, size_t count);
+void perlinHashBatchGradientAVX512(const float* x, const float* y, const float* z, float* out, float* dx, float* dy, float* dz, size_t count);
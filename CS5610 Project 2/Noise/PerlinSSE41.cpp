@@ -0,0 +1,60 @@
+/**
+*
+* SSE4.1 lanes for the Perlin kernel - 4 points per call.
+* Compiled for SSE4.1 only inside the target region below, the dispatcher in PerlinNoise.cpp
+* makes sure it only runs on CPUs that support it.
+*
+**/
+
+#include "PerlinNoise.h"
+#include "PerlinGrid.h"
+
+#include <immintrin.h>
+
+#if defined(__clang__)
+#pragma clang attribute push (__attribute__((target("sse4.1"))), apply_to = function)
+#elif defined(__GNUC__)
+#pragma GCC push_options
+#pragma GCC target("sse4.1")
+#pragma GCC optimize("fp-contract=off")
+#endif
+
+// included inside the target region so the lanes and the kernel templates are compiled for this instruction set
+#include "SSE41Lanes.h"
+#include "PerlinKernel.h"
+#include "PerlinGridKernel.h"
+
+void perlinBatchSSE41(const int* p, const float* x, const float* y, const float* z, float* out, size_t count)
+{
+    size_t done = perlin_kernel::batch<SSE41Lanes>(perlin_kernel::TableHash{ p }, x, y, z, out, count);
+    perlinBatchScalar(p, x + done, y + done, z + done, out + done, count - done);
+}
+
+void perlinBatchGradientSSE41(const int* p, const float* x, const float* y, const float* z, float* out, float* dx, float* dy, float* dz, size_t count)
+{
+    size_t done = perlin_kernel::batchGradient<SSE41Lanes>(perlin_kernel::TableHash{ p }, x, y, z, out, dx, dy, dz, count);
+    perlinBatchGradientScalar(p, x + done, y + done, z + done, out + done, dx + done, dy + done, dz + done, count - done);
+}
+
+void perlinHashBatchSSE41(const float* x, const float* y, const float* z, float* out, size_t count)
+{
+    size_t done = perlin_kernel::batch<SSE41Lanes>(perlin_kernel::IntegerHash(), x, y, z, out, count);
+    perlinHashBatchScalar(x + done, y + done, z + done, out + done, count - done);
+}
+
+void perlinHashBatchGradientSSE41(const float* x, const float* y, const float* z, float* out, float* dx, float* dy, float* dz, size_t count)
+{
+    size_t done = perlin_kernel::batchGradient<SSE41Lanes>(perlin_kernel::IntegerHash(), x, y, z, out, dx, dy, dz, count);
+    perlinHashBatchGradientScalar(x + done, y + done, z + done, out + done, dx + done, dy + done, dz + done, count - done);
+}
+
+void perlinGridWalkSSE41(const PerlinGridCell* cells, size_t cellCount, const float* xf, const float* u, const float* duf, float* out, float* dx, float* dz)
+{
+    perlin_grid_kernel::walk<SSE41Lanes>(cells, cellCount, xf, u, duf, out, dx, dz);
+}
+
+#if defined(__clang__)
+#pragma clang attribute pop
+#elif defined(__GNUC__)
+#pragma GCC pop_options
+#endif
@@ -0,0 +1,55 @@
+/**
+*
+* SSE4.1 lanes for the noise kernels - 4 points per call.
+* Only include it inside an SSE4.1 target region, see PerlinSSE41.cpp.
+*
+**/
+
+#pragma once
+
+#include <stddef.h>
+#include <immintrin.h>
+
+// internal linkage, so every translation unit that includes the lanes gets its own copy built for its own target
+namespace {
+
+struct SSE41Lanes
+{
+    static const size_t width = 4;
+    typedef __m128 F;
+    typedef __m128i I;
+    typedef __m128 M;
+
+    static F load(const float* src) { return _mm_loadu_ps(src); }
+    static void store(float* dst, F a) { _mm_storeu_ps(dst, a); }
+    static F set1(float a) { return _mm_set1_ps(a); }
+    static F add(F a, F b) { return _mm_add_ps(a, b); }
+    static F sub(F a, F b) { return _mm_sub_ps(a, b); }
+    static F mul(F a, F b) { return _mm_mul_ps(a, b); }
+    static F floor(F a) { return _mm_floor_ps(a); }
+
+    static I toInt(F a) { return _mm_cvttps_epi32(a); }
+    static I set1i(int a) { return _mm_set1_epi32(a); }
+    static I addi(I a, I b) { return _mm_add_epi32(a, b); }
+    static I andi(I a, I b) { return _mm_and_si128(a, b); }
+    template <int N> static I shl(I a) { return _mm_slli_epi32(a, N); }
+    static I muli(I a, I b) { return _mm_mullo_epi32(a, b); }
+    static I xori(I a, I b) { return _mm_xor_si128(a, b); }
+    template <int N> static I shr(I a) { return _mm_srli_epi32(a, N); }
+    // SSE has no gather instruction, so look the lanes up one by one
+    static I gather(const int* table, I index)
+    {
+        return _mm_setr_epi32(table[_mm_extract_epi32(index, 0)], table[_mm_extract_epi32(index, 1)],
+            table[_mm_extract_epi32(index, 2)], table[_mm_extract_epi32(index, 3)]);
+    }
+
+    static M less(I a, I b) { return _mm_castsi128_ps(_mm_cmplt_epi32(a, b)); }
+    static M equal(I a, I b) { return _mm_castsi128_ps(_mm_cmpeq_epi32(a, b)); }
+    static M either(M a, M b) { return _mm_or_ps(a, b); }
+    static M lessf(F a, F b) { return _mm_cmplt_ps(a, b); }
+    static F max(F a, F b) { return _mm_max_ps(a, b); }
+    static F select(M mask, F a, F b) { return _mm_blendv_ps(b, a, mask); }
+    static F flipSign(F a, I bits) { return _mm_xor_ps(a, _mm_castsi128_ps(bits)); }
+};
+
+}
@@ -0,0 +1,50 @@
+/**
+*
+* Scalar lanes for the noise kernels - one point per call.
+* Used for the tail of every batch and on CPUs without SSE4.1.
+*
+**/
+
+#pragma once
+
+#include <stddef.h>
+#include <math.h>
+
+// internal linkage, so every translation unit that includes the lanes gets its own copy built for its own target
+namespace {
+
+struct ScalarLanes
+{
+    static const size_t width = 1;
+    typedef float F;
+    typedef int I;
+    typedef bool M;
+
+    static F load(const float* src) { return *src; }
+    static void store(float* dst, F a) { *dst = a; }
+    static F set1(float a) { return a; }
+    static F add(F a, F b) { return a + b; }
+    static F sub(F a, F b) { return a - b; }
+    static F mul(F a, F b) { return a * b; }
+    static F floor(F a) { return floorf(a); }
+
+    static I toInt(F a) { return (int)a; }
+    static I set1i(int a) { return a; }
+    static I addi(I a, I b) { return a + b; }
+    static I andi(I a, I b) { return a & b; }
+    template <int N> static I shl(I a) { return (int)((unsigned int)a << N); }
+    static I muli(I a, I b) { return (int)((unsigned int)a * (unsigned int)b); }
+    static I xori(I a, I b) { return a ^ b; }
+    template <int N> static I shr(I a) { return (int)((unsigned int)a >> N); }
+    static I gather(const int* table, I index) { return table[index]; }
+
+    static M less(I a, I b) { return a < b; }
+    static M equal(I a, I b) { return a == b; }
+    static M either(M a, M b) { return a || b; }
+    static M lessf(F a, F b) { return a < b; }
+    static F max(F a, F b) { return a > b ? a : b; }
+    static F select(M mask, F a, F b) { return mask ? a : b; }
+    static F flipSign(F a, I bits) { return bits < 0 ? -a : a; }
+};
+
+}
@@ -0,0 +1,53 @@
+/**
+*
+* AVX2 lanes for the OpenSimplex2 kernels - 8 points per call.
+* Compiled for AVX2 only inside the target region below, the dispatcher in SimplexNoise.cpp
+* makes sure it only runs on CPUs that support it.
+*
+**/
+
+#include "SimplexNoise.h"
+
+#include <immintrin.h>
+
+#if defined(__clang__)
+#pragma clang attribute push (__attribute__((target("avx2"))), apply_to = function)
+#elif defined(__GNUC__)
+#pragma GCC push_options
+#pragma GCC target("avx2")
+#pragma GCC optimize("fp-contract=off")
+#endif
+
+// included inside the target region so the lanes and the kernel templates are compiled for this instruction set
+#include "AVX2Lanes.h"
+#include "SimplexKernel.h"
+
+void simplex2BatchAVX2(const float* x, const float* z, float* out, size_t count)
+{
+    size_t done = simplex_kernel::batch2<AVX2Lanes>(x, z, out, count);
+    simplex2BatchScalar(x + done, z + done, out + done, count - done);
+}
+
+void simplex2BatchGradientAVX2(const float* x, const float* z, float* out, float* dx, float* dz, size_t count)
+{
+    size_t done = simplex_kernel::batchGradient2<AVX2Lanes>(x, z, out, dx, dz, count);
+    simplex2BatchGradientScalar(x + done, z + done, out + done, dx + done, dz + done, count - done);
+}
+
+void simplex3BatchAVX2(const float* x, const float* y, const float* z, float* out, size_t count)
+{
+    size_t done = simplex_kernel::batch3<AVX2Lanes>(x, y, z, out, count);
+    simplex3BatchScalar(x + done, y + done, z + done, out + done, count - done);
+}
+
+void simplex3BatchGradientAVX2(const float* x, const float* y, const float* z, float* out, float* dx, float* dy, float* dz, size_t count)
+{
+    size_t done = simplex_kernel::batchGradient3<AVX2Lanes>(x, y, z, out, dx, dy, dz, count);
+    simplex3BatchGradientScalar(x + done, y + done, z + done, out + done, dx + done, dy + done, dz + done, count - done);
+}
+
+#if defined(__clang__)
+#pragma clang attribute pop
+#elif defined(__GNUC__)
+#pragma GCC pop_options
+#endif
@@ -0,0 +1,304 @@
+/**
+*
+* Instruction set independent OpenSimplex2 noise kernels, written against the lanes interface of PerlinKernel.h.
+*   2D: the triangle lattice of simplex noise, three corners per point instead of the four of 2D Perlin.
+*   3D: the rotated body centred cubic lattice of OpenSimplex2, two offset cubic lattices with two corners each,
+*       so four corners per point instead of the eight of 3D Perlin.
+* Lattices, falloff and the XZ plane rotation follow K. Spencer's OpenSimplex2: https://github.com/KdotJPG/OpenSimplex2
+* The corner gradients are picked arithmetically from IntegerHash style hashes instead of from gradient tables,
+* so, as with PerlinNoise::Hashing::Integer, no lane ever gathers.
+*
+**/
+
+#pragma once
+
+#include "PerlinKernel.h"
+
+namespace simplex_kernel {
+
+using perlin_kernel::Gradient;
+
+// skew from the square grid to the triangle lattice and back: (sqrt(3) - 1) / 2 and (1 / sqrt(3) - 1) / 2
+const float SKEW_2D = 0.366025403784439f;
+const float UNSKEW_2D = -0.211324865405187f;
+// squared radius of the falloff around every corner. The larger 3D radius of current OpenSimplex2 reaches corners
+// the lattice walk skips and leaves small steps in the surface, 0.5 keeps the noise and its derivatives continuous.
+const float RSQUARED_2D = 0.5f;
+const float RSQUARED_3D = 0.5f;
+// scale of the corner sums before they are mapped around 0.5 like PerlinNoise, measured so the values spread
+// as much as Perlin's (standard deviation of about 0.135) and the terrain keeps its height range
+const float NORMALIZE_2D = 50.0f;
+const float NORMALIZE_3D = 53.0f;
+// rotation that puts the lattice's best looking plane on XZ, the ground plane of the terrain
+const float ROTATE_3D_ORTHOGONALIZER = -0.211324865405187f;
+const float ROOT3OVER3 = 0.577350269189626f;
+// per axis hash factors, and the seed that tells the two cubic lattices of 3D apart
+const int HASH_X = (int)0x8da6b343u;
+const int HASH_Y = (int)0xd8163841u;
+const int HASH_Z = (int)0xcb1ab31fu;
+const int SEED_FLIP_3D = 0x3c6ef372;
+
+// One of 8 directions 45 degrees apart: bit 2 picks a diagonal or an axis,
+// bits 0 and 1 the signs of a diagonal, or the sign and the axis of an axis
+template <class V>
+inline void gradient2(typename V::I hash, typename V::F& gx, typename V::F& gy)
+{
+	typedef typename V::F F;
+	typedef typename V::I I;
+
+	I h = V::andi(hash, V::set1i(7));
+	I signX = V::template shl<31>(V::andi(h, V::set1i(1)));
+	I signY = V::template shl<30>(V::andi(h, V::set1i(2)));
+	typename V::M diagonal = V::equal(V::andi(h, V::set1i(4)), V::set1i(4));
+	typename V::M alongY = V::equal(V::andi(h, V::set1i(2)), V::set1i(2));
+	F zero = V::set1(0.0f);
+	F axis = V::flipSign(V::set1(1.0f), signX);
+	F diagonalLength = V::set1(0.707106781f);
+	gx = V::select(diagonal, V::flipSign(diagonalLength, signX), V::select(alongY, zero, axis));
+	gy = V::select(diagonal, V::flipSign(diagonalLength, signY), V::select(alongY, axis, zero));
+}
+
+// Add one 2D corner: falloff (r^2 - |d|^2)^4 times the dot product of its gradient with the offset d,
+// and with Derivatives also the derivative of that, a^4 g - 8 a^3 (g . d) d
+template <class V, bool Derivatives>
+inline void corner2(typename V::I hash, typename V::F dx, typename V::F dy,
+	typename V::F& value, typename V::F& ddx, typename V::F& ddy)
+{
+	typedef typename V::F F;
+
+	F gx, gy;
+	gradient2<V>(hash, gx, gy);
+	F a = V::max(V::sub(V::sub(V::set1(RSQUARED_2D), V::mul(dx, dx)), V::mul(dy, dy)), V::set1(0.0f));
+	F a2 = V::mul(a, a);
+	F a4 = V::mul(a2, a2);
+	F dot = V::add(V::mul(gx, dx), V::mul(gy, dy));
+	value = V::add(value, V::mul(a4, dot));
+	if (Derivatives)
+	{
+		F slope = V::mul(V::mul(V::set1(8.0f), V::mul(a2, a)), dot);
+		ddx = V::add(ddx, V::sub(V::mul(a4, gx), V::mul(slope, dx)));
+		ddy = V::add(ddy, V::sub(V::mul(a4, gy), V::mul(slope, dy)));
+	}
+}
+
+// Same as corner2() in 3D, with Perlin's 12 edge gradients (see perlin_kernel::gradVector())
+template <class V, bool Derivatives>
+inline void corner3(typename V::I hash, typename V::F dx, typename V::F dy, typename V::F dz,
+	typename V::F& value, Gradient<V>& derivative)
+{
+	typedef typename V::F F;
+
+	F gx, gy, gz;
+	perlin_kernel::gradVector<V>(hash, gx, gy, gz);
+	F a = V::sub(V::sub(V::set1(RSQUARED_3D), V::mul(dx, dx)), V::add(V::mul(dy, dy), V::mul(dz, dz)));
+	a = V::max(a, V::set1(0.0f));
+	F a2 = V::mul(a, a);
+	F a4 = V::mul(a2, a2);
+	F dot = V::add(V::mul(gx, dx), V::add(V::mul(gy, dy), V::mul(gz, dz)));
+	value = V::add(value, V::mul(a4, dot));
+	if (Derivatives)
+	{
+		F slope = V::mul(V::mul(V::set1(8.0f), V::mul(a2, a)), dot);
+		derivative.x = V::add(derivative.x, V::sub(V::mul(a4, gx), V::mul(slope, dx)));
+		derivative.y = V::add(derivative.y, V::sub(V::mul(a4, gy), V::mul(slope, dy)));
+		derivative.z = V::add(derivative.z, V::sub(V::mul(a4, gz), V::mul(slope, dz)));
+	}
+}
+
+// 2D OpenSimplex2 of V::width points in the x, z plane, mapped to 0 - 1
+template <class V, bool Derivatives>
+inline typename V::F noise2(typename V::F x, typename V::F z, typename V::F& ddx, typename V::F& ddz)
+{
+	typedef typename V::F F;
+	typedef typename V::I I;
+
+	// the triangle the point falls in, in skewed coordinates, and the offset to its first corner
+	F s = V::mul(V::add(x, z), V::set1(SKEW_2D));
+	F xs = V::add(x, s);
+	F zs = V::add(z, s);
+	F xsb = V::floor(xs);
+	F zsb = V::floor(zs);
+	F xi = V::sub(xs, xsb);
+	F zi = V::sub(zs, zsb);
+	F t = V::mul(V::add(xi, zi), V::set1(UNSKEW_2D));
+	F dx0 = V::add(xi, t);
+	F dz0 = V::add(zi, t);
+
+	I kx = V::set1i(HASH_X);
+	I kz = V::set1i(HASH_Z);
+	I hx = V::muli(V::toInt(xsb), kx);
+	I hz = V::muli(V::toInt(zsb), kz);
+
+	F zero = V::set1(0.0f);
+	F one = V::set1(1.0f);
+	F value = zero;
+	ddx = zero;
+	ddz = zero;
+	corner2<V, Derivatives>(perlin_kernel::mixHash<V>(V::addi(hx, hz)), dx0, dz0, value, ddx, ddz);
+
+	// the corner across the diagonal, (1, 1) in skewed coordinates
+	F across = V::set1(1.0f + 2.0f * UNSKEW_2D);
+	corner2<V, Derivatives>(perlin_kernel::mixHash<V>(V::addi(V::addi(hx, kx), V::addi(hz, kz))),
+		V::sub(dx0, across), V::sub(dz0, across), value, ddx, ddz);
+
+	// (0, 1) for points above the diagonal, (1, 0) below it
+	F stepX = V::select(V::lessf(dx0, dz0), zero, one);
+	F stepZ = V::sub(one, stepX);
+	F unskew = V::set1(UNSKEW_2D);
+	I h2 = V::addi(V::addi(hx, V::muli(V::toInt(stepX), kx)), V::addi(hz, V::muli(V::toInt(stepZ), kz)));
+	corner2<V, Derivatives>(perlin_kernel::mixHash<V>(h2),
+		V::sub(V::sub(dx0, stepX), unskew), V::sub(V::sub(dz0, stepZ), unskew), value, ddx, ddz);
+
+	F half = V::set1(0.5f);
+	F scale = V::mul(V::set1(NORMALIZE_2D), half);
+	if (Derivatives)
+	{
+		ddx = V::mul(ddx, scale);
+		ddz = V::mul(ddz, scale);
+	}
+	return V::add(V::mul(value, scale), half);
+}
+
+// The closest point of one cubic lattice, and the next closest one along the axis of the largest offset.
+// Coordinates are in the rotated space of noise3().
+template <class V, bool Derivatives>
+inline void lattice3(typename V::F xr, typename V::F yr, typename V::F zr, int seed,
+	typename V::F& value, Gradient<V>& derivative)
+{
+	typedef typename V::F F;
+	typedef typename V::I I;
+
+	F half = V::set1(0.5f);
+	F xb = V::floor(V::add(xr, half));
+	F yb = V::floor(V::add(yr, half));
+	F zb = V::floor(V::add(zr, half));
+	F dx = V::sub(xr, xb);
+	F dy = V::sub(yr, yb);
+	F dz = V::sub(zr, zb);
+
+	I kx = V::set1i(HASH_X);
+	I ky = V::set1i(HASH_Y);
+	I kz = V::set1i(HASH_Z);
+	I h = V::addi(V::addi(V::muli(V::toInt(xb), kx), V::muli(V::toInt(yb), ky)),
+		V::addi(V::muli(V::toInt(zb), kz), V::set1i(seed)));
+	corner3<V, Derivatives>(perlin_kernel::mixHash<V>(h), dx, dy, dz, value, derivative);
+
+	// ties go to x, then y, as in OpenSimplex2
+	F zero = V::set1(0.0f);
+	F one = V::set1(1.0f);
+	F ax = V::max(dx, V::sub(zero, dx));
+	F ay = V::max(dy, V::sub(zero, dy));
+	F az = V::max(dz, V::sub(zero, dz));
+	typename V::M zOverY = V::lessf(ay, az);
+	typename V::M notX = V::either(V::lessf(ax, ay), V::lessf(ax, az));
+	F ex = V::select(notX, zero, one);
+	F ey = V::select(notX, V::select(zOverY, zero, one), zero);
+	F ez = V::select(notX, V::select(zOverY, one, zero), zero);
+
+	// one step towards the point, an offset of exactly 0 steps up
+	F minusOne = V::set1(-1.0f);
+	F stepX = V::mul(V::select(V::lessf(dx, zero), minusOne, one), ex);
+	F stepY = V::mul(V::select(V::lessf(dy, zero), minusOne, one), ey);
+	F stepZ = V::mul(V::select(V::lessf(dz, zero), minusOne, one), ez);
+	I h2 = V::addi(V::addi(h, V::muli(V::toInt(stepX), kx)),
+		V::addi(V::muli(V::toInt(stepY), ky), V::muli(V::toInt(stepZ), kz)));
+	corner3<V, Derivatives>(perlin_kernel::mixHash<V>(h2), V::sub(dx, stepX), V::sub(dy, stepY), V::sub(dz, stepZ),
+		value, derivative);
+}
+
+// 3D OpenSimplex2 of V::width points, mapped to 0 - 1
+template <class V, bool Derivatives>
+inline typename V::F noise3(typename V::F x, typename V::F y, typename V::F z, Gradient<V>& gradient)
+{
+	typedef typename V::F F;
+
+	// rotate so the XZ plane gets the lattice's most even looking slices
+	F orthogonalizer = V::set1(ROTATE_3D_ORTHOGONALIZER);
+	F root3over3 = V::set1(ROOT3OVER3);
+	F xz = V::add(x, z);
+	F s2 = V::mul(xz, orthogonalizer);
+	F yy = V::mul(y, root3over3);
+	F xr = V::add(V::add(x, s2), yy);
+	F zr = V::add(V::add(z, s2), yy);
+	F yr = V::sub(yy, V::mul(xz, root3over3));
+
+	// the second lattice is the first one shifted by half a cell along every axis
+	F zero = V::set1(0.0f);
+	F half = V::set1(0.5f);
+	F value = zero;
+	Gradient<V> r = { zero, zero, zero };
+	lattice3<V, Derivatives>(xr, yr, zr, 0, value, r);
+	lattice3<V, Derivatives>(V::sub(xr, half), V::sub(yr, half), V::sub(zr, half), SEED_FLIP_3D, value, r);
+
+	F scale = V::mul(V::set1(NORMALIZE_3D), half);
+	if (Derivatives)
+	{
+		// back from the rotated space, the transpose of the rotation above
+		F diagonal = V::add(V::set1(1.0f), orthogonalizer);
+		gradient.x = V::add(V::mul(r.x, diagonal), V::sub(V::mul(r.z, orthogonalizer), V::mul(r.y, root3over3)));
+		gradient.y = V::mul(V::add(V::add(r.x, r.y), r.z), root3over3);
+		gradient.z = V::add(V::mul(r.z, diagonal), V::sub(V::mul(r.x, orthogonalizer), V::mul(r.y, root3over3)));
+		gradient.x = V::mul(gradient.x, scale);
+		gradient.y = V::mul(gradient.y, scale);
+		gradient.z = V::mul(gradient.z, scale);
+	}
+	return V::add(V::mul(value, scale), half);
+}
+
+// Evaluate as many whole V::width groups as fit in count, returns how many points were written
+template <class V>
+inline size_t batch2(const float* x, const float* z, float* out, size_t count)
+{
+	size_t i = 0;
+	for (; i + V::width <= count; i += V::width)
+	{
+		typename V::F unusedX, unusedZ;
+		V::store(out + i, noise2<V, false>(V::load(x + i), V::load(z + i), unusedX, unusedZ));
+	}
+	return i;
+}
+
+// Same as batch2() but also writes the derivatives along x and z
+template <class V>
+inline size_t batchGradient2(const float* x, const float* z, float* out, float* dx, float* dz, size_t count)
+{
+	size_t i = 0;
+	for (; i + V::width <= count; i += V::width)
+	{
+		typename V::F gx, gz;
+		V::store(out + i, noise2<V, true>(V::load(x + i), V::load(z + i), gx, gz));
+		V::store(dx + i, gx);
+		V::store(dz + i, gz);
+	}
+	return i;
+}
+
+template <class V>
+inline size_t batch3(const float* x, const float* y, const float* z, float* out, size_t count)
+{
+	size_t i = 0;
+	for (; i + V::width <= count; i += V::width)
+	{
+		Gradient<V> unused;
+		V::store(out + i, noise3<V, false>(V::load(x + i), V::load(y + i), V::load(z + i), unused));
+	}
+	return i;
+}
+
+template <class V>
+inline size_t batchGradient3(const float* x, const float* y, const float* z,
+	float* out, float* dx, float* dy, float* dz, size_t count)
+{
+	size_t i = 0;
+	for (; i + V::width <= count; i += V::width)
+	{
+		Gradient<V> g;
+		V::store(out + i, noise3<V, true>(V::load(x + i), V::load(y + i), V::load(z + i), g));
+		V::store(dx + i, g.x);
+		V::store(dy + i, g.y);
+		V::store(dz + i, g.z);
+	}
+	return i;
+}
+
+}
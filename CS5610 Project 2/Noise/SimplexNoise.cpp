@@ -0,0 +1,139 @@
+/**
+*
+* Batched OpenSimplex2 noise in 2D and 3D - evaluates many points per call with the instruction set
+* PerlinNoise::simdLevel() picks, see SimplexKernel.h.
+*
+**/
+
+#include "SimplexNoise.h"
+#include "PerlinNoise.h"
+
+// no FMA contraction in the kernels, see PerlinKernel.h
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC optimize("fp-contract=off")
+#endif
+
+#include "ScalarLanes.h"
+#include "SimplexKernel.h"
+
+void simplex2BatchScalar(const float* x, const float* z, float* out, size_t count)
+{
+    simplex_kernel::batch2<ScalarLanes>(x, z, out, count);
+}
+
+void simplex2BatchGradientScalar(const float* x, const float* z, float* out, float* dx, float* dz, size_t count)
+{
+    simplex_kernel::batchGradient2<ScalarLanes>(x, z, out, dx, dz, count);
+}
+
+void simplex3BatchScalar(const float* x, const float* y, const float* z, float* out, size_t count)
+{
+    simplex_kernel::batch3<ScalarLanes>(x, y, z, out, count);
+}
+
+void simplex3BatchGradientScalar(const float* x, const float* y, const float* z, float* out, float* dx, float* dy, float* dz, size_t count)
+{
+    simplex_kernel::batchGradient3<ScalarLanes>(x, y, z, out, dx, dy, dz, count);
+}
+
+/// <summary>
+/// Evaluate 2D OpenSimplex2 noise for count points at once, using the active instruction set.
+/// Output matches sample2D() bit for bit whatever instruction set is picked.
+/// </summary>
+/// <param name="x">x coordinates of the points</param>
+/// <param name="z">z coordinates of the points</param>
+/// <param name="out">receives the noise value (0 - 1) of every point</param>
+/// <param name="count">number of points</param>
+void SimplexNoise::sampleBatch2D(const float* x, const float* z, float* out, size_t count)
+{
+    switch (PerlinNoise::simdLevel())
+    {
+    case PerlinNoise::SimdLevel::AVX512: simplex2BatchAVX512(x, z, out, count); break;
+    case PerlinNoise::SimdLevel::AVX2:   simplex2BatchAVX2(x, z, out, count); break;
+    case PerlinNoise::SimdLevel::SSE41:  simplex2BatchSSE41(x, z, out, count); break;
+    default:                             simplex2BatchScalar(x, z, out, count); break;
+    }
+}
+
+/// <summary>
+/// Evaluate 2D OpenSimplex2 noise and its analytic derivatives for count points at once
+/// </summary>
+/// <param name="x">x coordinates of the points</param>
+/// <param name="z">z coordinates of the points</param>
+/// <param name="out">receives the noise value (0 - 1) of every point</param>
+/// <param name="dx">receives d(out)/dx of every point</param>
+/// <param name="dz">receives d(out)/dz of every point</param>
+/// <param name="count">number of points</param>
+void SimplexNoise::sampleBatchGradient2D(const float* x, const float* z, float* out, float* dx, float* dz, size_t count)
+{
+    switch (PerlinNoise::simdLevel())
+    {
+    case PerlinNoise::SimdLevel::AVX512: simplex2BatchGradientAVX512(x, z, out, dx, dz, count); break;
+    case PerlinNoise::SimdLevel::AVX2:   simplex2BatchGradientAVX2(x, z, out, dx, dz, count); break;
+    case PerlinNoise::SimdLevel::SSE41:  simplex2BatchGradientSSE41(x, z, out, dx, dz, count); break;
+    default:                             simplex2BatchGradientScalar(x, z, out, dx, dz, count); break;
+    }
+}
+
+/// <summary>
+/// Evaluate 2D OpenSimplex2 noise for a single point
+/// </summary>
+/// <returns>noise value between 0 and 1</returns>
+float SimplexNoise::sample2D(float x, float z)
+{
+    float unusedX, unusedZ;
+    return simplex_kernel::noise2<ScalarLanes, false>(x, z, unusedX, unusedZ);
+}
+
+/// <summary>
+/// Evaluate 3D OpenSimplex2 noise for count points at once, using the active instruction set.
+/// Output matches sample3D() bit for bit whatever instruction set is picked.
+/// </summary>
+/// <param name="x">x coordinates of the points</param>
+/// <param name="y">y coordinates of the points</param>
+/// <param name="z">z coordinates of the points</param>
+/// <param name="out">receives the noise value (0 - 1) of every point</param>
+/// <param name="count">number of points</param>
+void SimplexNoise::sampleBatch3D(const float* x, const float* y, const float* z, float* out, size_t count)
+{
+    switch (PerlinNoise::simdLevel())
+    {
+    case PerlinNoise::SimdLevel::AVX512: simplex3BatchAVX512(x, y, z, out, count); break;
+    case PerlinNoise::SimdLevel::AVX2:   simplex3BatchAVX2(x, y, z, out, count); break;
+    case PerlinNoise::SimdLevel::SSE41:  simplex3BatchSSE41(x, y, z, out, count); break;
+    default:                             simplex3BatchScalar(x, y, z, out, count); break;
+    }
+}
+
+/// <summary>
+/// Evaluate 3D OpenSimplex2 noise and its analytic gradient for count points at once
+/// </summary>
+/// <param name="x">x coordinates of the points</param>
+/// <param name="y">y coordinates of the points</param>
+/// <param name="z">z coordinates of the points</param>
+/// <param name="out">receives the noise value (0 - 1) of every point</param>
+/// <param name="dx">receives d(out)/dx of every point</param>
+/// <param name="dy">receives d(out)/dy of every point</param>
+/// <param name="dz">receives d(out)/dz of every point</param>
+/// <param name="count">number of points</param>
+void SimplexNoise::sampleBatchGradient3D(const float* x, const float* y, const float* z,
+    float* out, float* dx, float* dy, float* dz, size_t count)
+{
+    switch (PerlinNoise::simdLevel())
+    {
+    case PerlinNoise::SimdLevel::AVX512: simplex3BatchGradientAVX512(x, y, z, out, dx, dy, dz, count); break;
+    case PerlinNoise::SimdLevel::AVX2:   simplex3BatchGradientAVX2(x, y, z, out, dx, dy, dz, count); break;
+    case PerlinNoise::SimdLevel::SSE41:  simplex3BatchGradientSSE41(x, y, z, out, dx, dy, dz, count); break;
+    default:                             simplex3BatchGradientScalar(x, y, z, out, dx, dy, dz, count); break;
+    }
+}
+
+/// <summary>
+/// Evaluate 3D OpenSimplex2 noise for a single point
+/// </summary>
+/// <returns>noise value between 0 and 1</returns>
+float SimplexNoise::sample3D(float x, float y, float z)
+{
+    simplex_kernel::Gradient<ScalarLanes> unused;
+    return simplex_kernel::noise3<ScalarLanes, false>(x, y, z, unused);
+}
@@ -0,0 +1,42 @@
+/**
+*
+* Batched OpenSimplex2 noise in 2D and 3D - evaluates many points per call with the instruction set
+* PerlinNoise::simdLevel() picks, see SimplexKernel.h.
+*
+**/
+
+#pragma once
+
+#include <stddef.h>
+
+class SimplexNoise
+{
+public:
+	// 2D noise lies in the x, z plane, the ground plane of the terrain
+	static void sampleBatch2D(const float* x, const float* z, float* out, size_t count);
+	static void sampleBatchGradient2D(const float* x, const float* z, float* out, float* dx, float* dz, size_t count);
+	static float sample2D(float x, float z);
+
+	static void sampleBatch3D(const float* x, const float* y, const float* z, float* out, size_t count);
+	static void sampleBatchGradient3D(const float* x, const float* y, const float* z,
+		float* out, float* dx, float* dy, float* dz, size_t count);
+	static float sample3D(float x, float y, float z);
+};
+
+// per instruction set kernels, each lives in its own translation unit like the Perlin ones
+void simplex2BatchScalar(const float* x, const float* z, float* out, size_t count);
+void simplex2BatchSSE41(const float* x, const float* z, float* out, size_t count);
+void simplex2BatchAVX2(const float* x, const float* z, float* out, size_t count);
+void simplex2BatchAVX512(const float* x, const float* z, float* out, size_t count);
+void simplex2BatchGradientScalar(const float* x, const float* z, float* out, float* dx, float* dz, size_t count);
+void simplex2BatchGradientSSE41(const float* x, const float* z, float* out, float* dx, float* dz, size_t count);
+void simplex2BatchGradientAVX2(const float* x, const float* z, float* out, float* dx, float* dz, size_t count);
+void simplex2BatchGradientAVX512(const float* x, const float* z, float* out, float* dx, float* dz, size_t count);
+void simplex3BatchScalar(const float* x, const float* y, const float* z, float* out, size_t count);
+void simplex3BatchSSE41(const float* x, const float* y, const float* z, float* out, size_t count);
+void simplex3BatchAVX2(const float* x, const float* y, const float* z, float* out, size_t count);
+void simplex3BatchAVX512(const float* x, const float* y, const float* z, float* out, size_t count);
+void simplex3BatchGradientScalar(const float* x, const float* y, const float* z, float* out, float* dx, float* dy, float* dz, size_t count);
+void simplex3BatchGradientSSE41(const float* x, const float* y, const float* z, float* out, float* dx, float* dy, float* dz, size_t count);
+void simplex3BatchGradientAVX2(const float* x, const float* y, const float* z, float* out, float* dx, float* dy, float* dz, size_t count);
+void simplex3BatchGradientAVX512(const float* x, const float* y, const float* z, float* out, float* dx, float* dy, float* dz, size_t count);
@@ -0,0 +1,96 @@
+/**
+*
+* Closed Catmull-Rom spline for moving the camera along the same path every run.
+* The spline passes through every control point, t in [0, 1) goes once around it.
+*
+**/
+
+#include "CameraPath.h"
+
+#include <cmath>
+#include <numbers>
+
+/// <summary>
+/// A wobbly circle around center, the same for every run.
+/// Radius and height vary from point to point, so the path sees near and far terrain and climbs and dives.
+/// </summary>
+/// <param name="center">middle of the circle, its y is ignored</param>
+/// <param name="radius">average distance of the points from center</param>
+/// <param name="height">average height of the points</param>
+/// <param name="points">control points, at least 4</param>
+CameraPath CameraPath::loop(const cy::Vec3f& center, float radius, float height, unsigned int points)
+{
+    CameraPath path;
+    points = points < 4 ? 4 : points;
+    for (unsigned int i = 0; i < points; i++) {
+        float angle = 2.0f * std::numbers::pi_v<float> * i / points;
+        float r = radius * (1.0f + 0.35f * std::sin(3.0f * angle));
+        float y = height * (1.0f + 0.25f * std::cos(2.0f * angle));
+        path.addPoint(cy::Vec3f(center.x + r * std::cos(angle), y, center.z + r * std::sin(angle)));
+    }
+    return path;
+}
+
+/// <summary>
+/// Append a control point, the path is closed from the last point back to the first
+/// </summary>
+void CameraPath::addPoint(const cy::Vec3f& point)
+{
+    points.push_back(point);
+}
+
+/// <summary>
+/// Number of control points
+/// </summary>
+size_t CameraPath::pointCount() const
+{
+    return points.size();
+}
+
+/// <summary>
+/// Point on the path, t wraps around so 0 and 1 are the same point
+/// </summary>
+cy::Vec3f CameraPath::position(float t) const
+{
+    if (points.empty()) { return cy::Vec3f(0.0f, 0.0f, 0.0f); }
+    size_t first;
+    float s;
+    segment(t, first, s);
+    size_t n = points.size();
+    const cy::Vec3f& p0 = points[(first + n - 1) % n];
+    const cy::Vec3f& p1 = points[first];
+    const cy::Vec3f& p2 = points[(first + 1) % n];
+    const cy::Vec3f& p3 = points[(first + 2) % n];
+    float s2 = s * s;
+    float s3 = s2 * s;
+    return 0.5f * ((2.0f * p1) + (p2 - p0) * s + (2.0f * p0 - 5.0f * p1 + 4.0f * p2 - p3) * s2 + (3.0f * p1 - p0 - 3.0f * p2 + p3) * s3);
+}
+
+/// <summary>
+/// Unit direction of travel at t
+/// </summary>
+cy::Vec3f CameraPath::direction(float t) const
+{
+    if (points.size() < 2) { return cy::Vec3f(1.0f, 0.0f, 0.0f); }
+    size_t first;
+    float s;
+    segment(t, first, s);
+    size_t n = points.size();
+    const cy::Vec3f& p0 = points[(first + n - 1) % n];
+    const cy::Vec3f& p1 = points[first];
+    const cy::Vec3f& p2 = points[(first + 1) % n];
+    const cy::Vec3f& p3 = points[(first + 2) % n];
+    cy::Vec3f tangent = 0.5f * ((p2 - p0) + (2.0f * p0 - 5.0f * p1 + 4.0f * p2 - p3) * (2.0f * s) + (3.0f * p1 - p0 - 3.0f * p2 + p3) * (3.0f * s * s));
+    return tangent.GetNormalized();
+}
+
+/// <summary>
+/// Which control point a segment starts at, and how far along the segment t is
+/// </summary>
+void CameraPath::segment(float t, size_t& first, float& local) const
+{
+    float wrapped = t - std::floor(t);
+    float scaled = wrapped * points.size();
+    first = (size_t)scaled % points.size();
+    local = scaled - std::floor(scaled);
+}
@@ -0,0 +1,28 @@
+/**
+*
+* Closed Catmull-Rom spline for moving the camera along the same path every run.
+* Used by the headless benchmark, so frame times of different builds are measured on the same views.
+*
+**/
+
+#pragma once
+
+#include <vector>
+#include "../CyCodeBase/cyVector.h"
+
+class CameraPath
+{
+public:
+	static CameraPath loop(const cy::Vec3f& center, float radius, float height, unsigned int points);
+
+	void addPoint(const cy::Vec3f& point);
+	size_t pointCount() const;
+
+	cy::Vec3f position(float t) const;
+	cy::Vec3f direction(float t) const;
+
+private:
+	void segment(float t, size_t& first, float& local) const;
+
+	std::vector<cy::Vec3f> points;	// control points, the last one joins the first
+};
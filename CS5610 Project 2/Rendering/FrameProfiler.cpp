@@ -0,0 +1,244 @@
+/**
+*
+* CPU and GPU timing of the parts of a frame.
+* Every section is timed on the CPU, and sections that issue GL work also with a GL_TIME_ELAPSED query.
+* Queries alternate between two sets, a frame reads the set of the frame before, so the profiler never waits on the GPU.
+*
+**/
+
+#include "FrameProfiler.h"
+#include "../CyCodeBase/cyGL.h"
+
+#include <algorithm>
+#include <iostream>
+#include <iomanip>
+
+/// <summary>
+/// The profiler starts off, GL queries are created by the first setEnabled(true)
+/// </summary>
+/// <param name="window">samples per timer the statistics are taken over</param>
+/// <param name="reportInterval">frames between two reports on std::cout while enabled, 0 never reports</param>
+FrameProfiler::FrameProfiler(size_t window, unsigned int reportInterval)
+{
+    this->window = std::max<size_t>(window, 1);
+    this->reportInterval = reportInterval;
+    on = false;
+    queriesCreated = false;
+    frame = 0;
+}
+
+/// <summary>
+/// Free the GL queries. A global profiler is destroyed after the context is gone, its queries went with it.
+/// </summary>
+FrameProfiler::~FrameProfiler()
+{
+    if (cy::GL::CheckContext()) { deleteQueries(); }
+}
+
+/// <summary>
+/// Add a timer, sections are meant to be added once at startup
+/// </summary>
+/// <param name="name">printed and written to the CSV file</param>
+/// <param name="gpu">whether to time the GL commands of the section as well, sections with GPU timing must not overlap</param>
+/// <returns>the section's index for begin() and end()</returns>
+unsigned int FrameProfiler::addSection(const char* name, bool gpu)
+{
+    Section section;
+    section.name = name;
+    section.gpu = gpu;
+    section.queries[0] = section.queries[1] = 0;
+    section.issued[0] = section.issued[1] = false;
+    section.cpu.values.resize(window);
+    section.gpuTimes.values.resize(window);
+    sections.push_back(section);
+    if (queriesCreated) { createQueries(); }
+    return (unsigned int)(sections.size() - 1);
+}
+
+/// <summary>
+/// Switch timing on or off. Needs a current GL context.
+/// </summary>
+/// <param name="on">false prints the statistics gathered so far and closes the CSV file</param>
+/// <param name="csvPath">when switching on, a file to write every sample to, empty writes none</param>
+void FrameProfiler::setEnabled(bool on, const std::string& csvPath)
+{
+    if (on == this->on) { return; }
+    this->on = on;
+    if (on) {
+        createQueries();
+        for (Section& section : sections) {
+            section.issued[0] = section.issued[1] = false;
+            section.cpu.next = section.cpu.count = 0;
+            section.gpuTimes.next = section.gpuTimes.count = 0;
+        }
+        if (!csvPath.empty()) {
+            csv.open(csvPath);
+            if (csv) { csv << "frame,section,clock,milliseconds\n"; }
+            else { std::cerr << "Could not write " << csvPath << std::endl; }
+        }
+    }
+    else {
+        printStats(std::cout);
+        if (csv.is_open()) { csv.close(); }
+    }
+}
+
+/// <summary>
+/// Whether the profiler is timing
+/// </summary>
+bool FrameProfiler::enabled() const
+{
+    return on;
+}
+
+/// <summary>
+/// Start timing a section
+/// </summary>
+void FrameProfiler::begin(unsigned int section)
+{
+    if (!on) { return; }
+    Section& s = sections[section];
+    if (s.gpu) { glBeginQuery(GL_TIME_ELAPSED, s.queries[frame & 1]); }
+    s.start = Clock::now();
+}
+
+/// <summary>
+/// Stop timing a section. The CPU time is recorded now, the GPU time by the endFrame() of the next frame.
+/// </summary>
+void FrameProfiler::end(unsigned int section)
+{
+    if (!on) { return; }
+    Section& s = sections[section];
+    double milliseconds = std::chrono::duration<double, std::milli>(Clock::now() - s.start).count();
+    if (s.gpu) {
+        glEndQuery(GL_TIME_ELAPSED);
+        s.issued[frame & 1] = true;
+    }
+    addSample(s.cpu, milliseconds);
+    if (csv.is_open()) { csv << frame << ',' << s.name << ",cpu," << milliseconds << '\n'; }
+}
+
+/// <summary>
+/// Close the frame: read the GPU times of the frame before, if the GPU has finished them, and switch query sets.
+/// A result that is not available yet is dropped rather than waited for.
+/// </summary>
+void FrameProfiler::endFrame()
+{
+    if (!on) { return; }
+    unsigned int previous = (frame + 1) & 1;
+    for (Section& s : sections) {
+        if (!s.issued[previous]) { continue; }
+        s.issued[previous] = false;
+        GLint available = GL_FALSE;
+        glGetQueryObjectiv(s.queries[previous], GL_QUERY_RESULT_AVAILABLE, &available);
+        if (!available) { continue; }
+        GLuint64 nanoseconds = 0;
+        glGetQueryObjectui64v(s.queries[previous], GL_QUERY_RESULT, &nanoseconds);
+        double milliseconds = nanoseconds * 1e-6;
+        addSample(s.gpuTimes, milliseconds);
+        if (csv.is_open()) { csv << frame - 1 << ',' << s.name << ",gpu," << milliseconds << '\n'; }
+    }
+
+    frame++;
+    if (reportInterval != 0 && frame % reportInterval == 0) { printStats(std::cout); }
+}
+
+/// <summary>
+/// Minimum, average and 99th percentile of the CPU times in the window
+/// </summary>
+TimingStats FrameProfiler::cpuStats(unsigned int section) const
+{
+    return stats(sections[section].cpu);
+}
+
+/// <summary>
+/// Minimum, average and 99th percentile of the GPU times in the window, empty for sections without GPU timing
+/// </summary>
+TimingStats FrameProfiler::gpuStats(unsigned int section) const
+{
+    return stats(sections[section].gpuTimes);
+}
+
+/// <summary>
+/// One line per section with its CPU and GPU statistics
+/// </summary>
+void FrameProfiler::printStats(std::ostream& out) const
+{
+    std::ios flags(nullptr);
+    flags.copyfmt(out);
+    out << std::fixed << std::setprecision(3);
+    out << "Frame timings in ms, min / avg / p99 over up to " << window << " frames" << std::endl;
+    for (unsigned int i = 0; i < sections.size(); i++) {
+        TimingStats cpu = cpuStats(i);
+        // e.g. the wire pass while the wire mesh is off
+        if (cpu.count == 0) { continue; }
+        out << "  " << std::left << std::setw(16) << sections[i].name << std::right
+            << " cpu min " << cpu.min << " avg " << cpu.avg << " p99 " << cpu.p99;
+        if (sections[i].gpu) {
+            TimingStats gpu = gpuStats(i);
+            out << " | gpu min " << gpu.min << " avg " << gpu.avg << " p99 " << gpu.p99;
+        }
+        out << std::endl;
+    }
+    out.copyfmt(flags);
+}
+
+/// <summary>
+/// Put a sample into a timer's window, overwriting the oldest one once it is full
+/// </summary>
+void FrameProfiler::addSample(Samples& samples, double milliseconds)
+{
+    samples.values[samples.next] = (float)milliseconds;
+    samples.next = (samples.next + 1) % samples.values.size();
+    samples.count = std::min(samples.count + 1, samples.values.size());
+}
+
+/// <summary>
+/// Statistics of a timer's window, only computed when asked for
+/// </summary>
+TimingStats FrameProfiler::stats(const Samples& samples) const
+{
+    return computeTimingStats(std::vector<float>(samples.values.begin(), samples.values.begin() + samples.count));
+}
+
+/// <summary>
+/// Two queries for every GPU timed section that has none yet
+/// </summary>
+void FrameProfiler::createQueries()
+{
+    queriesCreated = true;
+    for (Section& section : sections) {
+        if (section.gpu && section.queries[0] == 0) { glGenQueries(2, section.queries); }
+    }
+}
+
+/// <summary>
+/// Free every query
+/// </summary>
+void FrameProfiler::deleteQueries()
+{
+    for (Section& section : sections) {
+        if (section.queries[0] != 0) { glDeleteQueries(2, section.queries); }
+        section.queries[0] = section.queries[1] = 0;
+    }
+    queriesCreated = false;
+}
+
+/// <summary>
+/// Minimum, average and 99th percentile of a set of times
+/// </summary>
+/// <param name="milliseconds">the times, in any order</param>
+TimingStats computeTimingStats(std::vector<float> milliseconds)
+{
+    TimingStats result;
+    result.count = milliseconds.size();
+    if (milliseconds.empty()) { return result; }
+
+    std::sort(milliseconds.begin(), milliseconds.end());
+    double sum = 0;
+    for (float value : milliseconds) { sum += value; }
+    result.min = milliseconds.front();
+    result.avg = sum / milliseconds.size();
+    result.p99 = milliseconds[std::min(milliseconds.size() - 1, (size_t)(milliseconds.size() * 0.99))];
+    return result;
+}
@@ -0,0 +1,98 @@
+/**
+*
+* CPU and GPU timing of the parts of a frame.
+* Every section is timed on the CPU, and sections that issue GL work also with a GL_TIME_ELAPSED query.
+* Queries alternate between two sets, a frame reads the set of the frame before, so the profiler never waits on the GPU.
+* When it is off, begin() and end() return right away.
+*
+**/
+
+#pragma once
+
+#include <GL/glew.h>
+#include <vector>
+#include <string>
+#include <fstream>
+#include <chrono>
+
+struct TimingStats
+{
+	double min = 0;		// milliseconds
+	double avg = 0;
+	double p99 = 0;
+	size_t count = 0;	// samples in the window
+};
+
+TimingStats computeTimingStats(std::vector<float> milliseconds);
+
+class FrameProfiler
+{
+public:
+	explicit FrameProfiler(size_t window = 240, unsigned int reportInterval = 240);
+	~FrameProfiler();
+
+	FrameProfiler(const FrameProfiler&) = delete;
+	FrameProfiler& operator=(const FrameProfiler&) = delete;
+
+	unsigned int addSection(const char* name, bool gpu);
+	void setEnabled(bool on, const std::string& csvPath = "");
+	bool enabled() const;
+
+	void begin(unsigned int section);
+	void end(unsigned int section);
+	void endFrame();
+
+	TimingStats cpuStats(unsigned int section) const;
+	TimingStats gpuStats(unsigned int section) const;
+	void printStats(std::ostream& out) const;
+
+private:
+	using Clock = std::chrono::steady_clock;
+
+	// the last window samples of one timer
+	struct Samples
+	{
+		std::vector<float> values;
+		size_t next = 0;
+		size_t count = 0;
+	};
+
+	struct Section
+	{
+		std::string name;
+		bool gpu;
+		GLuint queries[2];			// one per query set
+		bool issued[2];				// the query of the set holds a result not read yet
+		Clock::time_point start;
+		Samples cpu;
+		Samples gpuTimes;
+	};
+
+	void addSample(Samples& samples, double milliseconds);
+	TimingStats stats(const Samples& samples) const;
+	void createQueries();
+	void deleteQueries();
+
+	std::vector<Section> sections;
+	size_t window;
+	unsigned int reportInterval;	// frames between two printStats() to std::cout, 0 never prints
+	bool on;
+	bool queriesCreated;
+	unsigned long long frame;
+	std::ofstream csv;				// frame, section, cpu or gpu, milliseconds
+};
+
+// times one section of a FrameProfiler from construction to the end of the scope
+class ProfileScope
+{
+public:
+	ProfileScope(FrameProfiler& profiler, unsigned int section) : profiler(profiler), section(section) { profiler.begin(section); }
+	~ProfileScope() { profiler.end(section); }
+
+	ProfileScope(const ProfileScope&) = delete;
+	ProfileScope& operator=(const ProfileScope&) = delete;
+
+private:
+	FrameProfiler& profiler;
+	unsigned int section;
+};
@@ -0,0 +1,120 @@
+/**
+*
+* OpenGL context without a window, for running the renderer on machines with no display.
+* Builds without EGL headers (e.g. Windows) compile a create() that always fails, callers fall back to a hidden window.
+*
+**/
+
+#include "HeadlessContext.h"
+
+#include <iostream>
+
+#if __has_include(<EGL/egl.h>)
+#define HEADLESS_EGL
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#endif
+
+/// <summary>
+/// No context until create()
+/// </summary>
+HeadlessContext::HeadlessContext()
+{
+    display = nullptr;
+    context = nullptr;
+}
+
+/// <summary>
+/// Release the context
+/// </summary>
+HeadlessContext::~HeadlessContext()
+{
+    destroy();
+}
+
+/// <summary>
+/// Create a core profile context and make it current on this thread
+/// </summary>
+/// <param name="majorVersion">OpenGL major version, e.g. 4</param>
+/// <param name="minorVersion">OpenGL minor version, e.g. 5</param>
+/// <returns>false if EGL is missing or no display can give a context of that version</returns>
+bool HeadlessContext::create(int majorVersion, int minorVersion)
+{
+#ifdef HEADLESS_EGL
+    destroy();
+
+    // Mesa's surfaceless platform needs no X or Wayland server, other drivers get the default display
+    EGLDisplay eglDisplay = EGL_NO_DISPLAY;
+    auto getPlatformDisplay = (PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+#ifdef EGL_PLATFORM_SURFACELESS_MESA
+    if (getPlatformDisplay != nullptr) { eglDisplay = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr); }
+#endif
+    if (eglDisplay == EGL_NO_DISPLAY) { eglDisplay = eglGetDisplay(EGL_DEFAULT_DISPLAY); }
+    EGLint major, minor;
+    if (eglDisplay == EGL_NO_DISPLAY || !eglInitialize(eglDisplay, &major, &minor)) {
+        std::cerr << "EGL: no display" << std::endl;
+        return false;
+    }
+    display = eglDisplay;
+
+    if (!eglBindAPI(EGL_OPENGL_API)) {
+        std::cerr << "EGL: no desktop OpenGL" << std::endl;
+        destroy();
+        return false;
+    }
+
+    // there is never a surface, so any config does, the first one with desktop GL is taken
+    EGLint configAttributes[] = { EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT, EGL_NONE };
+    EGLConfig config = nullptr;
+    EGLint configCount = 0;
+    eglChooseConfig(eglDisplay, configAttributes, &config, 1, &configCount);
+
+    EGLint contextAttributes[] = {
+        EGL_CONTEXT_MAJOR_VERSION, majorVersion,
+        EGL_CONTEXT_MINOR_VERSION, minorVersion,
+        EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+        EGL_NONE
+    };
+    EGLContext eglContext = eglCreateContext(eglDisplay, configCount > 0 ? config : (EGLConfig)nullptr, EGL_NO_CONTEXT, contextAttributes);
+    if (eglContext == EGL_NO_CONTEXT) {
+        std::cerr << "EGL: no OpenGL " << majorVersion << "." << minorVersion << " context" << std::endl;
+        destroy();
+        return false;
+    }
+    context = eglContext;
+
+    if (!eglMakeCurrent(eglDisplay, EGL_NO_SURFACE, EGL_NO_SURFACE, eglContext)) {
+        std::cerr << "EGL: context cannot be made current without a surface" << std::endl;
+        destroy();
+        return false;
+    }
+    return true;
+#else
+    std::cerr << "Headless contexts need EGL, which this build does not have" << std::endl;
+    return false;
+#endif
+}
+
+/// <summary>
+/// Whether create() succeeded and the context has not been destroyed since
+/// </summary>
+bool HeadlessContext::isCurrent() const
+{
+    return context != nullptr;
+}
+
+/// <summary>
+/// Release the context and the display connection
+/// </summary>
+void HeadlessContext::destroy()
+{
+#ifdef HEADLESS_EGL
+    if (display != nullptr) {
+        eglMakeCurrent((EGLDisplay)display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+        if (context != nullptr) { eglDestroyContext((EGLDisplay)display, (EGLContext)context); }
+        eglTerminate((EGLDisplay)display);
+    }
+#endif
+    display = nullptr;
+    context = nullptr;
+}
@@ -0,0 +1,27 @@
+/**
+*
+* OpenGL context without a window, for running the renderer on machines with no display.
+* Uses EGL with Mesa's surfaceless platform when it is available, so it also works with the llvmpipe software rasterizer.
+* Frames have to be drawn into a frame buffer object, there is no default frame buffer.
+*
+**/
+
+#pragma once
+
+class HeadlessContext
+{
+public:
+	HeadlessContext();
+	~HeadlessContext();
+
+	HeadlessContext(const HeadlessContext&) = delete;
+	HeadlessContext& operator=(const HeadlessContext&) = delete;
+
+	bool create(int majorVersion, int minorVersion);
+	bool isCurrent() const;
+	void destroy();
+
+private:
+	void* display;	// EGLDisplay
+	void* context;	// EGLContext
+};
@@ -0,0 +1,143 @@
+/**
+*
+* Decides when the render loop draws a frame.
+* Frames are only drawn after something changed, so a still scene costs no CPU or GPU time,
+* and the frame pacing mode decides how fast frames follow each other while things keep changing.
+*
+**/
+
+#include "RenderScheduler.h"
+
+#include <thread>
+
+/// <summary>
+/// Everything starts dirty, so the first frame is always drawn
+/// </summary>
+/// <param name="pacing">how frames follow each other while the scene changes</param>
+/// <param name="targetFps">frame rate of FramePacing::FixedRate</param>
+RenderScheduler::RenderScheduler(FramePacing pacing, double targetFps)
+{
+    dirty = Camera | Settings | Window;
+    frames = 0;
+    lastFrameTime = 0;
+    setPacing(pacing, targetFps);
+}
+
+/// <summary>
+/// Switch the pacing mode, the next frame starts a new FixedRate grid
+/// </summary>
+void RenderScheduler::setPacing(FramePacing pacing, double targetFps)
+{
+    mode = pacing;
+    fps = targetFps > 0 ? targetFps : 60.0;
+    period = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / fps));
+    nextFrame = Clock::now();
+    lastFrameEnd = Clock::time_point();
+}
+
+/// <summary>
+/// Current pacing mode
+/// </summary>
+FramePacing RenderScheduler::pacing() const
+{
+    return mode;
+}
+
+/// <summary>
+/// Frame rate of FramePacing::FixedRate
+/// </summary>
+double RenderScheduler::targetFps() const
+{
+    return fps;
+}
+
+/// <summary>
+/// Swap interval the window should use for the current mode, 1 waits for the display refresh
+/// </summary>
+int RenderScheduler::swapInterval() const
+{
+    return mode == FramePacing::VSync ? 1 : 0;
+}
+
+/// <summary>
+/// Note that the next frame has to be drawn. Called by the input callbacks, and by the frame itself
+/// while it is not finished yet, e.g. while terrain tiles are streaming in.
+/// </summary>
+/// <param name="changes">RenderScheduler::Change bits</param>
+void RenderScheduler::markDirty(unsigned int changes)
+{
+    dirty |= changes;
+}
+
+/// <summary>
+/// Whether anything changed since the last beginFrame()
+/// </summary>
+bool RenderScheduler::isDirty() const
+{
+    return dirty != 0;
+}
+
+/// <summary>
+/// Start a frame. With FramePacing::FixedRate this sleeps until the frame's slot. The GLUT callbacks run on the
+/// same thread, so input arriving meanwhile is handled after the sleep and goes into the next frame, not this one.
+/// A frame that is late starts a new grid instead of rushing to catch up.
+/// </summary>
+/// <returns>the Change bits since the last frame, which are cleared</returns>
+unsigned int RenderScheduler::beginFrame()
+{
+    if (mode == FramePacing::FixedRate) {
+        Clock::time_point now = Clock::now();
+        if (nextFrame < now) { nextFrame = now; }
+        // the OS wakes sleeping threads late by up to a timer tick, so the last two milliseconds are spent yielding
+        Clock::time_point wake = nextFrame - std::chrono::milliseconds(2);
+        if (now < wake) { std::this_thread::sleep_until(wake); }
+        while (Clock::now() < nextFrame) { std::this_thread::yield(); }
+        nextFrame += period;
+    }
+
+    unsigned int changes = dirty;
+    dirty = 0;
+    return changes;
+}
+
+/// <summary>
+/// Finish a frame after the buffer swap
+/// </summary>
+void RenderScheduler::endFrame()
+{
+    Clock::time_point now = Clock::now();
+    if (lastFrameEnd != Clock::time_point()) {
+        lastFrameTime = std::chrono::duration<double, std::milli>(now - lastFrameEnd).count();
+    }
+    lastFrameEnd = now;
+    frames++;
+}
+
+/// <summary>
+/// Time between the last two frames. Meaningless after the scene was still in between.
+/// </summary>
+double RenderScheduler::lastFrameMilliseconds() const
+{
+    return lastFrameTime;
+}
+
+/// <summary>
+/// Number of frames drawn so far
+/// </summary>
+unsigned long long RenderScheduler::framesDrawn() const
+{
+    return frames;
+}
+
+/// <summary>
+/// Name of a pacing mode for console output
+/// </summary>
+const char* framePacingName(FramePacing pacing)
+{
+    switch (pacing) {
+    case FramePacing::Uncapped: return "uncapped";
+    case FramePacing::VSync: return "vsync";
+    case FramePacing::FixedRate: return "fixed rate";
+    }
+    return "unknown";
+}
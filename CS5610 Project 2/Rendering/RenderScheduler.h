@@ -0,0 +1,60 @@
+/**
+*
+* Decides when the render loop draws a frame.
+* Frames are only drawn after something changed, so a still scene costs no CPU or GPU time,
+* and the frame pacing mode decides how fast frames follow each other while things keep changing.
+*
+**/
+
+#pragma once
+
+#include <chrono>
+
+enum class FramePacing
+{
+	Uncapped,	// the next frame as soon as the last one is done
+	VSync,		// like Uncapped, but the buffer swap waits for the display refresh
+	FixedRate,	// frames start on a steady targetFps grid, the render thread sleeps in between
+};
+
+class RenderScheduler
+{
+public:
+	// what changed since the last frame
+	enum Change : unsigned int
+	{
+		Camera = 1 << 0,		// position or orientation
+		Settings = 1 << 1,		// toggles and tessellation level
+		Window = 1 << 2,		// size or first frame
+		Streaming = 1 << 3,		// terrain tiles are still arriving
+	};
+
+	explicit RenderScheduler(FramePacing pacing = FramePacing::VSync, double targetFps = 60.0);
+
+	void setPacing(FramePacing pacing, double targetFps);
+	FramePacing pacing() const;
+	double targetFps() const;
+	int swapInterval() const;
+
+	void markDirty(unsigned int changes);
+	bool isDirty() const;
+	unsigned int beginFrame();
+	void endFrame();
+
+	double lastFrameMilliseconds() const;
+	unsigned long long framesDrawn() const;
+
+private:
+	using Clock = std::chrono::steady_clock;
+
+	FramePacing mode;
+	double fps;
+	Clock::duration period;		// FixedRate only, time between frame starts
+	Clock::time_point nextFrame;
+	Clock::time_point lastFrameEnd;
+	double lastFrameTime;		// milliseconds between the last two endFrame() calls
+	unsigned int dirty;
+	unsigned long long frames;
+};
+
+const char* framePacingName(FramePacing pacing);
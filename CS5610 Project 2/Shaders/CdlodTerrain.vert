@@ -0,0 +1,81 @@
+// CDLOD counterpart of HeightmapTerrain.vert, see Terrain/CdlodTerrain.cpp
+// every node draws the same grid patch, placed and scaled by the per node attributes,
+// vertices morph onto the next coarser grid towards the end of the node's LOD range
+
+#version 410 core
+
+layout (location = 0) in vec2 GridPos_VS_in;	// (column, row) of the vertex in the shared patch
+layout (location = 1) in vec3 Node_VS_in;		// per node: grid (column, row) of the node corner, grid quads per patch quad (2^level)
+layout (location = 2) in vec2 MorphRange_VS_in;	// per node: camera distance where morphing starts and where the vertex reaches the coarser grid
+
+uniform sampler2D heightMap;	// R16, one texel per grid vertex, rows along z, linear filtering
+uniform float gridSpacing;
+uniform float heightOffset;
+uniform float heightScale;
+uniform float maxHeight;
+uniform vec3 cameraLocal;		// camera position before the model matrix
+
+out vec3 WorldPos_CS_in;
+out vec3 Normal_CS_in;
+out vec4 Color_CS_in;
+out vec2 TexCoord_CS_in;
+
+// same order and colours as TerrainMaterial / Mesh::materialColor()
+const vec4 materialColors[4] = vec4[4](
+    vec4(0.0, 0.0, 1.0, 1.0),           // water
+    vec4(0.7578, 0.6953, 0.5, 1.0),     // sand
+    vec4(0.0, 1.0, 0.0, 1.0),           // grass
+    vec4(0.5, 0.5, 0.5, 1.0)            // stone
+);
+
+// bilinear height at a fractional grid position, clamped to the map
+float quantizedHeight(vec2 grid)
+{
+    vec2 size = vec2(textureSize(heightMap, 0));
+    return texture(heightMap, (grid + 0.5) / size).r * 65535.0;
+}
+
+float worldHeight(vec2 grid)
+{
+    return heightOffset + quantizedHeight(grid) * heightScale;
+}
+
+void main()
+{
+    vec2 nodeOrigin = Node_VS_in.xy;
+    float nodeScale = Node_VS_in.z;
+    vec2 morphRange = MorphRange_VS_in;
+    vec2 lastVertex = vec2(textureSize(heightMap, 0) - 1);
+    vec2 grid = min(nodeOrigin + GridPos_VS_in * nodeScale, lastVertex);
+
+    // morph factor from the distance to the unmorphed vertex
+    vec3 unmorphed = vec3(grid.x * gridSpacing, worldHeight(grid), grid.y * gridSpacing);
+    float morph = clamp((distance(cameraLocal, unmorphed) - morphRange.x) / max(morphRange.y - morphRange.x, 1e-6), 0.0, 1.0);
+
+    // odd vertices slide onto their even neighbour, at morph = 1 the patch is the next coarser grid
+    vec2 odd = fract(GridPos_VS_in * 0.5) * 2.0;
+    grid = min(nodeOrigin + (GridPos_VS_in - odd * morph) * nodeScale, lastVertex);
+
+    float height = worldHeight(grid);
+    WorldPos_CS_in = vec3(grid.x * gridSpacing, height, grid.y * gridSpacing);
+    TexCoord_CS_in = vec2(0.0);
+
+    // lakes were flattened to the lake level, which is a quantized height of 0
+    if (quantizedHeight(grid) < 0.5)
+    {
+        Normal_CS_in = vec3(0.0, 1.0, 0.0);
+        Color_CS_in = materialColors[0];
+        return;
+    }
+
+    // central differences one texel apart, the same normal at every level
+    float left = worldHeight(grid - vec2(1.0, 0.0));
+    float right = worldHeight(grid + vec2(1.0, 0.0));
+    float back = worldHeight(grid - vec2(0.0, 1.0));
+    float front = worldHeight(grid + vec2(0.0, 1.0));
+    Normal_CS_in = normalize(vec3(left - right, 2.0 * gridSpacing, back - front));
+
+    if (height < 0.4 * maxHeight) { Color_CS_in = materialColors[1]; }
+    else if (height < 0.6 * maxHeight) { Color_CS_in = materialColors[2]; }
+    else { Color_CS_in = materialColors[3]; }
+}
@@ -0,0 +1,71 @@
+// heightmap counterpart of Passthrough.vert for Mesh's Heightmap layout
+// there are no vertex attributes, every vertex is rebuilt from gl_VertexID and the height texture
+
+#version 410 core
+
+uniform mat4 model;
+uniform sampler2D heightMap;	// R16, one texel per grid vertex, rows along z
+uniform float gridSpacing;
+uniform float heightOffset;
+uniform float heightScale;
+uniform float maxHeight;
+
+out vec3 WorldPos_CS_in;
+out vec3 Normal_CS_in;
+out vec4 Color_CS_in;
+out vec2 TexCoord_CS_in;
+
+// same order and colours as TerrainMaterial / Mesh::materialColor()
+const vec4 materialColors[4] = vec4[4](
+    vec4(0.0, 0.0, 1.0, 1.0),           // water
+    vec4(0.7578, 0.6953, 0.5, 1.0),     // sand
+    vec4(0.0, 1.0, 0.0, 1.0),           // grass
+    vec4(0.5, 0.5, 0.5, 1.0)            // stone
+);
+
+// (column, row) offset of the 6 corners of a quad, in the order Mesh::generateVertices() writes its indices
+const ivec2 quadCorners[6] = ivec2[6](
+    ivec2(1, 0), ivec2(0, 1), ivec2(0, 0),     // upper triangle
+    ivec2(1, 0), ivec2(1, 1), ivec2(0, 1)      // lower triangle
+);
+
+float quantizedHeight(ivec2 cell)
+{
+    ivec2 size = textureSize(heightMap, 0);
+    return texelFetch(heightMap, clamp(cell, ivec2(0), size - 1), 0).r * 65535.0;
+}
+
+float worldHeight(ivec2 cell)
+{
+    return heightOffset + quantizedHeight(cell) * heightScale;
+}
+
+void main()
+{
+    int quadsPerRow = textureSize(heightMap, 0).x - 1;
+    int quad = gl_VertexID / 6;
+    ivec2 cell = ivec2(quad % quadsPerRow, quad / quadsPerRow) + quadCorners[gl_VertexID % 6];
+
+    float height = worldHeight(cell);
+    WorldPos_CS_in = vec3(cell.x * gridSpacing, height, cell.y * gridSpacing);
+    TexCoord_CS_in = vec2(0.0);
+
+    // lakes were flattened to the lake level, which is a quantized height of 0
+    if (quantizedHeight(cell) < 0.5)
+    {
+        Normal_CS_in = vec3(0.0, 1.0, 0.0);
+        Color_CS_in = materialColors[0];
+        return;
+    }
+
+    // central differences of the neighbouring heights
+    float left = worldHeight(cell - ivec2(1, 0));
+    float right = worldHeight(cell + ivec2(1, 0));
+    float back = worldHeight(cell - ivec2(0, 1));
+    float front = worldHeight(cell + ivec2(0, 1));
+    Normal_CS_in = normalize(vec3(left - right, 2.0 * gridSpacing, back - front));
+
+    if (height < 0.4 * maxHeight) { Color_CS_in = materialColors[1]; }
+    else if (height < 0.6 * maxHeight) { Color_CS_in = materialColors[2]; }
+    else { Color_CS_in = materialColors[3]; }
+}
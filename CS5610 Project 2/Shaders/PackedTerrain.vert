@@ -0,0 +1,49 @@
+// packed counterpart of Passthrough.vert for Mesh's PackedTerrainVertex layout
+
+#version 410 core
+
+layout (location = 0) in vec3 GridPos_VS_in;	// column, quantized height, row
+layout (location = 1) in vec2 Normal_VS_in;		// octahedral encoded normal
+layout (location = 2) in uint Material_VS_in;
+layout (location = 3) in vec2 ChunkOrigin_VS_in;	// grid column and row of the tile's first vertex, per draw from ChunkManager, 0 for the single map
+
+uniform mat4 model;
+uniform float gridSpacing;
+uniform float heightOffset;
+uniform float heightScale;
+
+out vec3 WorldPos_CS_in;
+out vec3 Normal_CS_in;
+out vec4 Color_CS_in;
+out vec2 TexCoord_CS_in;
+
+// same order and colours as TerrainMaterial / Mesh::materialColor()
+const vec4 materialColors[4] = vec4[4](
+    vec4(0.0, 0.0, 1.0, 1.0),           // water
+    vec4(0.7578, 0.6953, 0.5, 1.0),     // sand
+    vec4(0.0, 1.0, 0.0, 1.0),           // grass
+    vec4(0.5, 0.5, 0.5, 1.0)            // stone
+);
+
+// inverse of encodeOctahedral() in Mesh.cpp, the octahedron is folded along y
+vec3 decodeOctahedral(vec2 e)
+{
+    vec3 n = vec3(e.x, 1.0 - abs(e.x) - abs(e.y), e.y);
+    if (n.y < 0.0)
+    {
+        vec2 signs = vec2(n.x >= 0.0 ? 1.0 : -1.0, n.z >= 0.0 ? 1.0 : -1.0);
+        n.xz = (1.0 - abs(n.zx)) * signs;
+    }
+    return normalize(n);
+}
+
+void main()
+{
+    vec2 grid = GridPos_VS_in.xz + ChunkOrigin_VS_in;
+    WorldPos_CS_in = vec3(grid.x * gridSpacing,
+        heightOffset + GridPos_VS_in.y * heightScale,
+        grid.y * gridSpacing);
+    Normal_CS_in = decodeOctahedral(Normal_VS_in);
+    TexCoord_CS_in = vec2(0.0);
+    Color_CS_in = materialColors[min(Material_VS_in, 3u)];
+}
@@ -15,7 +15,18 @@ vec2 normCoord = vec2(TexCoord_FS_in.x, TexCoord_FS_in.y);
 
 // uniform vec3 objColor;
 // uniform vec3 lightColor;
-uniform vec3 lightPos;
+
+// camera and light of the frame, one uniform buffer shared by every program, see FrameUniforms in Main.cpp
+// the declaration has to be the same in every stage
+layout (std140) uniform FrameUniforms
+{
+	mat4 view;
+	mat4 projection;
+	vec3 viewPos;			// camera position, world space
+	float viewportHeight;	// pixels
+	vec3 lightPos;
+};
+
 uniform vec3 camPos;
 uniform float tColor;
 uniform float shading;
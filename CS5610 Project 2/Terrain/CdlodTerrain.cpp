@@ -0,0 +1,309 @@
+/**
+*
+* Continuous distance-based level of detail (CDLOD) for one heightmap terrain.
+* Node selection follows "Continuous Distance-Dependent Level of Detail for Rendering Heightmaps", F. Strugar 2010.
+*
+**/
+
+#include "CdlodTerrain.h"
+
+#include <float.h>
+#include <algorithm>
+#include <iostream>
+
+/// <summary>
+/// No GL objects are created until create()
+/// </summary>
+/// <param name="settings">patch size and LOD ranges</param>
+CdlodTerrain::CdlodTerrain(const CdlodSettings& settings)
+    : settings(settings)
+{
+    vao = 0;
+    vbo = 0;
+    ebo = 0;
+    instanceBuffer = 0;
+    heightTexture = 0;
+    roughnessTexture = 0;
+    quadrantIndexCount = 0;
+    gridSpacing = 0;
+    heightOffset = 0;
+    heightScale = 0;
+    maxHeight = 0;
+}
+
+/// <summary>
+/// Free the patch buffers and the textures
+/// </summary>
+CdlodTerrain::~CdlodTerrain()
+{
+    if (vao != 0) { glDeleteVertexArrays(1, &vao); }
+    if (vbo != 0) { glDeleteBuffers(1, &vbo); }
+    if (ebo != 0) { glDeleteBuffers(1, &ebo); }
+    if (instanceBuffer != 0) { glDeleteBuffers(1, &instanceBuffer); }
+    if (heightTexture != 0) { glDeleteTextures(1, &heightTexture); }
+    if (roughnessTexture != 0) { glDeleteTextures(1, &roughnessTexture); }
+}
+
+/// <summary>
+/// Build the quadtree and upload the height texture and the shared patch. Needs a current GL context.
+/// </summary>
+/// <param name="mesh">terrain generated with TerrainVertexLayout::Heightmap</param>
+/// <param name="w">vertices of the mesh along x</param>
+/// <param name="h">vertices of the mesh along z</param>
+void CdlodTerrain::create(const Mesh& mesh, unsigned int w, unsigned int h)
+{
+    if (mesh.getVertexLayout() != TerrainVertexLayout::Heightmap) {
+        std::cerr << "CdlodTerrain needs a mesh generated with the heightmap layout" << std::endl;
+        return;
+    }
+    std::span<const unsigned short> heights = mesh.viewHeightmap();
+    gridSpacing = mesh.getSpacing();
+    heightOffset = mesh.getPackedHeightOffset();
+    heightScale = mesh.getPackedHeightScale();
+    maxHeight = mesh.getMaxHeight();
+
+    quadtree.build(w, h, settings.patchQuads, [&](unsigned int x, unsigned int z) {
+        return heightOffset + heights[z * w + x] * heightScale;
+    });
+
+    // the top level has no coarser level to morph into and covers the whole map
+    lodRanges.resize(quadtree.levelCount());
+    for (unsigned int level = 0; level < lodRanges.size(); level++) {
+        lodRanges[level] = settings.lodRange * (float)(1u << level);
+    }
+    lodRanges.back() = FLT_MAX;
+
+    // linear filtering, morphing vertices sit between texels
+    glGenTextures(1, &heightTexture);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, heightTexture);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 2);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_R16, w, h, 0, GL_RED, GL_UNSIGNED_SHORT, heights.data());
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+    glGenTextures(1, &roughnessTexture);
+    glActiveTexture(GL_TEXTURE1);
+    glBindTexture(GL_TEXTURE_2D, roughnessTexture);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_R32F, quadtree.nodesX(0), quadtree.nodesZ(0), 0, GL_RED, GL_FLOAT, quadtree.roughnesses());
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glActiveTexture(GL_TEXTURE0);
+
+    // the patch is a grid of (column, row) vertex positions, scaled and moved per node by the shader
+    unsigned int size = settings.patchQuads + 1;
+    std::vector<float> gridPositions;
+    gridPositions.reserve(size * size * 2);
+    for (unsigned int r = 0; r < size; r++) {
+        for (unsigned int c = 0; c < size; c++) {
+            gridPositions.push_back((float)c);
+            gridPositions.push_back((float)r);
+        }
+    }
+
+    // indices quarter by quarter, so a node can draw any of its quarters with one contiguous range
+    // the two triangles of a quad are wound like Mesh::writeGridIndices()
+    unsigned int half = settings.patchQuads / 2;
+    std::vector<unsigned int> indices;
+    indices.reserve(settings.patchQuads * settings.patchQuads * 6);
+    for (unsigned int quadrant = 0; quadrant < 4; quadrant++) {
+        unsigned int rowBegin = (quadrant >> 1) * half;
+        unsigned int colBegin = (quadrant & 1) * half;
+        for (unsigned int r = rowBegin; r < rowBegin + half; r++) {
+            for (unsigned int c = colBegin; c < colBegin + half; c++) {
+                indices.push_back((r * size) + c + 1);
+                indices.push_back(((r + 1) * size) + c);
+                indices.push_back((r * size) + c);
+                indices.push_back((r * size) + c + 1);
+                indices.push_back(((r + 1) * size) + c + 1);
+                indices.push_back(((r + 1) * size) + c);
+            }
+        }
+    }
+    quadrantIndexCount = indices.size() / 4;
+
+    glGenVertexArrays(1, &vao);
+    glBindVertexArray(vao);
+    glGenBuffers(1, &vbo);
+    glBindBuffer(GL_ARRAY_BUFFER, vbo);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(float) * gridPositions.size(), &gridPositions[0], GL_STATIC_DRAW);
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 0, (GLvoid*)0);
+    glEnableVertexAttribArray(0);
+    // node placement, one element per draw command, picked by its base instance
+    GLsizei stride = sizeof(float) * 5;
+    glGenBuffers(1, &instanceBuffer);
+    glBindBuffer(GL_ARRAY_BUFFER, instanceBuffer);
+    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, stride, (GLvoid*)0);
+    glVertexAttribDivisor(1, 1);
+    glEnableVertexAttribArray(1);
+    glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, stride, (GLvoid*)(sizeof(float) * 3));
+    glVertexAttribDivisor(2, 1);
+    glEnableVertexAttribArray(2);
+    glGenBuffers(1, &ebo);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(unsigned int) * indices.size(), &indices[0], GL_STATIC_DRAW);
+    glBindVertexArray(0);
+}
+
+/// <summary>
+/// Pick the nodes to draw this frame. Every part of the map is covered by exactly one selected node or quarter,
+/// and neighbouring nodes are at most one level apart, so the morphing closes every seam.
+/// Nodes outside the frustum are left out. The draw commands for the selection are uploaded here.
+/// </summary>
+/// <param name="camLocal">camera position in terrain space, before the model matrix</param>
+/// <param name="frustum">view frustum in terrain space</param>
+void CdlodTerrain::select(const cy::Vec3f& camLocal, const Frustum& frustum)
+{
+    camera = camLocal;
+    view = frustum;
+    selection.clear();
+    if (quadtree.levelCount() == 0) { return; }
+
+    unsigned int top = quadtree.levelCount() - 1;
+    for (unsigned int z = 0; z < quadtree.nodesZ(top); z++) {
+        for (unsigned int x = 0; x < quadtree.nodesX(top); x++) {
+            selectNode(top, x, z);
+        }
+    }
+
+    instances.clear();
+    drawList.clear();
+    for (const SelectedNode& node : selection) {
+        unsigned int nodeQuads = quadtree.nodeQuads(node.level);
+        unsigned int instance = (unsigned int)(instances.size() / 5);
+        instances.push_back((float)(node.x * nodeQuads));
+        instances.push_back((float)(node.z * nodeQuads));
+        instances.push_back((float)(nodeQuads / settings.patchQuads));
+
+        // morph over the last part of the level's range, the top level never morphs
+        float rangeEnd = lodRanges[node.level];
+        float rangeBegin = node.level > 0 ? lodRanges[node.level - 1] : 0.0f;
+        instances.push_back(rangeEnd == FLT_MAX ? FLT_MAX : rangeBegin + (rangeEnd - rangeBegin) * settings.morphStart);
+        instances.push_back(rangeEnd);
+
+        // consecutive quarters are one command
+        for (unsigned int quadrant = 0; quadrant < 4; ) {
+            if (!(node.quadrants & (1 << quadrant))) { quadrant++; continue; }
+            unsigned int first = quadrant;
+            while (quadrant < 4 && (node.quadrants & (1 << quadrant))) { quadrant++; }
+            drawList.add((GLuint)((quadrant - first) * quadrantIndexCount), (GLuint)(first * quadrantIndexCount), 0, instance);
+        }
+    }
+    drawList.upload();
+    glBindBuffer(GL_ARRAY_BUFFER, instanceBuffer);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(float) * instances.size(), instances.empty() ? nullptr : &instances[0], GL_STREAM_DRAW);
+}
+
+/// <summary>
+/// Recursive part of select()
+/// </summary>
+/// <returns>false if the node is out of its level's range, the parent then draws this area itself</returns>
+bool CdlodTerrain::selectNode(unsigned int level, unsigned int x, unsigned int z)
+{
+    if (!nodeInRange(level, x, z, lodRanges[level])) { return false; }
+    // out of view counts as handled, so the parent does not draw the area either
+    if (!nodeVisible(level, x, z)) { return true; }
+
+    // finest level, or the next finer level's range does not reach the node
+    if (level == 0 || !nodeInRange(level, x, z, lodRanges[level - 1])) {
+        selection.push_back({ level, x, z, 0xF });
+        return true;
+    }
+
+    // children out of their range are drawn as quarters of this node
+    unsigned char quadrants = 0;
+    for (unsigned int quadrant = 0; quadrant < 4; quadrant++) {
+        unsigned int childX = 2 * x + (quadrant & 1);
+        unsigned int childZ = 2 * z + (quadrant >> 1);
+        // children past the map edge only cover area outside the map
+        if (childX >= quadtree.nodesX(level - 1) || childZ >= quadtree.nodesZ(level - 1)) { continue; }
+        if (!selectNode(level - 1, childX, childZ)) { quadrants |= 1 << quadrant; }
+    }
+    if (quadrants != 0) { selection.push_back({ level, x, z, quadrants }); }
+    return true;
+}
+
+/// <summary>
+/// Whether the bounding box of a node is closer to the camera than range
+/// </summary>
+bool CdlodTerrain::nodeInRange(unsigned int level, unsigned int x, unsigned int z, float range) const
+{
+    if (range == FLT_MAX) { return true; }
+    float nodeSize = quadtree.nodeQuads(level) * gridSpacing;
+    float minX = x * nodeSize;
+    float minZ = z * nodeSize;
+    float dx = std::max(std::max(minX - camera.x, camera.x - (minX + nodeSize)), 0.0f);
+    float dz = std::max(std::max(minZ - camera.z, camera.z - (minZ + nodeSize)), 0.0f);
+    float dy = std::max(std::max(quadtree.minHeight(level, x, z) - camera.y, camera.y - quadtree.maxHeight(level, x, z)), 0.0f);
+    return dx * dx + dy * dy + dz * dz <= range * range;
+}
+
+/// <summary>
+/// Whether the bounding box of a node is at least partly inside the frustum of the last select()
+/// </summary>
+bool CdlodTerrain::nodeVisible(unsigned int level, unsigned int x, unsigned int z) const
+{
+    unsigned int nodeQuads = quadtree.nodeQuads(level);
+    cy::Vec3f boxMin((float)(x * nodeQuads) * gridSpacing, quadtree.minHeight(level, x, z), (float)(z * nodeQuads) * gridSpacing);
+    cy::Vec3f boxMax((float)((x + 1) * nodeQuads) * gridSpacing, quadtree.maxHeight(level, x, z), (float)((z + 1) * nodeQuads) * gridSpacing);
+    return view.intersects(boxMin, boxMax);
+}
+
+/// <summary>
+/// Draw the nodes of the last select() as patches with one indirect draw. Sets the uniforms of Shaders/CdlodTerrain.vert and the
+/// patch roughness of Shaders/shader.tessc, the height texture is bound to texture unit 0 and the roughness to unit 1.
+/// </summary>
+/// <param name="program">shader program built with Shaders/CdlodTerrain.vert</param>
+void CdlodTerrain::draw(cy::GLSLProgram& program)
+{
+    if (vao == 0) { return; }
+    program.SetUniform("gridSpacing", gridSpacing);
+    program.SetUniform("heightOffset", heightOffset);
+    program.SetUniform("heightScale", heightScale);
+    program.SetUniform("maxHeight", maxHeight);
+    program.SetUniform("cameraLocal", camera.x, camera.y, camera.z);
+    program.SetUniform("heightMap", 0);
+    program.SetUniform("displaceHeights", 1);
+    program.SetUniform("roughnessMap", 1);
+    program.SetUniform("hasRoughnessMap", 1);
+    program.SetUniform("roughnessCellSize", settings.patchQuads * gridSpacing);
+    glActiveTexture(GL_TEXTURE1);
+    glBindTexture(GL_TEXTURE_2D, roughnessTexture);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, heightTexture);
+    glBindVertexArray(vao);
+    drawList.draw(GL_PATCHES);
+}
+
+/// <summary>
+/// Number of nodes picked by the last select()
+/// </summary>
+size_t CdlodTerrain::selectedNodeCount() const
+{
+    return selection.size();
+}
+
+/// <summary>
+/// Triangles drawn by draw() for the last select(), before tessellation
+/// </summary>
+size_t CdlodTerrain::triangleCount() const
+{
+    size_t quarters = 0;
+    for (const SelectedNode& node : selection) {
+        for (unsigned int quadrant = 0; quadrant < 4; quadrant++) {
+            if (node.quadrants & (1 << quadrant)) { quarters++; }
+        }
+    }
+    return quarters * quadrantIndexCount / 3;
+}
+
+/// <summary>
+/// Min/max height quadtree of the terrain, level 0 nodes are the size of one patch
+/// </summary>
+const HeightQuadtree& CdlodTerrain::bounds() const
+{
+    return quadtree;
+}
@@ -0,0 +1,81 @@
+/**
+*
+* Continuous distance-based level of detail (CDLOD) for one heightmap terrain.
+* Every quadtree node is drawn with the same small grid patch, scaled to the node size,
+* so the triangle count depends on the LOD ranges and not on the map size.
+* Vertices morph into the next coarser level towards the end of each range, so levels switch without popping.
+* The selected nodes are drawn with one indirect draw, the node placement is a per instance attribute.
+*
+**/
+
+#pragma once
+
+#include <GL/glew.h>
+#include <vector>
+#include "../CyCodeBase/cyVector.h"
+#include "../CyCodeBase/cyGL.h"
+#include "../Mesh/Mesh.h"
+#include "HeightQuadtree.h"
+#include "Frustum.h"
+#include "IndirectDrawBuffer.h"
+
+struct CdlodSettings
+{
+	unsigned int patchQuads = 32;		// grid quads along one side of the shared patch, a power of two
+	float lodRange = 300.0f;			// distance up to which full resolution nodes are drawn, doubled for every coarser level
+	float morphStart = 0.7f;			// fraction of a level's range after which its vertices start morphing to the next level
+};
+
+class CdlodTerrain
+{
+public:
+	explicit CdlodTerrain(const CdlodSettings& settings = CdlodSettings());
+	~CdlodTerrain();
+
+	CdlodTerrain(const CdlodTerrain&) = delete;
+	CdlodTerrain& operator=(const CdlodTerrain&) = delete;
+
+	void create(const Mesh& mesh, unsigned int w, unsigned int h);
+	void select(const cy::Vec3f& camLocal, const Frustum& frustum);
+	void draw(cy::GLSLProgram& program);
+
+	size_t selectedNodeCount() const;
+	size_t triangleCount() const;
+	const HeightQuadtree& bounds() const;
+
+private:
+	// a node picked by select(), drawn at the resolution of its level
+	struct SelectedNode
+	{
+		unsigned int level;
+		unsigned int x;
+		unsigned int z;
+		unsigned char quadrants;	// bit (2 * qz + qx) set for every quarter of the node that is drawn
+	};
+
+	bool selectNode(unsigned int level, unsigned int x, unsigned int z);
+	bool nodeInRange(unsigned int level, unsigned int x, unsigned int z, float range) const;
+	bool nodeVisible(unsigned int level, unsigned int x, unsigned int z) const;
+
+	CdlodSettings settings;
+	HeightQuadtree quadtree;
+	std::vector<float> lodRanges;		// per level, the distance up to which a node of that level is drawn
+	std::vector<SelectedNode> selection;
+	cy::Vec3f camera;					// terrain space camera of the last select()
+	Frustum view;						// terrain space frustum of the last select()
+
+	GLuint vao;
+	GLuint vbo;
+	GLuint ebo;
+	GLuint instanceBuffer;				// per selected node: origin column and row, scale, morph range start and end
+	GLuint heightTexture;
+	GLuint roughnessTexture;			// HeightQuadtree::roughness() of every patch, for Shaders/shader.tessc
+	size_t quadrantIndexCount;			// indices of one quarter of the patch, the index buffer holds the quarters one after another
+	std::vector<float> instances;
+	IndirectDrawBuffer drawList;		// one command per run of consecutive quarters of a selected node
+
+	float gridSpacing;
+	float heightOffset;
+	float heightScale;
+	float maxHeight;
+};
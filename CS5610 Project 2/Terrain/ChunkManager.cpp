@@ -0,0 +1,328 @@
+/**
+*
+* Streams an endless terrain as square tiles kept resident in a ring around the camera.
+* Tiles are generated on background threads and uploaded on the render thread.
+*
+**/
+
+#include "ChunkManager.h"
+
+#include <math.h>
+#include <stddef.h>
+#include <algorithm>
+#include <iostream>
+
+/// <summary>
+/// Start the generation workers. No tile is requested until the first update().
+/// Needs a current GL context, since the tiles are uploaded and freed from this object.
+/// </summary>
+/// <param name="settings">tile size, ring size and generation parameters</param>
+ChunkManager::ChunkManager(const ChunkSettings& settings)
+    : settings(settings),
+    cache(settings.cacheDirectory),
+    finished((2 * settings.ringRadius + 1) * (2 * settings.ringRadius + 1)),
+    // a pool of one has no workers and would generate the tiles inline in update(), on the render thread
+    pool(std::max(2u, settings.threadCount == 0 ? ThreadPool::defaultThreadCount() : settings.threadCount))
+{
+    // request the tiles closest to the camera first, so the area under it fills in first
+    for (int z = -settings.ringRadius; z <= settings.ringRadius; z++) {
+        for (int x = -settings.ringRadius; x <= settings.ringRadius; x++) {
+            ringOffsets.push_back(cy::Vec2<int>(x, z));
+        }
+    }
+    std::stable_sort(ringOffsets.begin(), ringOffsets.end(), [](const cy::Vec2<int>& a, const cy::Vec2<int>& b) {
+        return a.x * a.x + a.y * a.y < b.x * b.x + b.y * b.y;
+    });
+
+    // one extra ring of tiles stays resident, so moving back and forth over a tile border does not regenerate
+    size_t side = 2 * settings.ringRadius + 3;
+    maxResident = side * side;
+
+    vao = 0;
+    vertexArena = 0;
+    originBuffer = 0;
+    sharedIndexBuffer = 0;
+    tileIndexCount = 0;
+    tileVertexCount = (size_t)settings.tileVertices * settings.tileVertices;
+    for (unsigned int slot = 0; slot < maxResident; slot++) {
+        freeSlots.push_back((unsigned int)(maxResident - 1 - slot));
+    }
+    inFlight = 0;
+    gridSpacing = 0;
+    heightOffset = 0;
+    heightScale = 0;
+    maxHeight = 0;
+    cancelled = false;
+
+    startTime = std::chrono::steady_clock::now();
+    startupReported = false;
+    tilesGenerated = 0;
+    tilesLoaded = 0;
+}
+
+/// <summary>
+/// Drop the tiles that are still queued for generation and free every GPU buffer
+/// </summary>
+ChunkManager::~ChunkManager()
+{
+    // queued jobs still run when the pool is destroyed, this makes them return right away
+    cancelled = true;
+
+    if (vao != 0) { glDeleteVertexArrays(1, &vao); }
+    if (vertexArena != 0) { glDeleteBuffers(1, &vertexArena); }
+    if (originBuffer != 0) { glDeleteBuffers(1, &originBuffer); }
+    if (sharedIndexBuffer != 0) { glDeleteBuffers(1, &sharedIndexBuffer); }
+}
+
+/// <summary>
+/// Key of a tile in the chunk map
+/// </summary>
+long long ChunkManager::tileKey(int tileX, int tileZ)
+{
+    return ((long long)tileX << 32) | (unsigned int)tileZ;
+}
+
+/// <summary>
+/// Keep the ring of tiles around the camera resident. Called once per frame on the render thread.
+/// Uploads at most settings.uploadsPerFrame finished tiles, requests missing tiles from the workers,
+/// and evicts the least recently used tiles once more than the ring plus a margin are resident.
+/// Never waits for a worker, so a frame is never stalled by terrain generation.
+/// Afterwards the resident tiles inside the frustum are written to the draw list of draw().
+/// </summary>
+/// <param name="camPos">world position of the camera</param>
+/// <param name="frustum">view frustum in world space, tiles are placed at their world position</param>
+void ChunkManager::update(const cy::Vec3f& camPos, const Frustum& frustum)
+{
+    // take finished tiles off the queue, tiles evicted while they were generated are dropped
+    std::unique_ptr<ChunkBuild> build;
+    for (unsigned int uploads = 0; uploads < settings.uploadsPerFrame && finished.tryPop(build); ) {
+        inFlight--;
+        auto it = chunks.find(tileKey(build->tileX, build->tileZ));
+        if (it == chunks.end() || it->second.state != ChunkState::Pending) { continue; }
+        uploadTile(it->second, *build);
+        uploads++;
+    }
+
+    if (!startupReported) { reportStartup(); }
+
+    // the camera tile, a tile covers tileVertices - 1 quads
+    float tileSize = (settings.tileVertices - 1) * settings.terrain.spacing;
+    int camTileX = (int)floorf(camPos.x / tileSize);
+    int camTileZ = (int)floorf(camPos.z / tileSize);
+
+    // touch the ring back to front, so the nearest tile ends up most recently used
+    for (auto offset = ringOffsets.rbegin(); offset != ringOffsets.rend(); ++offset) {
+        auto it = chunks.find(tileKey(camTileX + offset->x, camTileZ + offset->y));
+        if (it != chunks.end()) {
+            lruOrder.splice(lruOrder.begin(), lruOrder, it->second.lru);
+        }
+    }
+    // request missing tiles nearest first, as long as the finished queue can take every result
+    for (const cy::Vec2<int>& offset : ringOffsets) {
+        if (inFlight >= finished.capacity()) { break; }
+        int tileX = camTileX + offset.x;
+        int tileZ = camTileZ + offset.y;
+        if (chunks.find(tileKey(tileX, tileZ)) == chunks.end()) { requestTile(tileX, tileZ); }
+    }
+
+    // the tiles at the back of the LRU list are the ones the camera left longest ago
+    while (chunks.size() > maxResident) {
+        evictTile(chunks.find(lruOrder.back()));
+    }
+
+    // one command per visible tile, its slot is the base vertex and its origin the base instance
+    drawList.clear();
+    drawOrigins.clear();
+    if (tileIndexCount == 0) { return; }
+    for (auto& entry : chunks) {
+        Chunk& chunk = entry.second;
+        if (chunk.state != ChunkState::Resident) { continue; }
+        float originX = (float)chunk.tileX * (settings.tileVertices - 1);
+        float originZ = (float)chunk.tileZ * (settings.tileVertices - 1);
+        cy::Vec3f boxMin(originX * gridSpacing, chunk.minHeight, originZ * gridSpacing);
+        cy::Vec3f boxMax((originX + settings.tileVertices - 1) * gridSpacing, chunk.maxHeight, (originZ + settings.tileVertices - 1) * gridSpacing);
+        if (!frustum.intersects(boxMin, boxMax)) { continue; }
+        drawList.add((GLuint)tileIndexCount, 0, (GLint)(chunk.slot * tileVertexCount), (GLuint)(drawOrigins.size() / 2));
+        drawOrigins.push_back(originX);
+        drawOrigins.push_back(originZ);
+    }
+    drawList.upload();
+    glBindBuffer(GL_ARRAY_BUFFER, originBuffer);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(float) * drawOrigins.size(), drawOrigins.empty() ? nullptr : &drawOrigins[0], GL_STREAM_DRAW);
+}
+
+/// <summary>
+/// Draw the visible tiles of the last update() as patches with one indirect draw.
+/// Sets the shared packed vertex uniforms of Shaders/PackedTerrain.vert, the tile origins are a per instance attribute.
+/// </summary>
+/// <param name="program">shader program built with Shaders/PackedTerrain.vert</param>
+void ChunkManager::draw(cy::GLSLProgram& program)
+{
+    if (tileIndexCount == 0) { return; }
+    program.SetUniform("gridSpacing", gridSpacing);
+    program.SetUniform("heightOffset", heightOffset);
+    program.SetUniform("heightScale", heightScale);
+    program.SetUniform("maxHeight", maxHeight);
+
+    glBindVertexArray(vao);
+    drawList.draw(GL_PATCHES);
+}
+
+/// <summary>
+/// Number of tiles uploaded to the GPU
+/// </summary>
+size_t ChunkManager::residentCount() const
+{
+    size_t count = 0;
+    for (auto& entry : chunks) {
+        if (entry.second.state == ChunkState::Resident) { count++; }
+    }
+    return count;
+}
+
+/// <summary>
+/// Number of tiles waiting for a worker or for their upload
+/// </summary>
+size_t ChunkManager::pendingCount() const
+{
+    return chunks.size() - residentCount();
+}
+
+/// <summary>
+/// Add a pending tile and queue its generation on a worker
+/// </summary>
+void ChunkManager::requestTile(int tileX, int tileZ)
+{
+    lruOrder.push_front(tileKey(tileX, tileZ));
+    Chunk chunk = { tileX, tileZ, ChunkState::Pending, 0, lruOrder.begin(), 0, 0 };
+    chunks.emplace(tileKey(tileX, tileZ), chunk);
+    inFlight++;
+
+    ChunkSettings tileSettings = settings;
+    pool.submit([this, tileSettings, tileX, tileZ]() {
+        if (cancelled) { return; }
+        std::unique_ptr<ChunkBuild> build(new ChunkBuild);
+        build->tileX = tileX;
+        build->tileZ = tileZ;
+
+        // every tile samples the same noise field with the same reference height, so borders match
+        unsigned int size = tileSettings.tileVertices;
+        TerrainParams params = tileSettings.terrain;
+        params.originX = tileX * (int)(size - 1);
+        params.originZ = tileZ * (int)(size - 1);
+
+        uint64_t key = TileCache::tileKey(params, size, size, TerrainVertexLayout::Packed);
+        if (cache.load(key, size, size, TerrainVertexLayout::Packed, build->cached)) {
+            const TileCacheHeader& header = build->cached.header();
+            build->vertices = build->cached.vertices();
+            build->spacing = header.spacing;
+            build->heightOffset = header.heightOffset;
+            build->heightScale = header.heightScale;
+            build->maxHeight = header.maxHeight;
+            tilesLoaded++;
+        }
+        else {
+            build->mesh.setVertexLayout(TerrainVertexLayout::Packed);
+            // tiles already run in parallel on pool, so each one stays on its worker (a pool of 1 starts no threads)
+            build->mesh.generateRegion(size, size, params, 1);
+            cache.store(key, build->mesh, size, size);
+            build->vertices = build->mesh.viewPackedVertices();
+            build->spacing = build->mesh.getSpacing();
+            build->heightOffset = build->mesh.getPackedHeightOffset();
+            build->heightScale = build->mesh.getPackedHeightScale();
+            build->maxHeight = build->mesh.getMaxHeight();
+            tilesGenerated++;
+        }
+
+        // update() never has more tiles in flight than the queue holds, so this does not spin
+        while (!finished.tryPush(std::move(build))) { std::this_thread::yield(); }
+    });
+}
+
+/// <summary>
+/// Copy a finished tile into a free slot of the vertex arena, the index buffer is shared by every tile
+/// </summary>
+void ChunkManager::uploadTile(Chunk& chunk, ChunkBuild& build)
+{
+    std::span<const PackedTerrainVertex> vertices = build.vertices;
+
+    if (sharedIndexBuffer == 0) {
+        // cached tiles carry no indices, and every tile has the same ones anyway
+        unsigned int size = settings.tileVertices;
+        std::vector<unsigned int> indices((size - 1) * (size - 1) * 6);
+        Mesh::writeGridIndices(size, 0, size - 1, &indices[0]);
+        glGenBuffers(1, &sharedIndexBuffer);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, sharedIndexBuffer);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(unsigned int) * indices.size(), &indices[0], GL_STATIC_DRAW);
+        tileIndexCount = indices.size();
+
+        gridSpacing = build.spacing;
+        heightOffset = build.heightOffset;
+        heightScale = build.heightScale;
+        maxHeight = build.maxHeight;
+    }
+
+    if (vao == 0) {
+        // same attribute setup as the packed path of createSceneTerrain(), over the whole arena
+        // the tile origin comes from originBuffer, one element per draw, picked by the base instance of the draw
+        GLsizei stride = sizeof(PackedTerrainVertex);
+        glGenVertexArrays(1, &vao);
+        glBindVertexArray(vao);
+        glGenBuffers(1, &vertexArena);
+        glBindBuffer(GL_ARRAY_BUFFER, vertexArena);
+        // every upload and reused slot rewrites part of the arena with glBufferSubData()
+        glBufferData(GL_ARRAY_BUFFER, sizeof(PackedTerrainVertex) * tileVertexCount * maxResident, nullptr, GL_DYNAMIC_DRAW);
+        glVertexAttribPointer(0, 3, GL_UNSIGNED_SHORT, GL_FALSE, stride, (GLvoid*)offsetof(PackedTerrainVertex, x));
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(1, 2, GL_BYTE, GL_TRUE, stride, (GLvoid*)offsetof(PackedTerrainVertex, normal));
+        glEnableVertexAttribArray(1);
+        glVertexAttribIPointer(2, 1, GL_UNSIGNED_BYTE, stride, (GLvoid*)offsetof(PackedTerrainVertex, material));
+        glEnableVertexAttribArray(2);
+        glGenBuffers(1, &originBuffer);
+        glBindBuffer(GL_ARRAY_BUFFER, originBuffer);
+        glVertexAttribPointer(3, 2, GL_FLOAT, GL_FALSE, 0, (GLvoid*)0);
+        glVertexAttribDivisor(3, 1);
+        glEnableVertexAttribArray(3);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, sharedIndexBuffer);
+        glBindVertexArray(0);
+    }
+
+    // the box draw() culls the tile with
+    unsigned short lowest = 0xFFFF;
+    unsigned short highest = 0;
+    for (const PackedTerrainVertex& vertex : vertices) {
+        lowest = std::min(lowest, vertex.height);
+        highest = std::max(highest, vertex.height);
+    }
+    chunk.minHeight = build.heightOffset + lowest * build.heightScale;
+    chunk.maxHeight = build.heightOffset + highest * build.heightScale;
+
+    chunk.slot = freeSlots.back();
+    freeSlots.pop_back();
+    glBindBuffer(GL_ARRAY_BUFFER, vertexArena);
+    glBufferSubData(GL_ARRAY_BUFFER, sizeof(PackedTerrainVertex) * tileVertexCount * chunk.slot, vertices.size_bytes(), vertices.data());
+    chunk.state = ChunkState::Resident;
+}
+
+/// <summary>
+/// Forget a tile and hand its GPU slot to the next tile. A pending tile is dropped once its build arrives.
+/// </summary>
+void ChunkManager::evictTile(std::unordered_map<long long, Chunk>::iterator it)
+{
+    if (it->second.state == ChunkState::Resident) { freeSlots.push_back(it->second.slot); }
+    lruOrder.erase(it->second.lru);
+    chunks.erase(it);
+}
+
+/// <summary>
+/// Print how long it took until the first ring around the camera was resident, and how many of its
+/// tiles were generated or loaded from the tile cache, to compare cold and warm starts
+/// </summary>
+void ChunkManager::reportStartup()
+{
+    if (residentCount() < ringOffsets.size()) { return; }
+    startupReported = true;
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTime).count();
+    std::cout << "Terrain ring of " << ringOffsets.size() << " tiles ready in " << ms << " ms ("
+        << tilesGenerated << " generated, " << tilesLoaded << " loaded from cache)" << std::endl;
+}
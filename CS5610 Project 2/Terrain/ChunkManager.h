@@ -0,0 +1,127 @@
+/**
+*
+* Streams an endless terrain as square tiles kept resident in a ring around the camera.
+* Tiles are generated on background threads and uploaded on the render thread.
+* Every resident tile lives in one shared vertex buffer, so all visible tiles are drawn with a single indirect draw.
+*
+**/
+
+#pragma once
+
+#include <GL/glew.h>
+#include <vector>
+#include <list>
+#include <memory>
+#include <atomic>
+#include <unordered_map>
+#include <chrono>
+#include <string>
+#include "../CyCodeBase/cyVector.h"
+#include "../CyCodeBase/cyGL.h"
+#include "../Mesh/Mesh.h"
+#include "../Threading/ThreadPool.h"
+#include "../Threading/LockFreeQueue.h"
+#include "TileCache.h"
+#include "Frustum.h"
+#include "IndirectDrawBuffer.h"
+
+struct ChunkSettings
+{
+	unsigned int tileVertices = 129;	// vertices along one tile side, neighbouring tiles share their border
+	int ringRadius = 3;					// tiles kept around the camera tile in every direction, N = 2 * radius + 1
+	// noise parameters of every tile, the origin is set per tile
+	// a noise scale of 600 matches the old single map, the fixed reference height keeps the tile borders seamless
+	TerrainParams terrain = { .noiseScale = 600, .referenceHeight = 500 };
+	std::string cacheDirectory = "TileCache";	// where finished tiles are kept between runs, empty disables the cache
+	unsigned int uploadsPerFrame = 2;	// tiles uploaded per update(), the rest wait for the next frame
+	unsigned int threadCount = 0;		// pool size, the render thread counts as one so N - 1 workers generate, 0 = hardware threads, at least 2
+};
+
+class ChunkManager
+{
+public:
+	explicit ChunkManager(const ChunkSettings& settings = ChunkSettings());
+	~ChunkManager();
+
+	ChunkManager(const ChunkManager&) = delete;
+	ChunkManager& operator=(const ChunkManager&) = delete;
+
+	void update(const cy::Vec3f& camPos, const Frustum& frustum);
+	void draw(cy::GLSLProgram& program);
+
+	size_t residentCount() const;
+	size_t pendingCount() const;
+
+private:
+	enum class ChunkState { Pending, Resident };
+
+	struct Chunk
+	{
+		int tileX;
+		int tileZ;
+		ChunkState state;
+		unsigned int slot;		// which tile sized part of the vertex arena the resident tile is in
+		std::list<long long>::iterator lru;
+		float minHeight;		// height range of the resident tile, for frustum culling
+		float maxHeight;
+	};
+
+	// a finished tile on its way from a worker to the render thread
+	// vertices point either into mesh or into the mapped cache file
+	struct ChunkBuild
+	{
+		int tileX;
+		int tileZ;
+		Mesh mesh;
+		CachedTile cached;
+		std::span<const PackedTerrainVertex> vertices;
+		float spacing;
+		float heightOffset;
+		float heightScale;
+		float maxHeight;
+	};
+
+	static long long tileKey(int tileX, int tileZ);
+	void requestTile(int tileX, int tileZ);
+	void uploadTile(Chunk& chunk, ChunkBuild& build);
+	void evictTile(std::unordered_map<long long, Chunk>::iterator it);
+	void reportStartup();
+
+	ChunkSettings settings;
+	std::vector<cy::Vec2<int>> ringOffsets;		// tile offsets of the ring, nearest first
+	size_t maxResident;
+
+	std::unordered_map<long long, Chunk> chunks;
+	std::list<long long> lruOrder;				// front is the most recently used tile
+	// maxResident tile sized slots, recycled between tiles since every tile has the same size
+	GLuint vao;
+	GLuint vertexArena;
+	std::vector<unsigned int> freeSlots;
+	GLuint sharedIndexBuffer;
+	size_t tileIndexCount;
+	size_t tileVertexCount;
+
+	// visible tiles of the last update(), one command each, the tile origin is a per instance attribute
+	IndirectDrawBuffer drawList;
+	std::vector<float> drawOrigins;
+	GLuint originBuffer;
+	size_t inFlight;
+
+	// uniforms shared by every tile, taken from the first finished tile
+	float gridSpacing;
+	float heightOffset;
+	float heightScale;
+	float maxHeight;
+
+	// startup timing, printed once the first ring is resident
+	std::chrono::steady_clock::time_point startTime;
+	bool startupReported;
+	std::atomic<unsigned int> tilesGenerated;
+	std::atomic<unsigned int> tilesLoaded;
+
+	std::atomic<bool> cancelled;
+	TileCache cache;
+	LockFreeQueue<std::unique_ptr<ChunkBuild>> finished;
+	// declared last so it is destroyed first, the workers use cache and finished until they are joined
+	ThreadPool pool;
+};
@@ -0,0 +1,89 @@
+/**
+*
+* View frustum as six planes, for culling axis aligned boxes on the CPU.
+* Planes are taken from the clip matrix as in "Fast Extraction of Viewing Frustum Planes from the
+* World-View-Projection Matrix", G. Gribb and K. Hartmann 2001.
+*
+**/
+
+#include "Frustum.h"
+
+#include <xmmintrin.h>
+
+/// <summary>
+/// Frustum of a clip matrix, the planes are not normalized since only their sign is used
+/// </summary>
+/// <param name="clipFromLocal">e.g. projection * view * model, the planes are then in model space</param>
+Frustum Frustum::fromMatrix(const cy::Matrix4f& clipFromLocal)
+{
+    // cy matrices are column major, row i is cell[i], cell[4 + i], cell[8 + i], cell[12 + i]
+    const float* m = clipFromLocal.cell;
+    Frustum frustum;
+    for (int i = 0; i < 3; i++) {
+        for (int c = 0; c < 4; c++) {
+            frustum.planes[2 * i][c] = m[4 * c + 3] + m[4 * c + i];        // left, bottom, near
+            frustum.planes[2 * i + 1][c] = m[4 * c + 3] - m[4 * c + i];    // right, top, far
+        }
+    }
+    return frustum;
+}
+
+/// <summary>
+/// Whether a box is at least partly inside. Conservative, boxes near a frustum corner may pass.
+/// </summary>
+bool Frustum::intersects(const cy::Vec3f& boxMin, const cy::Vec3f& boxMax) const
+{
+    for (int i = 0; i < 6; i++) {
+        const float* p = planes[i];
+        // the box corner furthest along the plane normal
+        float x = p[0] >= 0 ? boxMax.x : boxMin.x;
+        float y = p[1] >= 0 ? boxMax.y : boxMin.y;
+        float z = p[2] >= 0 ? boxMax.z : boxMin.z;
+        // summed in the same order as classify4(), so both agree on boxes touching a plane
+        if ((p[0] * x + p[1] * y) + (p[2] * z + p[3]) < 0) { return false; }
+    }
+    return true;
+}
+
+/// <summary>
+/// Test four boxes at once with SSE. Each array holds one coordinate of the four boxes.
+/// Same results as intersects() for the visible bits.
+/// </summary>
+/// <returns>which boxes are visible, and which of them need no further test since they are completely inside</returns>
+Frustum::BoxMasks Frustum::classify4(const float* minX, const float* minY, const float* minZ,
+    const float* maxX, const float* maxY, const float* maxZ) const
+{
+    __m128 lowX = _mm_loadu_ps(minX);
+    __m128 lowY = _mm_loadu_ps(minY);
+    __m128 lowZ = _mm_loadu_ps(minZ);
+    __m128 highX = _mm_loadu_ps(maxX);
+    __m128 highY = _mm_loadu_ps(maxY);
+    __m128 highZ = _mm_loadu_ps(maxZ);
+    __m128 zero = _mm_setzero_ps();
+    __m128 outside = zero;
+    __m128 crossing = zero;
+
+    for (int i = 0; i < 6; i++) {
+        const float* p = planes[i];
+        __m128 a = _mm_set1_ps(p[0]);
+        __m128 b = _mm_set1_ps(p[1]);
+        __m128 c = _mm_set1_ps(p[2]);
+        __m128 d = _mm_set1_ps(p[3]);
+        // the plane is the same for all four boxes, so the furthest and nearest corners are picked once per plane
+        __m128 farX = p[0] >= 0 ? highX : lowX;
+        __m128 farY = p[1] >= 0 ? highY : lowY;
+        __m128 farZ = p[2] >= 0 ? highZ : lowZ;
+        __m128 nearX = p[0] >= 0 ? lowX : highX;
+        __m128 nearY = p[1] >= 0 ? lowY : highY;
+        __m128 nearZ = p[2] >= 0 ? lowZ : highZ;
+        __m128 farDistance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(a, farX), _mm_mul_ps(b, farY)), _mm_add_ps(_mm_mul_ps(c, farZ), d));
+        __m128 nearDistance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(a, nearX), _mm_mul_ps(b, nearY)), _mm_add_ps(_mm_mul_ps(c, nearZ), d));
+        outside = _mm_or_ps(outside, _mm_cmplt_ps(farDistance, zero));
+        crossing = _mm_or_ps(crossing, _mm_cmplt_ps(nearDistance, zero));
+    }
+
+    BoxMasks masks;
+    masks.visible = ~(unsigned int)_mm_movemask_ps(outside) & 0xF;
+    masks.inside = masks.visible & ~(unsigned int)_mm_movemask_ps(crossing);
+    return masks;
+}
@@ -0,0 +1,33 @@
+/**
+*
+* View frustum as six planes, for culling axis aligned boxes on the CPU.
+* The planes live in whatever space the matrix they were taken from starts in,
+* e.g. projection * view * model gives planes in model space.
+*
+**/
+
+#pragma once
+
+#include "../CyCodeBase/cyVector.h"
+#include "../CyCodeBase/cyMatrix.h"
+
+class Frustum
+{
+public:
+	// result bits of classify4(), bit i is box i
+	struct BoxMasks
+	{
+		unsigned int visible;	// box is at least partly inside
+		unsigned int inside;	// box is completely inside, a subset of visible
+	};
+
+	static Frustum fromMatrix(const cy::Matrix4f& clipFromLocal);
+
+	bool intersects(const cy::Vec3f& boxMin, const cy::Vec3f& boxMax) const;
+	BoxMasks classify4(const float* minX, const float* minY, const float* minZ,
+		const float* maxX, const float* maxY, const float* maxZ) const;
+
+private:
+	// ax + by + cz + d >= 0 on the inner side, stored plane by plane
+	float planes[6][4];
+};
@@ -0,0 +1,131 @@
+/**
+*
+* Min/max height quadtree over a vertex grid, split into square patches.
+* Level 0 holds one node per patch, every level above merges 2x2 nodes of the level below.
+* Level 0 nodes also keep a roughness, how far the patch bends away from the bilinear surface through its corners.
+*
+**/
+
+#pragma once
+
+#include <vector>
+#include <algorithm>
+#include <cmath>
+
+class HeightQuadtree
+{
+public:
+	/// <summary>
+	/// Build the tree for a w x h vertex grid. Neighbouring patches share their border vertices.
+	/// </summary>
+	/// <param name="w">vertices along x</param>
+	/// <param name="h">vertices along z</param>
+	/// <param name="patchQuads">grid quads along one side of a level 0 node</param>
+	/// <param name="heightAt">callable returning the world height of vertex (x, z)</param>
+	template <class HeightAt>
+	void build(unsigned int w, unsigned int h, unsigned int patchQuads, HeightAt heightAt)
+	{
+		gridWidth = w;
+		gridLength = h;
+		leafQuads = patchQuads;
+		levels.clear();
+
+		Level leaves;
+		leaves.nodesX = (w - 1 + patchQuads - 1) / patchQuads;
+		leaves.nodesZ = (h - 1 + patchQuads - 1) / patchQuads;
+		leaves.minHeight.resize(leaves.nodesX * leaves.nodesZ);
+		leaves.maxHeight.resize(leaves.nodesX * leaves.nodesZ);
+		leafRoughness.resize(leaves.nodesX * leaves.nodesZ);
+		for (unsigned int pz = 0; pz < leaves.nodesZ; pz++) {
+			for (unsigned int px = 0; px < leaves.nodesX; px++) {
+				unsigned int xBegin = px * patchQuads;
+				unsigned int zBegin = pz * patchQuads;
+				unsigned int xEnd = std::min((px + 1) * patchQuads, w - 1);
+				unsigned int zEnd = std::min((pz + 1) * patchQuads, h - 1);
+				float corner00 = heightAt(xBegin, zBegin);
+				float corner10 = heightAt(xEnd, zBegin);
+				float corner01 = heightAt(xBegin, zEnd);
+				float corner11 = heightAt(xEnd, zEnd);
+				float low = corner00;
+				float high = corner00;
+				float deviation = 0;
+				for (unsigned int z = zBegin; z <= zEnd; z++) {
+					float v = (float)(z - zBegin) / (float)(zEnd - zBegin);
+					for (unsigned int x = xBegin; x <= xEnd; x++) {
+						float u = (float)(x - xBegin) / (float)(xEnd - xBegin);
+						float height = heightAt(x, z);
+						float bilinear = (corner00 * (1 - u) + corner10 * u) * (1 - v) + (corner01 * (1 - u) + corner11 * u) * v;
+						low = std::min(low, height);
+						high = std::max(high, height);
+						deviation = std::max(deviation, std::abs(height - bilinear));
+					}
+				}
+				leaves.minHeight[pz * leaves.nodesX + px] = low;
+				leaves.maxHeight[pz * leaves.nodesX + px] = high;
+				leafRoughness[pz * leaves.nodesX + px] = deviation;
+			}
+		}
+		levels.push_back(std::move(leaves));
+
+		// merge 2x2 nodes until a single level covers the grid with at most one node per axis
+		while (levels.back().nodesX > 1 || levels.back().nodesZ > 1) {
+			const Level& below = levels.back();
+			Level level;
+			level.nodesX = (below.nodesX + 1) / 2;
+			level.nodesZ = (below.nodesZ + 1) / 2;
+			level.minHeight.resize(level.nodesX * level.nodesZ);
+			level.maxHeight.resize(level.nodesX * level.nodesZ);
+			for (unsigned int z = 0; z < level.nodesZ; z++) {
+				for (unsigned int x = 0; x < level.nodesX; x++) {
+					float low = below.minHeight[(2 * z) * below.nodesX + 2 * x];
+					float high = below.maxHeight[(2 * z) * below.nodesX + 2 * x];
+					for (unsigned int child = 1; child < 4; child++) {
+						unsigned int cx = 2 * x + (child & 1);
+						unsigned int cz = 2 * z + (child >> 1);
+						if (cx >= below.nodesX || cz >= below.nodesZ) { continue; }
+						low = std::min(low, below.minHeight[cz * below.nodesX + cx]);
+						high = std::max(high, below.maxHeight[cz * below.nodesX + cx]);
+					}
+					level.minHeight[z * level.nodesX + x] = low;
+					level.maxHeight[z * level.nodesX + x] = high;
+				}
+			}
+			levels.push_back(std::move(level));
+		}
+	}
+
+	unsigned int levelCount() const { return (unsigned int)levels.size(); }
+	unsigned int nodesX(unsigned int level) const { return levels[level].nodesX; }
+	unsigned int nodesZ(unsigned int level) const { return levels[level].nodesZ; }
+	// grid quads along one side of a node of the level
+	unsigned int nodeQuads(unsigned int level) const { return leafQuads << level; }
+	unsigned int patchQuads() const { return leafQuads; }
+	unsigned int width() const { return gridWidth; }
+	unsigned int length() const { return gridLength; }
+
+	float minHeight(unsigned int level, unsigned int x, unsigned int z) const { return levels[level].minHeight[z * levels[level].nodesX + x]; }
+	float maxHeight(unsigned int level, unsigned int x, unsigned int z) const { return levels[level].maxHeight[z * levels[level].nodesX + x]; }
+
+	// largest height difference between a level 0 patch and the bilinear surface through its corners
+	float roughness(unsigned int x, unsigned int z) const { return leafRoughness[z * levels[0].nodesX + x]; }
+	const float* roughnesses() const { return leafRoughness.data(); }
+
+	// whole rows of a level, nodes are stored row by row
+	const float* minHeights(unsigned int level) const { return levels[level].minHeight.data(); }
+	const float* maxHeights(unsigned int level) const { return levels[level].maxHeight.data(); }
+
+private:
+	struct Level
+	{
+		unsigned int nodesX = 0;
+		unsigned int nodesZ = 0;
+		std::vector<float> minHeight;
+		std::vector<float> maxHeight;
+	};
+
+	std::vector<Level> levels;
+	std::vector<float> leafRoughness;
+	unsigned int gridWidth = 0;
+	unsigned int gridLength = 0;
+	unsigned int leafQuads = 0;
+};
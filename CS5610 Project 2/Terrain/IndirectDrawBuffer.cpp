@@ -0,0 +1,77 @@
+/**
+*
+* Draw list for glMultiDrawElementsIndirect.
+*
+**/
+
+#include "IndirectDrawBuffer.h"
+#include "../CyCodeBase/cyGL.h"
+
+/// <summary>
+/// The GL buffer is created by the first upload()
+/// </summary>
+IndirectDrawBuffer::IndirectDrawBuffer()
+{
+    buffer = 0;
+    uploaded = 0;
+}
+
+/// <summary>
+/// Free the GL buffer. A global draw list is destroyed after the context is gone, its buffer went with it.
+/// </summary>
+IndirectDrawBuffer::~IndirectDrawBuffer()
+{
+    if (buffer != 0 && cy::GL::CheckContext()) { glDeleteBuffers(1, &buffer); }
+}
+
+/// <summary>
+/// Start a new draw list, the previous upload() stays drawable until the next one
+/// </summary>
+void IndirectDrawBuffer::clear()
+{
+    commands.clear();
+}
+
+/// <summary>
+/// Append one indexed draw of a single instance
+/// </summary>
+/// <param name="count">number of indices</param>
+/// <param name="firstIndex">first index in the bound element buffer</param>
+/// <param name="baseVertex">added to every index</param>
+/// <param name="baseInstance">which element of the per instance attributes the draw reads</param>
+void IndirectDrawBuffer::add(GLuint count, GLuint firstIndex, GLint baseVertex, GLuint baseInstance)
+{
+    commands.push_back({ count, 1, firstIndex, baseVertex, baseInstance });
+}
+
+/// <summary>
+/// Copy the draw list to the GL buffer. The old storage is orphaned, so the driver
+/// does not have to wait for frames that still read it.
+/// </summary>
+void IndirectDrawBuffer::upload()
+{
+    if (buffer == 0) { glGenBuffers(1, &buffer); }
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, buffer);
+    glBufferData(GL_DRAW_INDIRECT_BUFFER, sizeof(DrawElementsIndirectCommand) * commands.size(),
+        commands.empty() ? nullptr : &commands[0], GL_STREAM_DRAW);
+    uploaded = commands.size();
+}
+
+/// <summary>
+/// Issue every uploaded command with one call, using the bound VAO and element buffer
+/// </summary>
+/// <param name="mode">primitive type, e.g. GL_PATCHES</param>
+void IndirectDrawBuffer::draw(GLenum mode) const
+{
+    if (uploaded == 0) { return; }
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, buffer);
+    glMultiDrawElementsIndirect(mode, GL_UNSIGNED_INT, (GLvoid*)0, (GLsizei)uploaded, 0);
+}
+
+/// <summary>
+/// Number of commands added since the last clear()
+/// </summary>
+size_t IndirectDrawBuffer::size() const
+{
+    return commands.size();
+}
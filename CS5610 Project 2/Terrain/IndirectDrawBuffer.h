@@ -0,0 +1,45 @@
+/**
+*
+* Draw list for glMultiDrawElementsIndirect.
+* Commands are collected on the CPU once per frame, uploaded once, and can then be drawn by any number of passes,
+* so a pass costs one GL call whatever the number of chunks in it.
+*
+**/
+
+#pragma once
+
+#include <GL/glew.h>
+#include <cstddef>
+#include <vector>
+
+// layout glMultiDrawElementsIndirect reads from GL_DRAW_INDIRECT_BUFFER
+struct DrawElementsIndirectCommand
+{
+	GLuint count;			// indices
+	GLuint instanceCount;
+	GLuint firstIndex;		// in indices, not bytes
+	GLint baseVertex;		// added to every index
+	GLuint baseInstance;	// first element of the per instance vertex attributes
+};
+
+class IndirectDrawBuffer
+{
+public:
+	IndirectDrawBuffer();
+	~IndirectDrawBuffer();
+
+	IndirectDrawBuffer(const IndirectDrawBuffer&) = delete;
+	IndirectDrawBuffer& operator=(const IndirectDrawBuffer&) = delete;
+
+	void clear();
+	void add(GLuint count, GLuint firstIndex, GLint baseVertex, GLuint baseInstance);
+	void upload();
+	void draw(GLenum mode) const;
+
+	size_t size() const;
+
+private:
+	std::vector<DrawElementsIndirectCommand> commands;
+	GLuint buffer;
+	size_t uploaded;	// commands in the GL buffer since the last upload()
+};
@@ -0,0 +1,249 @@
+/**
+*
+* Frustum culling of the patches of a HeightQuadtree.
+* The tree is walked top down and the four children of a node are tested together with Frustum::classify4(),
+* nodes completely inside the frustum are added as a whole without testing their children.
+*
+**/
+
+#include "TerrainCuller.h"
+
+#include <algorithm>
+
+namespace {
+
+// spread the low 16 bits of v to the even bits
+unsigned int spreadBits(unsigned int v)
+{
+    v &= 0xFFFF;
+    v = (v | (v << 8)) & 0x00FF00FF;
+    v = (v | (v << 4)) & 0x0F0F0F0F;
+    v = (v | (v << 2)) & 0x33333333;
+    v = (v | (v << 1)) & 0x55555555;
+    return v;
+}
+
+// x in the even bits, z in the odd bits, the four children of a node follow each other as (0, 0), (1, 0), (0, 1), (1, 1)
+unsigned int mortonCode(unsigned int x, unsigned int z)
+{
+    return spreadBits(x) | (spreadBits(z) << 1);
+}
+
+}
+
+/// <summary>
+/// Order the patches of the tree and work out the patches every node covers.
+/// The tree is kept by reference and has to outlive the culler.
+/// </summary>
+/// <param name="bounds">min/max height quadtree of the terrain</param>
+/// <param name="spacing">distance between two neighbouring grid vertices</param>
+void TerrainCuller::build(const HeightQuadtree& bounds, float spacing)
+{
+    this->bounds = &bounds;
+    this->spacing = spacing;
+
+    unsigned int nodesX = bounds.nodesX(0);
+    unsigned int nodesZ = bounds.nodesZ(0);
+    patchOrder.resize(nodesX * nodesZ);
+    for (unsigned int i = 0; i < patchOrder.size(); i++) { patchOrder[i] = i; }
+    std::sort(patchOrder.begin(), patchOrder.end(), [nodesX](unsigned int a, unsigned int b) {
+        return mortonCode(a % nodesX, a / nodesX) < mortonCode(b % nodesX, b / nodesX);
+    });
+
+    // patches at the far edges of the map are cut short, so the patch sizes are not all the same
+    unsigned int patchQuads = bounds.patchQuads();
+    patchIndexStart.resize(patchOrder.size() + 1);
+    patchIndexStart[0] = 0;
+    nodeFirstPatch.assign(bounds.levelCount(), std::vector<unsigned int>());
+    nodeEndPatch.assign(bounds.levelCount(), std::vector<unsigned int>());
+    nodeFirstPatch[0].resize(patchOrder.size());
+    nodeEndPatch[0].resize(patchOrder.size());
+    for (unsigned int rank = 0; rank < patchOrder.size(); rank++) {
+        unsigned int px = patchOrder[rank] % nodesX;
+        unsigned int pz = patchOrder[rank] / nodesX;
+        unsigned int quadsX = std::min(patchQuads, bounds.width() - 1 - px * patchQuads);
+        unsigned int quadsZ = std::min(patchQuads, bounds.length() - 1 - pz * patchQuads);
+        patchIndexStart[rank + 1] = patchIndexStart[rank] + quadsX * quadsZ * 6;
+        nodeFirstPatch[0][patchOrder[rank]] = rank;
+        nodeEndPatch[0][patchOrder[rank]] = rank + 1;
+    }
+
+    // in Morton order the patches of a node are contiguous, so a node covers the span of its children
+    for (unsigned int level = 1; level < bounds.levelCount(); level++) {
+        unsigned int levelX = bounds.nodesX(level);
+        unsigned int levelZ = bounds.nodesZ(level);
+        unsigned int belowX = bounds.nodesX(level - 1);
+        unsigned int belowZ = bounds.nodesZ(level - 1);
+        nodeFirstPatch[level].resize(levelX * levelZ);
+        nodeEndPatch[level].resize(levelX * levelZ);
+        for (unsigned int z = 0; z < levelZ; z++) {
+            for (unsigned int x = 0; x < levelX; x++) {
+                unsigned int first = ~0u;
+                unsigned int end = 0;
+                for (unsigned int child = 0; child < 4; child++) {
+                    unsigned int cx = 2 * x + (child & 1);
+                    unsigned int cz = 2 * z + (child >> 1);
+                    if (cx >= belowX || cz >= belowZ) { continue; }
+                    first = std::min(first, nodeFirstPatch[level - 1][cz * belowX + cx]);
+                    end = std::max(end, nodeEndPatch[level - 1][cz * belowX + cx]);
+                }
+                nodeFirstPatch[level][z * levelX + x] = first;
+                nodeEndPatch[level][z * levelX + x] = end;
+            }
+        }
+    }
+}
+
+/// <summary>
+/// Size of the index buffer writePatchIndices() writes, the same as Mesh::indexCount() of the terrain
+/// </summary>
+size_t TerrainCuller::indexCount() const
+{
+    return patchIndexStart.empty() ? 0 : patchIndexStart.back();
+}
+
+/// <summary>
+/// Write the grid triangles of the terrain patch by patch in drawing order.
+/// The triangles are wound like Mesh::writeGridIndices(), only their order differs.
+/// </summary>
+/// <param name="out">receives indexCount() indices</param>
+void TerrainCuller::writePatchIndices(unsigned int* out) const
+{
+    unsigned int w = bounds->width();
+    unsigned int patchQuads = bounds->patchQuads();
+    unsigned int nodesX = bounds->nodesX(0);
+    for (unsigned int rank = 0; rank < patchOrder.size(); rank++) {
+        unsigned int px = patchOrder[rank] % nodesX;
+        unsigned int pz = patchOrder[rank] / nodesX;
+        unsigned int rowEnd = std::min((pz + 1) * patchQuads, bounds->length() - 1);
+        unsigned int colEnd = std::min((px + 1) * patchQuads, w - 1);
+        unsigned int* f = out + patchIndexStart[rank];
+        for (unsigned int r = pz * patchQuads; r < rowEnd; r++) {
+            for (unsigned int c = px * patchQuads; c < colEnd; c++) {
+                *f++ = (r * w) + c + 1;
+                *f++ = ((r + 1) * w) + c;
+                *f++ = (r * w) + c;
+                *f++ = (r * w) + c + 1;
+                *f++ = ((r + 1) * w) + c + 1;
+                *f++ = ((r + 1) * w) + c;
+            }
+        }
+    }
+}
+
+/// <summary>
+/// Find the index ranges of the patches that are at least partly inside the frustum.
+/// The ranges are sorted, and ranges that touch are merged.
+/// </summary>
+/// <param name="frustum">frustum in terrain space, the same space the index buffer's vertices are in</param>
+void TerrainCuller::cull(const Frustum& frustum)
+{
+    ranges.clear();
+    visiblePatches = 0;
+    if (bounds == nullptr) { return; }
+
+    // the top level has a single node, or a single row or column of them
+    unsigned int top = bounds->levelCount() - 1;
+    for (unsigned int z = 0; z < bounds->nodesZ(top); z++) {
+        for (unsigned int x = 0; x < bounds->nodesX(top); x++) {
+            if (!frustum.intersects(nodeMin(top, x, z), nodeMax(top, x, z))) { continue; }
+            if (top == 0) { addNode(top, x, z); }
+            else { cullChildren(frustum, top, x, z); }
+        }
+    }
+}
+
+/// <summary>
+/// Recursive part of cull() for a node that crosses the frustum
+/// </summary>
+void TerrainCuller::cullChildren(const Frustum& frustum, unsigned int level, unsigned int x, unsigned int z)
+{
+    unsigned int childLevel = level - 1;
+    unsigned int belowX = bounds->nodesX(childLevel);
+    unsigned int belowZ = bounds->nodesZ(childLevel);
+
+    // the boxes of the four children, side by side for classify4()
+    // children past the map edge repeat the last existing one and are masked out afterwards
+    alignas(16) float minX[4], minY[4], minZ[4], maxX[4], maxY[4], maxZ[4];
+    const float* lowHeights = bounds->minHeights(childLevel);
+    const float* highHeights = bounds->maxHeights(childLevel);
+    unsigned int childQuads = bounds->nodeQuads(childLevel);
+    float mapMaxX = (bounds->width() - 1) * spacing;
+    float mapMaxZ = (bounds->length() - 1) * spacing;
+    unsigned int exists = 0;
+    for (unsigned int child = 0; child < 4; child++) {
+        unsigned int cx = 2 * x + (child & 1);
+        unsigned int cz = 2 * z + (child >> 1);
+        if (cx < belowX && cz < belowZ) { exists |= 1 << child; }
+        unsigned int node = std::min(cz, belowZ - 1) * belowX + std::min(cx, belowX - 1);
+        minX[child] = (float)(cx * childQuads) * spacing;
+        minZ[child] = (float)(cz * childQuads) * spacing;
+        maxX[child] = std::min((float)((cx + 1) * childQuads) * spacing, mapMaxX);
+        maxZ[child] = std::min((float)((cz + 1) * childQuads) * spacing, mapMaxZ);
+        minY[child] = lowHeights[node];
+        maxY[child] = highHeights[node];
+    }
+    Frustum::BoxMasks masks = frustum.classify4(minX, minY, minZ, maxX, maxY, maxZ);
+
+    // children in Morton order, so the ranges come out sorted
+    for (unsigned int child = 0; child < 4; child++) {
+        unsigned int bit = 1 << child;
+        if (!(exists & masks.visible & bit)) { continue; }
+        unsigned int cx = 2 * x + (child & 1);
+        unsigned int cz = 2 * z + (child >> 1);
+        if ((masks.inside & bit) || childLevel == 0) { addNode(childLevel, cx, cz); }
+        else { cullChildren(frustum, childLevel, cx, cz); }
+    }
+}
+
+/// <summary>
+/// Add the index range of every patch of a node, merged into the previous range where they touch
+/// </summary>
+void TerrainCuller::addNode(unsigned int level, unsigned int x, unsigned int z)
+{
+    unsigned int node = z * bounds->nodesX(level) + x;
+    unsigned int firstPatch = nodeFirstPatch[level][node];
+    unsigned int endPatch = nodeEndPatch[level][node];
+    visiblePatches += endPatch - firstPatch;
+
+    unsigned int first = patchIndexStart[firstPatch];
+    unsigned int count = patchIndexStart[endPatch] - first;
+    if (!ranges.empty() && ranges.back().first + ranges.back().count == first) { ranges.back().count += count; }
+    else { ranges.push_back({ first, count }); }
+}
+
+/// <summary>
+/// Lower corner of a node's box in terrain space
+/// </summary>
+cy::Vec3f TerrainCuller::nodeMin(unsigned int level, unsigned int x, unsigned int z) const
+{
+    unsigned int nodeQuads = bounds->nodeQuads(level);
+    return cy::Vec3f((float)(x * nodeQuads) * spacing, bounds->minHeight(level, x, z), (float)(z * nodeQuads) * spacing);
+}
+
+/// <summary>
+/// Upper corner of a node's box in terrain space, clipped to the map
+/// </summary>
+cy::Vec3f TerrainCuller::nodeMax(unsigned int level, unsigned int x, unsigned int z) const
+{
+    unsigned int nodeQuads = bounds->nodeQuads(level);
+    float maxX = std::min((x + 1) * nodeQuads, bounds->width() - 1) * spacing;
+    float maxZ = std::min((z + 1) * nodeQuads, bounds->length() - 1) * spacing;
+    return cy::Vec3f(maxX, bounds->maxHeight(level, x, z), maxZ);
+}
+
+/// <summary>
+/// Index ranges found by the last cull()
+/// </summary>
+const std::vector<IndexRange>& TerrainCuller::visibleRanges() const
+{
+    return ranges;
+}
+
+/// <summary>
+/// Number of patches inside the index ranges of the last cull()
+/// </summary>
+size_t TerrainCuller::visiblePatchCount() const
+{
+    return visiblePatches;
+}
@@ -0,0 +1,49 @@
+/**
+*
+* Frustum culling of the patches of a HeightQuadtree.
+* The index buffer is written patch by patch in Morton order, so the patches of every quadtree node
+* are one contiguous run of indices and a node that is completely visible is drawn as one range.
+*
+**/
+
+#pragma once
+
+#include <vector>
+#include "HeightQuadtree.h"
+#include "Frustum.h"
+
+// a run of the patch ordered index buffer, in indices
+struct IndexRange
+{
+	unsigned int first;
+	unsigned int count;
+};
+
+class TerrainCuller
+{
+public:
+	void build(const HeightQuadtree& bounds, float spacing);
+	size_t indexCount() const;
+	void writePatchIndices(unsigned int* out) const;
+
+	void cull(const Frustum& frustum);
+	const std::vector<IndexRange>& visibleRanges() const;
+	size_t visiblePatchCount() const;
+
+private:
+	void cullChildren(const Frustum& frustum, unsigned int level, unsigned int x, unsigned int z);
+	void addNode(unsigned int level, unsigned int x, unsigned int z);
+	cy::Vec3f nodeMin(unsigned int level, unsigned int x, unsigned int z) const;
+	cy::Vec3f nodeMax(unsigned int level, unsigned int x, unsigned int z) const;
+
+	const HeightQuadtree* bounds = nullptr;
+	float spacing = 0;
+	std::vector<unsigned int> patchOrder;		// level 0 node (z * nodesX + x) of every patch, in drawing order
+	std::vector<unsigned int> patchIndexStart;	// first index of every patch in drawing order, plus the total at the end
+	// per level and node, the patches [first, end) in drawing order the node covers
+	std::vector<std::vector<unsigned int>> nodeFirstPatch;
+	std::vector<std::vector<unsigned int>> nodeEndPatch;
+
+	std::vector<IndexRange> ranges;
+	size_t visiblePatches = 0;
+};
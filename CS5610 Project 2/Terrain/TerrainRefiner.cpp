@@ -0,0 +1,151 @@
+/**
+*
+* Progressive generation of a single map terrain.
+* A coarse preview is generated right away on the calling thread, the finer levels follow on a background
+* thread and are handed to the render thread one by one, so the first frame does not wait for the full map.
+* Every level goes through the tile cache, so a warm start maps the levels instead of generating them.
+*
+**/
+
+#include "TerrainRefiner.h"
+
+#include <algorithm>
+
+/// <summary>
+/// Queue the generation of every level on the background thread, coarsest first
+/// </summary>
+/// <param name="mapSize">vertices along one side of the full resolution map</param>
+/// <param name="layout">vertex layout of every level</param>
+/// <param name="steps">grid step of every level, from coarse to fine, usually ending with 1</param>
+/// <param name="referenceHeight">max height of the full resolution map, see referenceHeight(), 0 works it out when needed</param>
+/// <param name="cacheDirectory">tile cache the levels are loaded from and stored in, empty disables it</param>
+TerrainRefiner::TerrainRefiner(unsigned int mapSize, TerrainVertexLayout layout, const std::vector<unsigned int>& steps, float referenceHeight,
+    const std::string& cacheDirectory)
+    // the render thread keeps one hardware thread for itself, the worker of pool takes part in levelPool
+    : cache(cacheDirectory), levelPool(std::max(1u, ThreadPool::defaultThreadCount() - 1)), pool(2)
+{
+    finishedSize = 0;
+    remaining = (unsigned int)steps.size();
+    cancelled = false;
+
+    for (unsigned int step : steps) {
+        pool.submit([this, mapSize, layout, step, referenceHeight]() {
+            if (cancelled) { return; }
+            std::unique_ptr<Mesh> mesh(new Mesh());
+            float reference = referenceHeight;
+            generateLevel(*mesh, mapSize, layout, step, reference, levelPool, cache);
+
+            // a level that was not taken yet is replaced, the finer one is all the render thread needs
+            std::lock_guard<std::mutex> lock(finishedMutex);
+            if (finished) { remaining--; }
+            finished = std::move(mesh);
+            finishedSize = levelSize(mapSize, step);
+        });
+    }
+}
+
+/// <summary>
+/// Skip the levels that did not start yet and wait for the one in progress
+/// </summary>
+TerrainRefiner::~TerrainRefiner()
+{
+    // queued jobs still run when the pool is destroyed, this makes them return right away
+    cancelled = true;
+}
+
+/// <summary>
+/// Hand the newest finished level to the caller, never waits for generation
+/// </summary>
+/// <param name="mesh">receives the level</param>
+/// <param name="gridSize">receives the vertices along one side of the level</param>
+/// <returns>false if no new level finished since the last call</returns>
+bool TerrainRefiner::takeFinished(Mesh& mesh, unsigned int& gridSize)
+{
+    std::lock_guard<std::mutex> lock(finishedMutex);
+    if (!finished) { return false; }
+    mesh = std::move(*finished);
+    gridSize = finishedSize;
+    finished.reset();
+    remaining--;
+    return true;
+}
+
+/// <summary>
+/// Whether a finer level is still being generated or waiting to be taken
+/// </summary>
+bool TerrainRefiner::pending() const
+{
+    return remaining > 0;
+}
+
+/// <summary>
+/// Generate the map with only every step-th grid vertex. Every level spans the same noise as the full
+/// resolution map and shares its lake level and colour bands. A level may reach up to one coarse quad past
+/// the far edges of the map, so the map is placed by mapWidth() rather than by the width of the level.
+/// Levels in the packed and heightmap layouts are loaded from the cache if they are in it, and stored otherwise.
+/// </summary>
+/// <param name="mesh">receives the level</param>
+/// <param name="mapSize">vertices along one side of the full resolution map</param>
+/// <param name="layout">vertex layout of the level</param>
+/// <param name="step">grid step, 1 is the full resolution map</param>
+/// <param name="referenceHeight">max height of the full resolution map, see referenceHeight(). If 0 it is taken from
+/// the cached level, or worked out before generating, and handed back for the other levels.</param>
+/// <param name="pool">threads to generate with</param>
+/// <param name="cache">tile cache of the levels</param>
+/// <returns>true if the level was loaded from the cache</returns>
+bool TerrainRefiner::generateLevel(Mesh& mesh, unsigned int mapSize, TerrainVertexLayout layout, unsigned int step, float& referenceHeight,
+    ThreadPool& pool, TileCache& cache)
+{
+    // the same noise scale as Mesh::generateVertices(mapSize, mapSize), whatever the level size
+    TerrainParams params;
+    params.noiseScale = (float)mapSize;
+    params.step = step;
+    unsigned int size = levelSize(mapSize, step);
+    mesh.setVertexLayout(layout);
+
+    // the reference height follows from the other parameters, so it is left out of the key
+    uint64_t key = TileCache::tileKey(params, size, size, layout);
+    CachedTile cached;
+    if (cache.load(key, size, size, layout, cached) && (referenceHeight == 0 || cached.header().maxHeight == referenceHeight)) {
+        const TileCacheHeader& header = cached.header();
+        mesh.loadRegion(size, size, header.spacing, header.heightOffset, header.heightScale, header.maxHeight,
+            cached.vertices(), cached.heightmap());
+        referenceHeight = header.maxHeight;
+        return true;
+    }
+
+    if (referenceHeight == 0) { referenceHeight = TerrainRefiner::referenceHeight(mapSize, pool); }
+    params.referenceHeight = referenceHeight;
+    mesh.generateRegion(size, size, params, pool);
+    cache.store(key, mesh, size, size);
+    return false;
+}
+
+/// <summary>
+/// Max height of the full resolution map, which every level uses as its reference height.
+/// Only samples the noise, so it is cheap enough to work out before the first preview.
+/// </summary>
+/// <param name="mapSize">vertices along one side of the full resolution map</param>
+/// <param name="pool">threads to measure with</param>
+float TerrainRefiner::referenceHeight(unsigned int mapSize, ThreadPool& pool)
+{
+    TerrainParams params;
+    params.noiseScale = (float)mapSize;
+    return Mesh().measureMaxHeight(mapSize, mapSize, params, pool);
+}
+
+/// <summary>
+/// Vertices along one side of a level, rounded up so the level covers the whole map
+/// </summary>
+unsigned int TerrainRefiner::levelSize(unsigned int mapSize, unsigned int step)
+{
+    return (mapSize - 1 + step - 1) / step + 1;
+}
+
+/// <summary>
+/// World width of the full resolution map, the same for every level
+/// </summary>
+float TerrainRefiner::mapWidth(unsigned int mapSize)
+{
+    return TerrainParams().spacing * (mapSize - 1);
+}
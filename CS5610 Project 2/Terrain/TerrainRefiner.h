@@ -0,0 +1,49 @@
+/**
+*
+* Progressive generation of a single map terrain.
+* A coarse preview is generated right away on the calling thread, the finer levels follow on a background
+* thread and are handed to the render thread one by one, so the first frame does not wait for the full map.
+* Every level goes through the tile cache, so a warm start maps the levels instead of generating them.
+*
+**/
+
+#pragma once
+
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <string>
+#include "../Mesh/Mesh.h"
+#include "../Threading/ThreadPool.h"
+#include "TileCache.h"
+
+class TerrainRefiner
+{
+public:
+	TerrainRefiner(unsigned int mapSize, TerrainVertexLayout layout, const std::vector<unsigned int>& steps, float referenceHeight,
+		const std::string& cacheDirectory);
+	~TerrainRefiner();
+
+	TerrainRefiner(const TerrainRefiner&) = delete;
+	TerrainRefiner& operator=(const TerrainRefiner&) = delete;
+
+	bool takeFinished(Mesh& mesh, unsigned int& gridSize);
+	bool pending() const;
+
+	static bool generateLevel(Mesh& mesh, unsigned int mapSize, TerrainVertexLayout layout, unsigned int step, float& referenceHeight,
+		ThreadPool& pool, TileCache& cache);
+	static float referenceHeight(unsigned int mapSize, ThreadPool& pool);
+	static unsigned int levelSize(unsigned int mapSize, unsigned int step);
+	static float mapWidth(unsigned int mapSize);
+
+private:
+	std::unique_ptr<Mesh> finished;		// the finest level that is done and not taken yet
+	unsigned int finishedSize;
+	std::mutex finishedMutex;
+	std::atomic<unsigned int> remaining;	// levels not taken yet, including the one in finished
+	std::atomic<bool> cancelled;
+	TileCache cache;
+	ThreadPool levelPool;				// splits each level across cores, has to outlive pool
+	ThreadPool pool;					// one worker, so the levels are generated in order
+};
@@ -0,0 +1,328 @@
+/**
+*
+* On-disk cache of generated terrain tiles, one file per tile.
+* A file is a 64 byte header followed by the PackedTerrainVertex array (or the quantized heights of the
+* heightmap layout) at a 64 byte aligned offset, so a cached tile is memory mapped and uploaded as is
+* instead of being regenerated. Streamed tiles and the levels of TerrainRefiner are cached, Float meshes are not.
+* Files are written in the native byte order, the cache is not meant to be shared between machines.
+*
+**/
+
+#include "TileCache.h"
+#include "../Noise/PerlinNoise.h"
+#include "../Noise/NoiseEngine.h"
+
+#include <string.h>
+#include <stdio.h>
+#include <fstream>
+#include <filesystem>
+#include <system_error>
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+CachedTile::CachedTile()
+{
+    data = nullptr;
+    size = 0;
+}
+
+CachedTile::~CachedTile()
+{
+    unmap();
+}
+
+CachedTile::CachedTile(CachedTile&& other) noexcept
+{
+    data = other.data;
+    size = other.size;
+    other.data = nullptr;
+    other.size = 0;
+}
+
+CachedTile& CachedTile::operator=(CachedTile&& other) noexcept
+{
+    if (this != &other) {
+        unmap();
+        data = other.data;
+        size = other.size;
+        other.data = nullptr;
+        other.size = 0;
+    }
+    return *this;
+}
+
+/// <summary>
+/// True while a tile file is mapped
+/// </summary>
+bool CachedTile::isMapped() const
+{
+    return data != nullptr;
+}
+
+/// <summary>
+/// Header of the mapped tile, only valid while isMapped()
+/// </summary>
+const TileCacheHeader& CachedTile::header() const
+{
+    return *(const TileCacheHeader*)data;
+}
+
+/// <summary>
+/// Vertices of the mapped tile, pointing straight into the mapped file, empty unless it has the packed layout
+/// </summary>
+std::span<const PackedTerrainVertex> CachedTile::vertices() const
+{
+    if (data == nullptr || header().layout != (uint32_t)TerrainVertexLayout::Packed) { return std::span<const PackedTerrainVertex>(); }
+    return std::span<const PackedTerrainVertex>((const PackedTerrainVertex*)(data + header().vertexOffset), header().vertexCount);
+}
+
+/// <summary>
+/// Quantized heights of the mapped tile, pointing straight into the mapped file, empty unless it has the heightmap layout
+/// </summary>
+std::span<const unsigned short> CachedTile::heightmap() const
+{
+    if (data == nullptr || header().layout != (uint32_t)TerrainVertexLayout::Heightmap) { return std::span<const unsigned short>(); }
+    return std::span<const unsigned short>((const unsigned short*)(data + header().vertexOffset), header().vertexCount);
+}
+
+/// <summary>
+/// Bytes per vertex array entry of a layout the cache can store, 0 for the others
+/// </summary>
+static size_t entrySize(TerrainVertexLayout layout)
+{
+    switch (layout) {
+    case TerrainVertexLayout::Packed: return sizeof(PackedTerrainVertex);
+    case TerrainVertexLayout::Heightmap: return sizeof(unsigned short);
+    default: return 0;
+    }
+}
+
+/// <summary>
+/// Map a whole file read-only. The file itself is closed again right away, the mapping keeps it alive.
+/// </summary>
+/// <param name="path">file to map</param>
+/// <returns>false if the file does not exist or cannot be mapped</returns>
+bool CachedTile::map(const std::string& path)
+{
+    unmap();
+#if defined(_WIN32)
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, nullptr,
+        OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) { return false; }
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0) {
+        CloseHandle(file);
+        return false;
+    }
+    HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    CloseHandle(file);
+    if (mapping == nullptr) { return false; }
+    void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    CloseHandle(mapping);
+    if (view == nullptr) { return false; }
+    data = (const unsigned char*)view;
+    size = (size_t)fileSize.QuadPart;
+#else
+    int file = open(path.c_str(), O_RDONLY);
+    if (file < 0) { return false; }
+    struct stat info;
+    if (fstat(file, &info) != 0 || info.st_size == 0) {
+        close(file);
+        return false;
+    }
+    void* view = mmap(nullptr, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+    close(file);
+    if (view == MAP_FAILED) { return false; }
+    data = (const unsigned char*)view;
+    size = (size_t)info.st_size;
+#endif
+    return true;
+}
+
+/// <summary>
+/// Release the mapping, if any
+/// </summary>
+void CachedTile::unmap()
+{
+    if (data == nullptr) { return; }
+#if defined(_WIN32)
+    UnmapViewOfFile(data);
+#else
+    munmap((void*)data, size);
+#endif
+    data = nullptr;
+    size = 0;
+}
+
+/// <summary>
+/// Open (and create if needed) a cache directory
+/// </summary>
+/// <param name="directory">directory the tile files live in, an empty string disables the cache</param>
+TileCache::TileCache(const std::string& directory)
+{
+    this->directory = directory;
+    tempCounter = 0;
+    std::error_code error;
+    enabled = !directory.empty() && (std::filesystem::create_directories(directory, error) || std::filesystem::is_directory(directory, error));
+}
+
+/// <summary>
+/// False if the cache is disabled or its directory could not be created
+/// </summary>
+bool TileCache::isEnabled() const
+{
+    return enabled;
+}
+
+/// <summary>
+/// Map a cached tile. Files of another format version, with a different key or of the wrong size are
+/// stale and deleted, so they get regenerated and stored again.
+/// </summary>
+/// <param name="key">tileKey() of the wanted tile</param>
+/// <param name="w">expected vertices along x</param>
+/// <param name="h">expected vertices along z</param>
+/// <param name="layout">expected layout, Packed or Heightmap</param>
+/// <param name="tile">receives the mapping</param>
+/// <returns>true on a cache hit</returns>
+bool TileCache::load(uint64_t key, unsigned int w, unsigned int h, TerrainVertexLayout layout, CachedTile& tile)
+{
+    if (!enabled || entrySize(layout) == 0) { return false; }
+    std::string path = tilePath(key);
+    if (!tile.map(path)) { return false; }
+
+    bool valid = tile.size >= sizeof(TileCacheHeader);
+    if (valid) {
+        const TileCacheHeader& header = tile.header();
+        valid = memcmp(header.magic, "TILE", 4) == 0 &&
+            header.version == formatVersion &&
+            header.key == key &&
+            header.width == w && header.height == h &&
+            header.vertexCount == w * h &&
+            header.layout == (uint32_t)layout &&
+            header.vertexOffset % 64 == 0 &&
+            (size_t)header.vertexOffset + (size_t)header.vertexCount * entrySize(layout) <= tile.size;
+    }
+    if (!valid) {
+        tile.unmap();
+        std::error_code error;
+        std::filesystem::remove(path, error);
+    }
+    return valid;
+}
+
+/// <summary>
+/// Write a tile generated with the packed or heightmap layout. The file is written under a temporary name and
+/// renamed when complete, so a tile is never read half written, even when two threads store the same tile.
+/// </summary>
+/// <param name="key">tileKey() of the parameters the mesh was generated with</param>
+/// <param name="mesh">generated tile</param>
+/// <param name="w">vertices along x</param>
+/// <param name="h">vertices along z</param>
+/// <returns>false if the tile could not be written, the cache is only an optimisation so this can be ignored</returns>
+bool TileCache::store(uint64_t key, const Mesh& mesh, unsigned int w, unsigned int h)
+{
+    TerrainVertexLayout layout = mesh.getVertexLayout();
+    std::span<const std::byte> vertices = layout == TerrainVertexLayout::Heightmap
+        ? std::as_bytes(mesh.viewHeightmap()) : std::as_bytes(mesh.viewPackedVertices());
+    if (!enabled || entrySize(layout) == 0 || vertices.size() != (size_t)w * h * entrySize(layout)) { return false; }
+
+    TileCacheHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, "TILE", 4);
+    header.version = formatVersion;
+    header.key = key;
+    header.width = w;
+    header.height = h;
+    header.vertexOffset = sizeof(TileCacheHeader);
+    header.vertexCount = w * h;
+    header.layout = (uint32_t)layout;
+    header.spacing = mesh.getSpacing();
+    header.heightOffset = mesh.getPackedHeightOffset();
+    header.heightScale = mesh.getPackedHeightScale();
+    header.maxHeight = mesh.getMaxHeight();
+
+    std::string path = tilePath(key);
+    std::string tempPath = path + ".tmp" + std::to_string(tempCounter++);
+    {
+        std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+        file.write((const char*)&header, sizeof(header));
+        file.write((const char*)vertices.data(), vertices.size_bytes());
+        if (!file) {
+            file.close();
+            std::error_code error;
+            std::filesystem::remove(tempPath, error);
+            return false;
+        }
+    }
+    std::error_code error;
+    std::filesystem::rename(tempPath, path, error);
+    if (error) {
+        std::filesystem::remove(tempPath, error);
+        return false;
+    }
+    return true;
+}
+
+/// <summary>
+/// Hash (64 bit FNV-1a) of everything a tile depends on: the noise parameters and the tile position and size.
+/// Any change to one of them gives the tile a new file. The format version is left out on purpose, so a file
+/// of an older version is found, recognised as stale by load() and replaced.
+/// </summary>
+/// <param name="params">parameters the tile is generated with, including its origin</param>
+/// <param name="w">vertices along x</param>
+/// <param name="h">vertices along z</param>
+/// <param name="layout">layout the tile is stored in</param>
+/// <returns>key of the tile</returns>
+uint64_t TileCache::tileKey(const TerrainParams& params, unsigned int w, unsigned int h, TerrainVertexLayout layout)
+{
+    uint64_t hash = 14695981039346656037ull;
+    auto add = [&hash](const void* value, size_t bytes) {
+        const unsigned char* b = (const unsigned char*)value;
+        for (size_t i = 0; i < bytes; i++) {
+            hash ^= b[i];
+            hash *= 1099511628211ull;
+        }
+    };
+    // field by field, so padding bytes of the struct never end up in the key
+    add(&w, sizeof(w));
+    add(&h, sizeof(h));
+    add(&params.originX, sizeof(params.originX));
+    add(&params.originZ, sizeof(params.originZ));
+    add(&params.noiseScale, sizeof(params.noiseScale));
+    add(&params.referenceHeight, sizeof(params.referenceHeight));
+    add(&params.octaves, sizeof(params.octaves));
+    add(&params.persistence, sizeof(params.persistence));
+    add(&params.frequency, sizeof(params.frequency));
+    add(&params.amplitude, sizeof(params.amplitude));
+    add(&params.spacing, sizeof(params.spacing));
+    // full resolution tiles keep the keys they had before coarse steps existed
+    if (params.step != 1) { add(&params.step, sizeof(params.step)); }
+    // and packed tiles the keys they had before other layouts were cached
+    if (layout != TerrainVertexLayout::Packed) { add(&layout, sizeof(layout)); }
+    // the noise hashing is global rather than per tile, but changes the heights all the same
+    PerlinNoise::Hashing hashing = PerlinNoise::hashing();
+    if (hashing != PerlinNoise::Hashing::Permutation) { add(&hashing, sizeof(hashing)); }
+    // so is the engine, Perlin tiles keep the keys they had before engines existed
+    const NoiseEngine& engine = NoiseEngine::active();
+    if (&engine != &NoiseEngine::perlin()) { add(engine.name(), strlen(engine.name())); }
+    return hash;
+}
+
+/// <summary>
+/// File of a tile in the cache directory
+/// </summary>
+std::string TileCache::tilePath(uint64_t key) const
+{
+    char name[32];
+    snprintf(name, sizeof(name), "%016llx.tile", (unsigned long long)key);
+    return (std::filesystem::path(directory) / name).string();
+}
@@ -0,0 +1,86 @@
+/**
+*
+* On-disk cache of generated terrain tiles, one file per tile.
+* A file is a 64 byte header followed by the PackedTerrainVertex array (or the quantized heights of the
+* heightmap layout) at a 64 byte aligned offset, so a cached tile is memory mapped and uploaded as is
+* instead of being regenerated. Streamed tiles and the levels of TerrainRefiner are cached, Float meshes are not.
+* Files are written in the native byte order, the cache is not meant to be shared between machines.
+*
+**/
+
+#pragma once
+
+#include <string>
+#include <atomic>
+#include <span>
+#include <stdint.h>
+#include "../Mesh/Mesh.h"
+
+struct TileCacheHeader
+{
+	char magic[4];				// "TILE"
+	uint32_t version;			// TileCache::formatVersion, files of other versions are deleted
+	uint64_t key;				// TileCache::tileKey() of the parameters the tile was generated with
+	uint32_t width;				// vertices along x
+	uint32_t height;			// vertices along z
+	uint32_t vertexOffset;		// byte offset of the PackedTerrainVertex array from the start of the file
+	uint32_t vertexCount;		// entries of the vertex array, one per grid vertex
+	uint32_t layout;			// TerrainVertexLayout of the vertex array, Packed or Heightmap
+	float spacing;				// Mesh::getSpacing()
+	float heightOffset;			// Mesh::getPackedHeightOffset()
+	float heightScale;			// Mesh::getPackedHeightScale()
+	float maxHeight;			// Mesh::getMaxHeight()
+	uint8_t reserved[12];
+};
+static_assert(sizeof(TileCacheHeader) == 64, "the vertex array has to start cache line aligned");
+
+// Read-only memory mapping of one cached tile, unmapped when destroyed
+class CachedTile
+{
+public:
+	CachedTile();
+	~CachedTile();
+
+	CachedTile(const CachedTile&) = delete;
+	CachedTile& operator=(const CachedTile&) = delete;
+	CachedTile(CachedTile&& other) noexcept;
+	CachedTile& operator=(CachedTile&& other) noexcept;
+
+	bool isMapped() const;
+	const TileCacheHeader& header() const;
+	std::span<const PackedTerrainVertex> vertices() const;
+	std::span<const unsigned short> heightmap() const;
+
+private:
+	friend class TileCache;
+	bool map(const std::string& path);
+	void unmap();
+
+	const unsigned char* data;
+	size_t size;
+};
+
+class TileCache
+{
+public:
+	// 2: octaves summed by the FbmNoise kernels, whose heights can differ from version 1 in the last bit
+	// 3: Perlin terrain sampled by PerlinGridSampler, which rounds differently again
+	// 4: tiles at negative origins were generated at wrapped coordinates, see Mesh::generateRegion()
+	// 5: the header records the layout, heightmap tiles store their quantized heights
+	static const uint32_t formatVersion = 5;
+
+	explicit TileCache(const std::string& directory);
+
+	bool isEnabled() const;
+	bool load(uint64_t key, unsigned int w, unsigned int h, TerrainVertexLayout layout, CachedTile& tile);
+	bool store(uint64_t key, const Mesh& mesh, unsigned int w, unsigned int h);
+
+	static uint64_t tileKey(const TerrainParams& params, unsigned int w, unsigned int h, TerrainVertexLayout layout);
+
+private:
+	std::string tilePath(uint64_t key) const;
+
+	std::string directory;
+	bool enabled;
+	std::atomic<unsigned int> tempCounter;
+};
@@ -0,0 +1,97 @@
+/**
+*
+* Bounded lock-free multi-producer multi-consumer queue, used to hand finished work from worker
+* threads back to the render thread without taking a lock.
+* Based on Dmitry Vyukov's bounded MPMC queue:
+* https://www.1024cores.net/home/lock-free-algorithms/queues/bounded-mpmc-queue
+*
+**/
+
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <utility>
+#include <stddef.h>
+
+template <class T>
+class LockFreeQueue
+{
+public:
+	// capacity is rounded up to a power of two
+	explicit LockFreeQueue(size_t capacity)
+	{
+		size_t size = 2;
+		while (size < capacity) { size *= 2; }
+		mask = size - 1;
+		cells.reset(new Cell[size]);
+		for (size_t i = 0; i < size; i++)
+		{
+			cells[i].sequence.store(i, std::memory_order_relaxed);
+		}
+		enqueuePos.store(0, std::memory_order_relaxed);
+		dequeuePos.store(0, std::memory_order_relaxed);
+	}
+
+	LockFreeQueue(const LockFreeQueue&) = delete;
+	LockFreeQueue& operator=(const LockFreeQueue&) = delete;
+
+	// moves value into the queue, returns false (and leaves value alone) when the queue is full
+	bool tryPush(T&& value)
+	{
+		size_t pos = enqueuePos.load(std::memory_order_relaxed);
+		Cell* cell;
+		while (true)
+		{
+			cell = &cells[pos & mask];
+			size_t sequence = cell->sequence.load(std::memory_order_acquire);
+			ptrdiff_t diff = (ptrdiff_t)sequence - (ptrdiff_t)pos;
+			if (diff == 0)
+			{
+				if (enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) { break; }
+			}
+			else if (diff < 0) { return false; }
+			else { pos = enqueuePos.load(std::memory_order_relaxed); }
+		}
+		cell->value = std::move(value);
+		cell->sequence.store(pos + 1, std::memory_order_release);
+		return true;
+	}
+
+	// moves the oldest value out of the queue, returns false when the queue is empty
+	bool tryPop(T& value)
+	{
+		size_t pos = dequeuePos.load(std::memory_order_relaxed);
+		Cell* cell;
+		while (true)
+		{
+			cell = &cells[pos & mask];
+			size_t sequence = cell->sequence.load(std::memory_order_acquire);
+			ptrdiff_t diff = (ptrdiff_t)sequence - (ptrdiff_t)(pos + 1);
+			if (diff == 0)
+			{
+				if (dequeuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) { break; }
+			}
+			else if (diff < 0) { return false; }
+			else { pos = dequeuePos.load(std::memory_order_relaxed); }
+		}
+		value = std::move(cell->value);
+		cell->sequence.store(pos + mask + 1, std::memory_order_release);
+		return true;
+	}
+
+	size_t capacity() const { return mask + 1; }
+
+private:
+	struct Cell
+	{
+		std::atomic<size_t> sequence;
+		T value;
+	};
+
+	std::unique_ptr<Cell[]> cells;
+	size_t mask;
+	// producers and consumers each get their own cache line
+	alignas(64) std::atomic<size_t> enqueuePos;
+	alignas(64) std::atomic<size_t> dequeuePos;
+};
@@ -0,0 +1,168 @@
+/**
+*
+* Small fixed-size thread pool used to split terrain generation work across cores.
+*
+**/
+
+#include "ThreadPool.h"
+
+#include <atomic>
+#include <memory>
+#include <algorithm>
+
+/// <summary>
+/// Create a pool that runs work on threadCount threads in total.
+/// The thread calling parallelFor() always takes part, so only threadCount - 1 workers are spawned.
+/// </summary>
+/// <param name="threadCount">total number of threads to use, 0 picks one per hardware thread</param>
+ThreadPool::ThreadPool(unsigned int threadCount)
+{
+    stopping = false;
+    this->threadCount = threadCount == 0 ? defaultThreadCount() : threadCount;
+    workers.reserve(this->threadCount - 1);
+    for (unsigned int i = 1; i < this->threadCount; i++)
+    {
+        workers.emplace_back(&ThreadPool::workerLoop, this);
+    }
+}
+
+/// <summary>
+/// Finish any queued jobs and join the worker threads
+/// </summary>
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(jobsMutex);
+        stopping = true;
+    }
+    jobsReady.notify_all();
+    for (std::thread& worker : workers)
+    {
+        worker.join();
+    }
+}
+
+/// <summary>
+/// Number of threads (including the calling thread) that share the work
+/// </summary>
+/// <returns>thread count of the pool</returns>
+unsigned int ThreadPool::size() const
+{
+    return threadCount;
+}
+
+/// <summary>
+/// Number of hardware threads, falling back to 1 when the platform cannot report it
+/// </summary>
+/// <returns>default thread count for a new pool</returns>
+unsigned int ThreadPool::defaultThreadCount()
+{
+    unsigned int hardwareThreads = std::thread::hardware_concurrency();
+    return hardwareThreads == 0 ? 1 : hardwareThreads;
+}
+
+/// <summary>
+/// Run body over the range [0, count) split into contiguous bands, and block until every band is done.
+/// Bands are handed out dynamically so uneven bands do not stall the other threads.
+/// The body must only write to the part of its output owned by [begin, end) for the result to be
+/// independent of the thread count.
+/// </summary>
+/// <param name="count">number of items (e.g. grid rows) to process</param>
+/// <param name="body">function called with the [begin, end) range of one band</param>
+void ThreadPool::parallelFor(size_t count, const std::function<void(size_t begin, size_t end)>& body)
+{
+    if (count == 0) { return; }
+    if (threadCount == 1 || count == 1)
+    {
+        body(0, count);
+        return;
+    }
+
+    // a few bands per thread keeps every core busy when rows take different amounts of time
+    size_t bandCount = std::min(count, (size_t)threadCount * 4);
+    size_t bandSize = (count + bandCount - 1) / bandCount;
+    bandCount = (count + bandSize - 1) / bandSize;
+
+    // shared with the helper jobs, which may outlive this call if they start after all bands are claimed
+    struct BandState
+    {
+        std::atomic<size_t> nextBand{ 0 };
+        std::atomic<size_t> bandsLeft{ 0 };
+        std::mutex doneMutex;
+        std::condition_variable done;
+    };
+    std::shared_ptr<BandState> state = std::make_shared<BandState>();
+    state->bandsLeft = bandCount;
+
+    auto runBands = [state, &body, count, bandCount, bandSize]()
+    {
+        for (size_t band = state->nextBand++; band < bandCount; band = state->nextBand++)
+        {
+            size_t begin = band * bandSize;
+            body(begin, std::min(begin + bandSize, count));
+            if (--state->bandsLeft == 0)
+            {
+                std::lock_guard<std::mutex> lock(state->doneMutex);
+                state->done.notify_all();
+            }
+        }
+    };
+
+    unsigned int helpers = (unsigned int)std::min((size_t)workers.size(), bandCount - 1);
+    for (unsigned int i = 0; i < helpers; i++)
+    {
+        enqueue(runBands);
+    }
+    runBands();
+
+    std::unique_lock<std::mutex> lock(state->doneMutex);
+    state->done.wait(lock, [&state]() { return state->bandsLeft == 0; });
+}
+
+/// <summary>
+/// Run a job in the background without waiting for it, e.g. to generate terrain while rendering.
+/// A pool of size 1 has no workers, so the job runs right away on the calling thread.
+/// Jobs still queued when the pool is destroyed are run before the workers are joined.
+/// </summary>
+/// <param name="job">function to run on a worker thread</param>
+void ThreadPool::submit(std::function<void()> job)
+{
+    if (workers.empty())
+    {
+        job();
+        return;
+    }
+    enqueue(std::move(job));
+}
+
+/// <summary>
+/// Queue a job for the next free worker
+/// </summary>
+/// <param name="job">function to run on a worker thread</param>
+void ThreadPool::enqueue(std::function<void()> job)
+{
+    {
+        std::lock_guard<std::mutex> lock(jobsMutex);
+        jobs.push_back(std::move(job));
+    }
+    jobsReady.notify_one();
+}
+
+/// <summary>
+/// Worker thread body - runs queued jobs until the pool is destroyed
+/// </summary>
+void ThreadPool::workerLoop()
+{
+    while (true)
+    {
+        std::function<void()> job;
+        {
+            std::unique_lock<std::mutex> lock(jobsMutex);
+            jobsReady.wait(lock, [this]() { return stopping || !jobs.empty(); });
+            if (jobs.empty()) { return; }
+            job = std::move(jobs.front());
+            jobs.pop_front();
+        }
+        job();
+    }
+}
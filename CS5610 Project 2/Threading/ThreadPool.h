@@ -0,0 +1,41 @@
+/**
+*
+* Small fixed-size thread pool used to split terrain generation work across cores.
+*
+**/
+
+#pragma once
+
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+
+class ThreadPool
+{
+public:
+	explicit ThreadPool(unsigned int threadCount = 0);
+	~ThreadPool();
+
+	ThreadPool(const ThreadPool&) = delete;
+	ThreadPool& operator=(const ThreadPool&) = delete;
+
+	unsigned int size() const;
+	void parallelFor(size_t count, const std::function<void(size_t begin, size_t end)>& body);
+	void submit(std::function<void()> job);
+
+	static unsigned int defaultThreadCount();
+
+private:
+	void workerLoop();
+	void enqueue(std::function<void()> job);
+
+	std::vector<std::thread> workers;
+	std::deque<std::function<void()>> jobs;
+	std::mutex jobsMutex;
+	std::condition_variable jobsReady;
+	bool stopping;
+	unsigned int threadCount;
+};